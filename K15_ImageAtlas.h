@@ -34,7 +34,12 @@ K15 Image Atlas v 1.0
 		(This is used to determine how much memory needs to be allocated)
 
 	Function(s) used:
-	K15_IACreateAtlas / K15_IACreateAtlasWithCustomMemory
+	K15_IACreateAtlas / K15_IACreateAtlasWithCustomMemory / K15_IACreateAtlasWithAllocator
+
+	Note:	If you already know roughly how many pixels you're going to add, call
+			K15_IASetAtlasSizeHint right after creating the atlas. The atlas will
+			then start with a fitting size instead of growing from 
+			K15_IA_DEFAULT_MIN_ATLAS_DIMENSION.
 
 	Note: 	This will trigger an allocation (the only one in this library)
 			if K15_IACreateAtlas is used. If this is not the desired behavior,
@@ -42,6 +47,11 @@ K15 Image Atlas v 1.0
 			least the size of N bytes where N is an integer value returned by
 			the function K15_IACalculateAtlasMemorySizeInBytes .
 
+	Note:	K15_IACreateAtlasWithAllocator creates an atlas whose book-keeping
+			memory (images, skylines and wasted space rects) grows on demand
+			using the realloc callback you provide. These atlases are not limited
+			by K15_IA_MAX_SKYLINES and K15_IA_MAX_WASTED_SPACE_RECTS.
+
 
 	2. 	You start adding images to populate the atlas. The library
 		will directly place the image at it's respected place according
@@ -49,24 +59,63 @@ K15 Image Atlas v 1.0
 		image has been placed to the caller.
 
 	Function(s) used:
-	K15_IAAddImageToAtlas
+	K15_IAAddImageToAtlas / K15_IAAddImagesToAtlas
 
 	Note: 	K15_IAAddImageToAtlas does take a pixel format paramter to later
 			determine if pixel conversion needs to happen when you want to
 			get a copy of the image atlas.
 
+	Note:	Use K15_IAAddImageToAtlasWithHandle if you want to remove the image 
+			later on using K15_IARemoveImageFromAtlas. The area of removed images
+			will be reused for new images. K15_IARepackAtlas places all remaining
+			images again if the atlas got too fragmented.
+
+	Note:	Call K15_IASetAtlasPacker right after creating the atlas to place
+			the images using MaxRects, Guillotine or Shelf packing instead of
+			the default skyline packer.
+
+	Note:	Call K15_IASetAtlasImageRotation to allow the atlas to rotate images 
+			by 90 degrees if they fit better that way (check K15_IAGetImageRotation
+			when calculating the texture coordinates of an image).
+
+	Note:	Call K15_IASetAtlasPadding to reserve some space around each image.
+			The edge pixels of each image will be repeated into that space
+			during baking, so neighbouring images don't bleed into each other
+			when the atlas gets filtered.
+
+	Note:	Call K15_IASetAtlasAlignment(atlas, 4) before adding images if you 
+			want to bake the atlas into a block compressed pixel format 
+			(KIA_PIXEL_FORMAT_BC1/BC3/BC4/BC5). Otherwise, blocks that are shared
+			by several images have to be gathered from all of them, which is 
+			slower and mixes the colors of these images in one block.
+
 
 	3.	After you added all the images to the atlas, you can 'bake' the atlas
 		and get a copy of the pixel data of the finished image atlas.
 
 	Function(s) used:
-	K15_IABakeImageAtlasIntoPixelBuffer
+	K15_IABakeImageAtlasIntoPixelBuffer / K15_IABakeImageAtlasIntoPixelBufferParallel
 
 	Note: 	K15_IABakeImageAtlasIntoPixelBuffer does take a pixel format paramater.
 			Pixel format conversion will happen on the fly if the pixel format
 			specified differs from that of individual images (that got added
-			by using K15_IAAddImageToAtlas). Currently, the atlas
-			will only grow by power of two dimensions.
+			by using K15_IAAddImageToAtlas). By default, the atlas
+			will only grow by power of two dimensions (see K15_IASetAtlasGrowStep).
+
+	Note:	Call K15_IAShrinkAtlasToFit before baking to cut off the unused
+			area of the atlas.
+
+	Note:	If you keep adding images to an atlas that has already been baked,
+			K15_IABakeDirtyImagesIntoPixelBuffer only bakes the new images into
+			the existing pixel buffer and tells you which areas changed.
+
+	Note:	K15_IABakeImageAtlasMipChainIntoPixelBuffer also creates the mip
+			levels of the atlas. Each image gets downsampled on its own, so
+			images don't bleed into each other in the smaller mip levels.
+
+	Note:	K15_IABakeImageAtlasIntoBands bakes the atlas in bands of a few rows
+			into a small buffer and passes each band to your callback, so big
+			atlases never have to be in memory completely.
 
 	4. 	You delete the image atlas to free previously allocated memory during
 		K15_IACreateAtlas.
@@ -82,6 +131,18 @@ K15 Image Atlas v 1.0
 	If memory was allocated by K15_IA_MALLOC during K15_IACreateAtlas,
 	the memory will be freed using K15_IA_FREE.
 
+	Note:	K15_IASerializeAtlas writes the complete state of an atlas into a
+			buffer. K15_IALoadAtlas uses that buffer (e.g. a memory mapped file)
+			directly as the memory of an atlas, so the images don't have to be
+			placed again at runtime and more images can be added later on.
+
+	Note:	If the images don't fit into a single atlas, use a K15_IAMultiPageAtlas
+			(see K15_IACreateMultiPageAtlas). Images will be spilled into a new page
+			once the current page is full. The pages can be baked into a texture 
+			array using K15_IABakeMultiPageAtlasIntoTextureArray. Use 
+			K15_IASetMultiPageAtlasPadding (and the other K15_IASetMultiPageAtlas* 
+			functions) to change the settings of all pages.
+
 # Example Usage
 {
 	const int numImagesToAdd = 256;
@@ -130,19 +191,16 @@ K15 Image Atlas v 1.0
 		try increasing the amount of wasted spaces rectangles that are getting
 		tracked (place '#define K15_IA_MAX_WASTED_SPACE_RECTS N' before 
 		including this header - where N is the amount of wasted space rectangles 
-		to track. Default is 512). 
+		to track. Default is 512). Alternatively, create the atlas with 
+		K15_IACreateAtlasWithAllocator, which grows these arrays on demand.
 
 	-	Best results can be achieved if the images are sorted prior to adding 
-		them to the atlas.
-
-	-	Currently, the library only produces atlases whose width and height 
-		are power of two.
+		them to the atlas. If you know all images up front, use K15_IAAddImagesToAtlas
+		which will sort the images for you (see K15_IASortKey) before placing them.
 
-# TODO
-	- 	Merge wasted space areas
-	- 	Allow to create non power of two atlases
-	- 	Add border per image (really necessary?)
-	- 	Enable automatic mip map creation (really necessary?)
+	-	By default, the library only produces atlases whose width and height 
+		are power of two. Use K15_IASetAtlasGrowStep to let the atlas grow in
+		smaller steps and K15_IAShrinkAtlasToFit to get a tight fit.
 
 # License:
 	This software is in the public domain. Where that dedication is not
@@ -170,41 +228,142 @@ typedef unsigned char kia_byte;
 enum _K15_IAAtlasFlags
 {
 	KIA_EXTERNAL_MEMORY_FLAG = 0x01,			//<! Memory was provided by the user (K15_IACreateAtlasWithCustomMemory)
-	KIA_FORCE_POWER_OF_TWO_DIMENSION = 0x02		//<! Currently used by default
+	KIA_FORCE_POWER_OF_TWO_DIMENSION = 0x02,	//<! Used by default (see K15_IASetAtlasGrowStep)
+	KIA_DYNAMIC_MEMORY_FLAG = 0x04,				//<! Memory grows on demand using the allocator passed to K15_IACreateAtlasWithAllocator
+	KIA_ALLOW_IMAGE_ROTATION = 0x08,			//<! Images may get rotated during placement (see K15_IASetAtlasImageRotation)
+	KIA_FIT_MINIMAL_DIMENSION = 0x10,			//<! Batches search for the smallest atlas instead of growing it (see K15_IASetAtlasMinimalFit)
+	KIA_CLEAR_FREE_SPACE_PENDING = 0x20			//<! The next K15_IABakeDirtyImagesIntoPixelBuffer clears all free space (too many pending clear rects)
 };
 
+//Allocator callbacks used by atlases created with K15_IACreateAtlasWithAllocator.
+//K15_IAReallocFnc has to behave like realloc (p_Memory is NULL for new allocations). 
+typedef void* (*K15_IAReallocFnc)(void* p_Memory, kia_u32 p_SizeInBytes, void* p_UserData);
+typedef void (*K15_IAFreeFnc)(void* p_Memory, void* p_UserData);
+
+//Flags for K15_IABakeImageAtlasIntoPixelBufferParallel
+typedef enum _K15_IABakeFlags
+{
+	KIA_BAKE_CLEAR_FREE_SPACE = 0x00,	//<! Default: Only clear the pixels that aren't covered by any image
+	KIA_BAKE_CLEAR_ALL = 0x01,			//<! Clear the whole destination buffer before copying the images
+	KIA_BAKE_SKIP_CLEAR = 0x02			//<! Don't clear at all (destination buffer is already zeroed)
+} K15_IABakeFlags;
+
+//Filter used to downsample the images in K15_IABakeImageAtlasMipChainIntoPixelBuffer
+typedef enum _K15_IAMipFilter
+{
+	KIA_MIP_FILTER_BOX = 0,		//<! Average of 2x2 pixels (fast)
+	KIA_MIP_FILTER_KAISER = 1	//<! Kaiser windowed sinc with 6x6 taps (sharper)
+} K15_IAMipFilter;
+
+//Job callbacks used by K15_IABakeImageAtlasIntoPixelBufferParallel.
+typedef void (*K15_IABakeJobFnc)(void* p_JobData, kia_u32 p_JobIndex);
+typedef void (*K15_IARunBakeJobsFnc)(K15_IABakeJobFnc p_JobFnc, void* p_JobData, kia_u32 p_NumJobs, 
+	void* p_UserData);
+
+//Receives the pixel data of rows [p_StartRow, p_StartRow + p_NumRows) during K15_IABakeImageAtlasIntoBands
+typedef void (*K15_IABakeBandFnc)(void* p_BandPixelData, kia_u32 p_StartRow, kia_u32 p_NumRows, 
+	void* p_UserData);
+
 typedef enum _K15_IAPixelFormat
 {
 	KIA_PIXEL_FORMAT_R8 = 1,
 	KIA_PIXEL_FORMAT_R8A8 = 2,
 	KIA_PIXEL_FORMAT_R8G8B8 = 3,
-	KIA_PIXEL_FORMAT_R8G8B8A8 = 4
+	KIA_PIXEL_FORMAT_R8G8B8A8 = 4,
+
+	//Block compressed formats (4x4 pixel per block), only supported as destination pixel format
+	KIA_PIXEL_FORMAT_BC1 = 0x11,	//<! RGB with 1 bit alpha, 8 bytes per block
+	KIA_PIXEL_FORMAT_BC3 = 0x12,	//<! RGBA, 16 bytes per block
+	KIA_PIXEL_FORMAT_BC4 = 0x13,	//<! R, 8 bytes per block
+	KIA_PIXEL_FORMAT_BC5 = 0x14		//<! RG, 16 bytes per block
 } K15_IAPixelFormat;
 
+typedef enum _K15_IASortKey
+{
+	KIA_SORT_BY_HEIGHT = 0,		//<! Sort by height (descending), ties are broken by width
+	KIA_SORT_BY_AREA = 1,		//<! Sort by area (descending), ties are broken by height
+	KIA_SORT_BY_MAX_SIDE = 2,	//<! Sort by the longer side (descending), ties are broken by the shorter side
+	KIA_SORT_BY_PERIMETER = 3	//<! Sort by perimeter (descending), ties are broken by height
+} K15_IASortKey;
+
+//Algorithm used to place new images (see K15_IASetAtlasPacker)
+typedef enum _K15_IAPacker
+{
+	KIA_PACKER_SKYLINE = 0,							//<! Default: Skyline packer, reuses the wasted space below the skylines (see K15_IASetAtlasSkylineHeuristic)
+	KIA_PACKER_MAX_RECTS_BEST_SHORT_SIDE_FIT = 1,	//<! MaxRects, picks the free rect whose shorter leftover side is the smallest (dense, slow)
+	KIA_PACKER_MAX_RECTS_BEST_AREA_FIT = 2,			//<! MaxRects, picks the smallest free rect
+	KIA_PACKER_MAX_RECTS_CONTACT_POINT = 3,			//<! MaxRects, picks the position where the image touches most other images (slowest)
+	KIA_PACKER_GUILLOTINE = 4,						//<! Splits the smallest free rect the image fits in into two disjoint rects
+	KIA_PACKER_SHELF = 5							//<! Places images next to each other in rows (fastest, least dense)
+} K15_IAPacker;
+
+//Score used by the skyline packer to pick the position of a new image (see K15_IASetAtlasSkylineHeuristic)
+typedef enum _K15_IASkylineHeuristic
+{
+	KIA_SKYLINE_BEST_WIDTH_FIT = 0,					//<! Default: Picks the position where the image leaves the smallest gap to the next skyline
+	KIA_SKYLINE_BOTTOM_LEFT = 1,					//<! Picks the position where the top edge of the image is the lowest
+	KIA_SKYLINE_MIN_WASTED_AREA = 2,				//<! Picks the position that wastes the least space underneath the image
+	KIA_SKYLINE_MIN_WASTED_AREA_AND_HEIGHT = 3		//<! Weighs the wasted area against the top edge (see K15_IA_SKYLINE_HEIGHT_WEIGHT)
+} K15_IASkylineHeuristic;
+
 typedef enum _K15_AtlasResults
 {
 	K15_IA_RESULT_SUCCESS = 0,				//<! Everything went fine
 	K15_IA_RESULT_OUT_OF_MEMORY = 1,		//<! Out of memory
 	K15_IA_RESULT_OUT_OF_RANGE = 2,			//<! Out of range (passed wrong index)
 	K15_IA_RESULT_INVALID_ARGUMENTS = 3,	//<! Invalid arguments (nullptr, etc)
-	K15_IA_RESULT_TOO_FEW_SKYLINES = 4,		//<! K15_IA_MAX_SKYLINES is too small for your atlas
+	K15_IA_RESULT_TOO_FEW_SKYLINES = 4,		//<! K15_IA_MAX_SKYLINES is too small for your atlas (never returned for atlases created with K15_IACreateAtlasWithAllocator)
 	K15_IA_RESULT_ATLAS_TOO_SMALL = 5,		//<! Only used internally
-	K15_IA_RESULT_ATLAS_TOO_LARGE = 6		//<! The atlas has grown too large (Specified by K15_IA_DIMENSION_THRESHOLD)
+	K15_IA_RESULT_ATLAS_TOO_LARGE = 6,		//<! The atlas has grown too large (Specified by K15_IA_DIMENSION_THRESHOLD or K15_IASetAtlasMaxDimension)
+	K15_IA_RESULT_FULL_BAKE_REQUIRED = 7,	//<! The atlas has to be baked completely (see K15_IABakeDirtyImagesIntoPixelBuffer)
+	K15_IA_RESULT_INCOMPATIBLE_DATA = 8		//<! The serialized atlas has another version or layout, or the platform isn't little endian (see K15_IALoadAtlas)
 } kia_result;
 
+//Old and new position of an image after K15_IARepackAtlas
+typedef struct _K15_IARelocation
+{
+	kia_u32 imageHandle;
+	int oldPosX;
+	int oldPosY;
+	int newPosX;
+	int newPosY;
+	int width;
+	int height;
+} K15_IARelocation;
+
+//Area of the atlas that changed during K15_IABakeDirtyImagesIntoPixelBuffer
+typedef struct _K15_IADirtyRect
+{
+	int posX;
+	int posY;
+	int width;
+	int height;
+} K15_IADirtyRect;
+
 struct _K15_IARect;
 struct _K15_IAImageNode;
 struct _K15_IASkyline;
+struct _K15_IARectLink;
 
 typedef struct _K15_IARect K15_IARect;
 typedef struct _K15_IAImageNode K15_IAImageNode;
 typedef struct _K15_IASkyline K15_IASkyline;
+typedef struct _K15_IARectLink K15_IARectLink;
+
+//Number of removed areas that K15_IABakeDirtyImagesIntoPixelBuffer clears one by one. If more images 
+//get removed between two bakes, the whole free space gets cleared instead.
+#ifndef K15_IA_MAX_PENDING_CLEAR_RECTS
+# define K15_IA_MAX_PENDING_CLEAR_RECTS 32
+#endif //K15_IA_MAX_PENDING_CLEAR_RECTS
 
 typedef struct _K15_ImageAtlas
 {
 	K15_IASkyline* skylines;		//<! Skylines used to place a new image
 	K15_IAImageNode* imageNodes;	//<! Image nodes added to the atlas
 	K15_IARect* wastedSpaceRects;	//<! We keep track of wasted space to fill it eventually
+	K15_IARectLink* wastedSpaceRectLinks;	//<! Links the wasted space rects of the same size class together
+	kia_u32* wastedSpaceRectBuckets;	//<! First wasted space rect per size class (see K15_IA_NUM_SIZE_CLASSES)
+	kia_u32* skylineWindowIndices;	//<! Scratch memory used while searching for the best skyline
 
 	kia_u32 width;					//<! Width of the atlas
 	kia_u32 height;					//<! Height of the atlas
@@ -213,9 +372,48 @@ typedef struct _K15_ImageAtlas
 	kia_u32 numWastedSpaceRects;	//<! Number of rects in the wastedSpaceRects array
 	kia_u32 numImageNodes;			//<! Number of image nodes in the imageNodes array
 	kia_u32 numMaxImageNodes;		//<! Maximum number of images supported for the atlas
+	kia_u32 numMaxSkylines;			//<! Capacity of the skylines array
+	kia_u32 numMaxWastedSpaceRects;	//<! Capacity of the wastedSpaceRects array
+	kia_u32 numGrowRetries;			//<! Number of times a placement failed and had to be retried after growing the atlas
+	kia_u32 growStep;				//<! Atlas dimensions grow in multiples of this value (unless KIA_FORCE_POWER_OF_TWO_DIMENSION is set)
+	kia_u32 maxDimension;			//<! Atlas won't grow beyond this width/height (K15_IA_DIMENSION_THRESHOLD by default)
+	kia_u32 numRemovedImageNodes;	//<! Number of image nodes that have been removed (their slots can be reused)
+	kia_u32 firstFreeImageNodeIndex; //<! Start of the list of removed image nodes
+	kia_u32 firstDirtyImageNodeIndex; //<! Start of the list of image nodes that changed since the last bake
+	kia_u32 bakedWidth;				//<! Width of the atlas during the last bake
+	kia_u32 bakedHeight;			//<! Height of the atlas during the last bake
+	kia_u32 numPendingClearRects;	//<! Number of rects in the pendingClearRects array
+	K15_IADirtyRect pendingClearRects[K15_IA_MAX_PENDING_CLEAR_RECTS]; //<! Areas of removed images that still have to be cleared by the next incremental bake
+	K15_IAPixelFormat bakedPixelFormat; //<! Pixel format used during the last bake
+	K15_IAPacker packer;			//<! Algorithm used to place new images (see K15_IASetAtlasPacker)
+	K15_IASkylineHeuristic skylineHeuristic; //<! Score used by the skyline packer (see K15_IASetAtlasSkylineHeuristic)
 	kia_u8 flags;					//<! See K15_IAAtlasFlags enum
+	kia_u8 padding;					//<! Padding around images that get added (see K15_IASetAtlasPadding)
+	kia_u8 alignment;				//<! Area reserved per image is a multiple of this (see K15_IASetAtlasAlignment)
+
+	K15_IAReallocFnc reallocFnc;	//<! Only used if KIA_DYNAMIC_MEMORY_FLAG is set
+	K15_IAFreeFnc freeFnc;			//<! Only used if KIA_DYNAMIC_MEMORY_FLAG is set
+	void* allocatorUserData;		//<! Passed to reallocFnc and freeFnc
 } K15_ImageAtlas;
 
+//Set of atlases (pages) that spills into a new page once the current page is full
+typedef struct _K15_IAMultiPageAtlas
+{
+	K15_ImageAtlas* pages;			//<! Pages of the atlas, every page is a regular atlas
+	kia_u32 numPages;				//<! Number of pages in the pages array
+	kia_u32 numMaxPages;			//<! Capacity of the pages array
+	kia_u32 numImagesPerPage;		//<! Number of images each page can store (initial number for growable pages)
+	kia_u32 pageDimension;			//<! Maximum width and height of each page
+	K15_IAPacker packer;			//<! Packer of new pages (see K15_IASetMultiPageAtlasPacker)
+	kia_u8 flags;					//<! See K15_IAAtlasFlags enum
+	kia_u8 padding;					//<! Padding of new pages (see K15_IASetMultiPageAtlasPadding)
+	kia_u8 alignment;				//<! Alignment of new pages (see K15_IASetMultiPageAtlasAlignment)
+
+	K15_IAReallocFnc reallocFnc;	//<! Only used if KIA_DYNAMIC_MEMORY_FLAG is set
+	K15_IAFreeFnc freeFnc;			//<! Only used if KIA_DYNAMIC_MEMORY_FLAG is set
+	void* allocatorUserData;		//<! Passed to reallocFnc and freeFnc
+} K15_IAMultiPageAtlas;
+
 //Create a new atlas which is able to store and process p_NumImages of images.
 //Note: Triggers an allocation by using K15_IA_MALLOC.
 //		Returns one of the following results:
@@ -231,12 +429,129 @@ kia_def kia_result K15_IACreateAtlas(K15_ImageAtlas* p_OutImageAtlas, kia_u32 p_
 kia_def kia_result K15_IACreateAtlasWithCustomMemory(K15_ImageAtlas* p_OutImageAtlas, kia_u32 p_NumImages,
 	void* p_AtlasMemory);
 
+//Create a new atlas whose book-keeping memory grows on demand. p_NumImages is only the 
+//initial number of images, the atlas will grow beyond that. The same is true for the number
+//of skylines and wasted space rects (K15_IA_MAX_SKYLINES and K15_IA_MAX_WASTED_SPACE_RECTS
+//are ignored for these atlases). All memory is allocated by p_ReallocFnc and freed by 
+//p_FreeFnc (p_UserData gets passed to both).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_OutImageAtlas, p_ReallocFnc or p_FreeFnc is NULL)
+//			- K15_IA_RESULT_OUT_OF_MEMORY
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IACreateAtlasWithAllocator(K15_ImageAtlas* p_OutImageAtlas, kia_u32 p_NumImages,
+	K15_IAReallocFnc p_ReallocFnc, K15_IAFreeFnc p_FreeFnc, void* p_UserData);
+
+//Give the atlas a hint about the images that are going to be added, so it can pick its 
+//size up front instead of growing (and retrying the placement) over and over again.
+//p_ExpectedTotalArea is the combined area (width * height) of all images that are going to be added,
+//p_MaxImageWidth and p_MaxImageHeight are the dimensions of the largest image.
+//The atlas will never shrink by calling this function.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL)
+//			- K15_IA_RESULT_ATLAS_TOO_LARGE (The hint exceeds the maximum dimension of the atlas)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasSizeHint(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ExpectedTotalArea,
+	kia_u32 p_MaxImageWidth, kia_u32 p_MaxImageHeight);
+
+//Set how the atlas grows if an image doesn't fit anymore. By default (p_GrowStep == 0), 
+//width and height are power of two and get doubled. Any other value makes the atlas grow
+//in steps of p_GrowStep pixels, width and height will then always be a multiple of p_GrowStep 
+//(e.g. 4 for block compressed textures).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL or p_GrowStep is 
+//											   greater than K15_IA_DIMENSION_THRESHOLD)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasGrowStep(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_GrowStep);
+
+//Limit the width and height of the atlas to p_MaxDimension (K15_IA_DIMENSION_THRESHOLD by default).
+//Adding an image that doesn't fit anymore will return K15_IA_RESULT_ATLAS_TOO_LARGE.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL or p_MaxDimension is 
+//											   greater than K15_IA_DIMENSION_THRESHOLD)
+//			- K15_IA_RESULT_OUT_OF_RANGE (The atlas is already bigger than p_MaxDimension)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasMaxDimension(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_MaxDimension);
+
+//Allow the atlas to rotate images by 90 degrees if they fit better that way (disabled by default).
+//Rotated images are stored transposed - pixel (x, y) of the image ends up at (posX + y, posY + x)
+//inside the atlas. Use K15_IAGetImageRotation to check whether an image has been rotated.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasImageRotation(K15_ImageAtlas* p_ImageAtlas, kia_b8 p_AllowRotation);
+
+//Let K15_IAAddImagesToAtlas search for the smallest atlas that fits all images of the batch 
+//(disabled by default). Instead of doubling the atlas whenever an image doesn't fit, the batch 
+//gets packed into candidate sizes - starting at the total area of the images - and the 
+//candidate with the smallest area wins. For every candidate width the smallest height gets 
+//found using a binary search. Candidates are at most K15_IA_MAX_FIT_ASPECT_RATIO times as wide 
+//as high (and vice versa) unless the images themselves require otherwise. This takes a lot more 
+//time than the regular placement and is meant for offline baking. The search only happens if the
+//atlas doesn't contain any images yet, otherwise the batch gets placed like usual.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasMinimalFit(K15_ImageAtlas* p_ImageAtlas, kia_b8 p_FitMinimal);
+
+//Reserve p_Padding pixels on each side of every image that gets added from now on (0 by default). 
+//The positions returned when adding an image still point to the image itself. While baking, 
+//the edge pixels of the image get repeated into the padding, so texture filtering and mip 
+//maps don't bleed neighbouring images into each other. Change the padding between adding 
+//images to use a different padding per image.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL or p_Padding is greater than 255)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasPadding(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Padding);
+
+//Round the width and height of the area reserved for every image (including the padding) up to 
+//a multiple of p_Alignment (1 by default). The additional pixels repeat the edge pixels of the image.
+//Use an alignment of 4 if the atlas gets baked into a block compressed pixel format (e.g. 
+//KIA_PIXEL_FORMAT_BC1), so no 4x4 block contains pixels of two different images (shared blocks 
+//are slower to bake and lose quality).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL or p_Alignment is not a power 
+//											   of two between 1 and 128)
+//			- K15_IA_RESULT_OUT_OF_RANGE (Images have already been added to the atlas)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasAlignment(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Alignment);
+
+//Set the algorithm that is used to place new images (KIA_PACKER_SKYLINE by default). All packers
+//work with every other function of this library. MaxRects creates the densest atlases but gets
+//slow for many images, the shelf packer is the fastest and fits realtime use (e.g. glyph caches).
+//MaxRects and Guillotine track all free space as wasted space rects, so atlases with a fixed
+//capacity might need a bigger K15_IA_MAX_WASTED_SPACE_RECTS.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL or p_Packer is invalid)
+//			- K15_IA_RESULT_OUT_OF_RANGE (Images have already been added to the atlas)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasPacker(K15_ImageAtlas* p_ImageAtlas, K15_IAPacker p_Packer);
+
+//Set the score the skyline packer uses to pick the position of new images (KIA_SKYLINE_BEST_WIDTH_FIT
+//by default). Ties are broken by the lowest top edge. KIA_SKYLINE_BOTTOM_LEFT is the cheapest and 
+//works well for power of two atlases. KIA_SKYLINE_MIN_WASTED_AREA stacks images wherever they fit
+//without a gap, which creates a lot more skylines (keep K15_IA_MAX_SKYLINES in mind). The heuristic
+//can be changed between adding images. Only used by KIA_PACKER_SKYLINE.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL or p_Heuristic is invalid)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetAtlasSkylineHeuristic(K15_ImageAtlas* p_ImageAtlas, K15_IASkylineHeuristic p_Heuristic);
+
+//Shrink the atlas to the bounding box of all images that have been added so far (rounded up
+//to the next power of two or the next multiple of the grow step - see K15_IASetAtlasGrowStep).
+//Call this after all images have been added and before baking to not waste any memory
+//on unused pixels. Images can still be added afterwards (the atlas grows again if necessary).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IAShrinkAtlasToFit(K15_ImageAtlas* p_ImageAtlas);
+
 //Calculates the amount of memory needed (in bytes) to store an image atlas which
 //is able to store p_NumImages of images.
 kia_def kia_u32 K15_IACalculateAtlasMemorySizeInBytes(kia_u32 p_NumImages);
 
 //Calculate the amount of memory needed (in bytes) to store the baked image atlas
-//pixel data in a specific pixel format.
+//pixel data in a specific pixel format (block compressed formats are stored as 4x4 blocks,
+//the atlas dimension gets rounded up to a multiple of 4).
 kia_def kia_u32 K15_IACalculateAtlasPixelDataSizeInBytes(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat);
 
 //Free a previously created atlas (K15_IACreateAtlas). Deallocates all memory associated with 
@@ -251,25 +566,367 @@ kia_def void K15_IAFreeAtlas(K15_ImageAtlas* p_ImageAtlas);
 //Note: Returns one of the following results:
 //			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL, p_PixelData is NULL or 
 //											   p_PixelDataWith and/or p_PixelDataHeight are invalid or
-//											   p_OutX and/or p_OutY are NULL)
-//			- K15_IA_RESULT_ATLAS_TOO_SMALL
+//											   p_OutX and/or p_OutY are NULL or p_PixelFormat is
+//											   a block compressed format)
+//			- K15_IA_RESULT_ATLAS_TOO_LARGE
 //			- K15_IA_RESULT_TOO_FEW_SKYLINES
 //			- K15_IA_RESULT_OUT_OF_RANGE (Trying to add more images than specified 
 //										  in K15_IACreateAtlas / K15_IACreateAtlasWithCustomMemory)
+//			- K15_IA_RESULT_OUT_OF_MEMORY (Only for atlases created with K15_IACreateAtlasWithAllocator)
 //			- K15_IA_RESULT_SUCCESS
 kia_def kia_result K15_IAAddImageToAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
 	void* p_PixelData, kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight,
 	int* p_OutX, int* p_OutY);
 
+//Same as K15_IAAddImageToAtlas, but also returns a handle to the image using p_OutHandle 
+//(can be NULL). The handle stays valid until the image gets removed using 
+//K15_IARemoveImageFromAtlas. Handles of removed images will be reused for new images.
+//Note: Returns the same results as K15_IAAddImageToAtlas
+kia_def kia_result K15_IAAddImageToAtlasWithHandle(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
+	void* p_PixelData, kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight,
+	int* p_OutX, int* p_OutY, kia_u32* p_OutHandle);
+
+//Remove an image from the atlas. The area of the image and its handle will be used for new
+//images right away.
+//p_ImageHandle is the handle returned by K15_IAAddImageToAtlasWithHandle / K15_IAAddImagesToAtlas.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_ImageHandle is invalid or has already been removed)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IARemoveImageFromAtlas(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle);
+
+//Check whether an image has been rotated during placement (see K15_IASetAtlasImageRotation).
+//The result will be returned using p_OutRotated. The width and height of a rotated image are
+//swapped inside the atlas.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas or p_OutRotated is NULL)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_ImageHandle is invalid or has been removed)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IAGetImageRotation(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle, 
+	kia_b8* p_OutRotated);
+
+//Get the position of an image inside the atlas (the same position that got returned when the
+//image has been added, unless the image got moved by K15_IARepackAtlas or K15_IAOptimizeAtlas).
+//The position will be returned using p_OutX and p_OutY.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas, p_OutX or p_OutY is NULL)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_ImageHandle is invalid or has been removed)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IAGetImagePosition(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle, 
+	int* p_OutX, int* p_OutY);
+
+//Set the pixel data of an image that is already part of the atlas. The image has to have the
+//same dimension as before. This is required to bake images of an atlas that has been loaded
+//using K15_IALoadAtlas (the pixel data isn't part of the serialized atlas).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas or p_PixelData is NULL or p_PixelFormat 
+//											   is a block compressed format)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_ImageHandle is invalid or has been removed)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetImagePixelData(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle,
+	K15_IAPixelFormat p_PixelFormat, void* p_PixelData);
+
+//Place all images of the atlas again (sorted by p_SortKey) to get rid of the fragmentation
+//caused by removing images. Handles stay valid. The old and new position of every image 
+//will be written to p_OutRelocations, so the pixels can be moved on the GPU 
+//(p_OutRelocations needs room for numImageNodes - numRemovedImageNodes entries). The number
+//of relocations will be returned using p_OutNumRelocations.
+//Images keep their orientation, so the relocations are plain copies. The relocated areas 
+//include the padding of the images (see K15_IASetAtlasPadding).
+//The atlas never gets bigger by repacking. If the images don't fit into the current area of 
+//the atlas, all images stay where they are (but the free space of the atlas won't be tracked 
+//as accurately anymore).
+//Note: A full bake is required after repacking (see K15_IABakeDirtyImagesIntoPixelBuffer).
+//		Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas, p_OutRelocations or p_OutNumRelocations is NULL)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_MaxRelocations is too small)
+//			- K15_IA_RESULT_ATLAS_TOO_LARGE (Repacking would make the atlas bigger, nothing has been moved)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IARepackAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IASortKey p_SortKey, 
+	K15_IARelocation* p_OutRelocations, kia_u32 p_MaxRelocations, kia_u32* p_OutNumRelocations);
+
+//Repack all images of the atlas p_NumTrials times and keep the smallest atlas. Every trial uses 
+//another combination of packer (skyline with each heuristic, MaxRects and Guillotine) and order
+//(sorted by each K15_IASortKey, then randomly perturbed). The trials get split into p_NumJobs 
+//jobs (at most K15_IA_MAX_BAKE_JOBS) that each pack into their own scratch atlas. The jobs are 
+//run like the jobs of K15_IABakeImageAtlasIntoPixelBufferParallel (p_RunJobsFnc and p_UserData). 
+//No new trial gets started after p_TimeBudgetInMilliseconds (0 means no limit, see 
+//K15_IA_GET_MILLISECONDS), the first trial always runs. The budget is measured using a monotonic
+//clock (or timespec_get for C11). If neither is available (e.g. -std=c99 on glibc), clock() is 
+//used, which sums up the processor time of all jobs with most C libraries - so the budget runs 
+//out up to p_NumJobs times faster. Define K15_IA_GET_MILLISECONDS in that case.
+//The relocations work like the ones of K15_IARepackAtlas (images keep their orientation). The 
+//atlas keeps its own packer for images that get added afterwards.
+//Note: Triggers an allocation for each scratch atlas (using the allocator of the atlas if it has 
+//		been created by K15_IACreateAtlasWithAllocator - which has to be thread safe in that case).
+//		A full bake is required after optimizing (see K15_IABakeDirtyImagesIntoPixelBuffer).
+//		Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas, p_OutRelocations or p_OutNumRelocations 
+//											   is NULL, p_NumTrials is 0 or p_NumJobs is 0 or 
+//											   greater than K15_IA_MAX_BAKE_JOBS)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_MaxRelocations is too small)
+//			- K15_IA_RESULT_OUT_OF_MEMORY (The scratch atlases couldn't be created)
+//			- K15_IA_RESULT_ATLAS_TOO_LARGE (No trial found a smaller atlas, nothing has been moved)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IAOptimizeAtlas(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumTrials, 
+	kia_u32 p_TimeBudgetInMilliseconds, kia_u32 p_NumJobs, K15_IARunBakeJobsFnc p_RunJobsFnc, 
+	void* p_UserData, K15_IARelocation* p_OutRelocations, kia_u32 p_MaxRelocations, 
+	kia_u32* p_OutNumRelocations);
+
+//Add multiple images to a specific atlas at once. The images will be sorted internally using
+//p_SortKey prior to placing them, so the caller doesn't have to sort the images beforehand.
+//The position of each image will be written to p_OutX[i] and p_OutY[i] where i is the index
+//of the image in the input arrays (the order of the input arrays is left untouched).
+//The handle of each image will be written to p_OutHandles[i] (can be NULL, see 
+//K15_IARemoveImageFromAtlas). Handles of removed images will be reused for new images.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas is NULL, any of the arrays is NULL,
+//											   p_NumImages is 0 or any width and/or height is invalid)
+//			- K15_IA_RESULT_ATLAS_TOO_LARGE
+//			- K15_IA_RESULT_TOO_FEW_SKYLINES
+//			- K15_IA_RESULT_OUT_OF_RANGE (Trying to add more images than specified 
+//										  in K15_IACreateAtlas / K15_IACreateAtlasWithCustomMemory)
+//			- K15_IA_RESULT_OUT_OF_MEMORY (Only for atlases created with K15_IACreateAtlasWithAllocator)
+//			- K15_IA_RESULT_SUCCESS
+//		If an error occurs while placing the images, the images that have already been placed
+//		will stay in the atlas. The position of all images that could not be placed will be -1
+//		(their handle will be ~0u).
+kia_def kia_result K15_IAAddImagesToAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IASortKey p_SortKey,
+	kia_u32 p_NumImages, K15_IAPixelFormat* p_PixelFormats, void** p_PixelData,
+	kia_u32* p_PixelDataWidths, kia_u32* p_PixelDataHeights, int* p_OutX, int* p_OutY,
+	kia_u32* p_OutHandles);
+
 //Compose the images in the atlas into a given pixel data buffer using a specific pixel format.
 //The width and height of the resulting pixel buffer will be returned to the caller using the
-//p_OutWidth and p_OutHeight parameters (can be NULL).
+//p_OutWidth and p_OutHeight parameters (can be NULL). All pixels that aren't covered by an image
+//will be cleared to zero (see KIA_BAKE_CLEAR_FREE_SPACE).
 //Note: If there's a mismatch between the pixel format specified (p_PixelFormat) and the 
 //		pixel format of individual images (specified in K15_IAAddImageToAtlas), pixel
 //		conversion will happen on the fly to match the pixel format specified.
+//Note: Block compressed pixel formats (e.g. KIA_PIXEL_FORMAT_BC1) get encoded block by block 
+//		directly from the pixel data of the images (no uncompressed copy of the atlas is needed).
+//		Use K15_IASetAtlasAlignment(p_ImageAtlas, 4) before adding images, otherwise blocks
+//		that are shared by several images get gathered from all images that overlap them 
+//		(the atlas gets baked block row by block row, which is slower, and the colors of these
+//		images get mixed in one block). The free space is encoded as black with zero alpha.
 kia_def void K15_IABakeImageAtlasIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
 	void* p_DestinationPixelDataBuffer, int* p_OutWidth, int* p_OutHeight);
 
+//Same as K15_IABakeImageAtlasIntoPixelBuffer, but the atlas gets split into p_NumJobs horizontal
+//bands which can be baked in parallel (at most K15_IA_MAX_BAKE_JOBS).
+//p_RunBakeJobsFnc gets called once with all jobs, it has to call p_JobFnc(p_JobData, i) for
+//every i in [0, p_NumJobs) - in any order and on any thread - and must not return before 
+//all jobs have been finished. This way the jobs can be handed to an existing job system.
+//If p_RunBakeJobsFnc is NULL, the library will create p_NumJobs - 1 threads to run the jobs if
+//K15_IA_USE_THREADS is defined. Otherwise, all jobs will run on the calling thread.
+//p_UserData will be passed to p_RunBakeJobsFnc.
+//p_BakeFlags (see K15_IABakeFlags) controls how the destination buffer gets cleared. Pass 
+//KIA_BAKE_SKIP_CLEAR if the buffer is known to be zeroed already (e.g. calloc or fresh mmap).
+//Call this function with p_NumJobs = 1 and p_RunBakeJobsFnc = NULL to bake single threaded.
+kia_def void K15_IABakeImageAtlasIntoPixelBufferParallel(K15_ImageAtlas* p_ImageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, void* p_DestinationPixelDataBuffer, kia_u32 p_NumJobs,
+	K15_IARunBakeJobsFnc p_RunBakeJobsFnc, void* p_UserData, kia_u32 p_BakeFlags,
+	int* p_OutWidth, int* p_OutHeight);
+
+//Calculate the amount of memory needed (in bytes) to store a band of p_NumRowsPerBand rows
+//of the baked atlas (see K15_IABakeImageAtlasIntoBands).
+kia_def kia_u32 K15_IACalculateAtlasBandPixelDataSizeInBytes(K15_ImageAtlas* p_ImageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, kia_u32 p_NumRowsPerBand);
+
+//Same as K15_IABakeImageAtlasIntoPixelBuffer, but the atlas gets baked in horizontal bands of
+//p_NumRowsPerBand rows (top to bottom) into p_BandPixelDataBuffer, which only needs room for 
+//a single band (see K15_IACalculateAtlasBandPixelDataSizeInBytes). p_BakeBandFnc gets called
+//with every finished band (the last band might have less rows), the pixel data is only valid
+//during the call. This way big atlases can be written to a file or uploaded without ever
+//being in memory completely. p_UserData will be passed to p_BakeBandFnc.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas, p_BandPixelDataBuffer or p_BakeBandFnc
+//											   is NULL or p_NumRowsPerBand is 0 or - for block
+//											   compressed pixel formats - not a multiple of 4)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IABakeImageAtlasIntoBands(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
+	void* p_BandPixelDataBuffer, kia_u32 p_NumRowsPerBand, K15_IABakeBandFnc p_BakeBandFnc, 
+	void* p_UserData, int* p_OutWidth, int* p_OutHeight);
+
+//Bake only the images that have been added or removed since the last bake into a pixel buffer that
+//already contains the result of the last bake (same pixel format and atlas dimension).
+//The area of each newly baked or removed image will be written to p_OutDirtyRects (so only these areas
+//have to be uploaded to the GPU). If there are more images than p_MaxDirtyRects, the last 
+//rect will cover all remaining images. The number of rects written will be returned using 
+//p_OutNumDirtyRects. If more than K15_IA_MAX_PENDING_CLEAR_RECTS images have been removed since
+//the last bake, the whole free space of the atlas gets cleared (the first rect covers the whole atlas).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas, p_DestinationPixelDataBuffer, 
+//											   p_OutDirtyRects or p_OutNumDirtyRects is NULL or 
+//											   p_MaxDirtyRects is 0)
+//			- K15_IA_RESULT_FULL_BAKE_REQUIRED (The atlas has never been baked, its dimension 
+//												changed, p_PixelFormat differs from the last bake or
+//												the free space has to be cleared but isn't tracked 
+//												completely. Call K15_IABakeImageAtlasIntoPixelBuffer instead)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IABakeDirtyImagesIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
+	void* p_DestinationPixelDataBuffer, K15_IADirtyRect* p_OutDirtyRects, kia_u32 p_MaxDirtyRects,
+	kia_u32* p_OutNumDirtyRects);
+
+//Calculate the amount of memory needed (in bytes) to store p_NumMipLevels mip levels of the 
+//baked atlas (0 means the whole mip chain down to 1x1) in a specific pixel format.
+kia_def kia_u32 K15_IACalculateAtlasMipChainPixelDataSizeInBytes(K15_ImageAtlas* p_ImageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, kia_u32 p_NumMipLevels);
+
+//Same as K15_IABakeImageAtlasIntoPixelBuffer, but writes p_NumMipLevels mip levels (0 means the
+//whole mip chain down to 1x1) one after another into p_DestinationPixelDataBuffer (level 0 first, 
+//each level is half as wide and high as the previous one). The mip levels of each image are created 
+//right after the image has been copied and only contain pixels of that image, so neighbouring 
+//images don't bleed into each other (use K15_IASetAtlasPadding to also avoid bleeding during filtering).
+//The number of mip levels written will be returned using p_OutNumMipLevels (can be NULL).
+//Note: K15_IABakeDirtyImagesIntoPixelBuffer only updates level 0 of a mip chain.
+//		Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas or p_DestinationPixelDataBuffer is NULL,
+//											   p_MipFilter is invalid or p_PixelFormat is a
+//											   block compressed format)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IABakeImageAtlasMipChainIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, void* p_DestinationPixelDataBuffer, kia_u32 p_NumMipLevels,
+	K15_IAMipFilter p_MipFilter, kia_u32* p_OutNumMipLevels);
+
+//Calculate the amount of memory needed (in bytes) to serialize an atlas using K15_IASerializeAtlas
+//with room for p_NumAdditionalImages images that can be added after loading the atlas again.
+kia_def kia_u32 K15_IACalculateSerializedAtlasSizeInBytes(K15_ImageAtlas* p_ImageAtlas, 
+	kia_u32 p_NumAdditionalImages);
+
+//Write the complete state of an atlas (images, skylines, wasted space rects, dimension and 
+//settings) into p_Buffer, so it can be loaded again using K15_IALoadAtlas without placing the 
+//images again. The data is versioned and little endian, every array is stored exactly like it is
+//stored in memory. The pixel data of the images is not part of the serialized atlas. 
+//The number of bytes written will be returned using p_OutSizeInBytes (can be NULL).
+//Note: The serialized atlas can only be loaded on platforms with the same pointer size (the
+//		layout of the image nodes differs otherwise).
+//		Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_ImageAtlas or p_Buffer is NULL)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_BufferSizeInBytes is too small, see 
+//										  K15_IACalculateSerializedAtlasSizeInBytes)
+//			- K15_IA_RESULT_INCOMPATIBLE_DATA (The platform isn't little endian)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASerializeAtlas(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumAdditionalImages,
+	void* p_Buffer, kia_u32 p_BufferSizeInBytes, kia_u32* p_OutSizeInBytes);
+
+//Load an atlas that has been serialized using K15_IASerializeAtlas. Nothing gets copied or 
+//parsed, the arrays of the atlas point directly into p_Memory (e.g. a memory mapped file), so
+//p_Memory has to stay valid until the atlas isn't needed anymore (K15_IAFreeAtlas doesn't free 
+//it). p_Memory has to be aligned to 8 bytes. 
+//The loaded atlas behaves like an atlas created by K15_IACreateAtlasWithCustomMemory, images can 
+//be looked up (see K15_IAGetImagePosition), added (up to the number of additional images passed to 
+//K15_IASerializeAtlas), removed and baked - which requires p_Memory to be writable (a private 
+//mapping is enough). The images of a loaded atlas don't have any pixel data, use 
+//K15_IASetImagePixelData before baking them. K15_IABakeDirtyImagesIntoPixelBuffer continues where 
+//the last bake before serializing left off, so only the images added after loading need pixel data
+//(block compressed bakes of atlases with an alignment below 4 also need the pixel data of images
+//that share a block with them).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_OutImageAtlas or p_Memory is NULL or p_Memory isn't
+//											   aligned)
+//			- K15_IA_RESULT_OUT_OF_RANGE (p_MemorySizeInBytes is smaller than the serialized atlas or
+//										  the serialized atlas is corrupt)
+//			- K15_IA_RESULT_INCOMPATIBLE_DATA (p_Memory doesn't contain a serialized atlas, the atlas 
+//											   has been serialized by another version or on a
+//											   platform with a different layout)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IALoadAtlas(K15_ImageAtlas* p_OutImageAtlas, void* p_Memory, 
+	kia_u32 p_MemorySizeInBytes);
+
+//Create a new multi page atlas with up to p_NumMaxPages pages. Each page is a regular atlas 
+//(created using K15_IACreateAtlas) that is able to store p_NumImagesPerPage of images and won't 
+//grow beyond p_PageDimension (0 means K15_IA_DIMENSION_THRESHOLD). Pages get created on demand.
+//Note: Triggers an allocation by using K15_IA_MALLOC.
+//		Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_OutMultiPageAtlas is NULL, p_NumMaxPages or 
+//											   p_NumImagesPerPage is 0 or p_PageDimension is
+//											   greater than K15_IA_DIMENSION_THRESHOLD or less 
+//											   than K15_IA_DEFAULT_MIN_ATLAS_DIMENSION)
+//			- K15_IA_RESULT_OUT_OF_MEMORY
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IACreateMultiPageAtlas(K15_IAMultiPageAtlas* p_OutMultiPageAtlas, kia_u32 p_NumMaxPages,
+	kia_u32 p_NumImagesPerPage, kia_u32 p_PageDimension);
+
+//Same as K15_IACreateMultiPageAtlas, but the number of pages is unlimited and each page is
+//created using K15_IACreateAtlasWithAllocator (see there).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_OutMultiPageAtlas, p_ReallocFnc or p_FreeFnc is NULL
+//											   or p_PageDimension is invalid, see there)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IACreateMultiPageAtlasWithAllocator(K15_IAMultiPageAtlas* p_OutMultiPageAtlas,
+	kia_u32 p_NumImagesPerPage, kia_u32 p_PageDimension, K15_IAReallocFnc p_ReallocFnc, 
+	K15_IAFreeFnc p_FreeFnc, void* p_UserData);
+
+//Free a multi page atlas including all of its pages.
+kia_def void K15_IAFreeMultiPageAtlas(K15_IAMultiPageAtlas* p_MultiPageAtlas);
+
+//Set the padding of every page (see K15_IASetAtlasPadding). Applies to pages that get created 
+//later on as well as to the images that get added to the current page from now on.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_MultiPageAtlas is NULL or p_Padding is greater than 255)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetMultiPageAtlasPadding(K15_IAMultiPageAtlas* p_MultiPageAtlas, kia_u32 p_Padding);
+
+//Set the alignment of every page (see K15_IASetAtlasAlignment). Use an alignment of 4 if the 
+//pages get baked into a block compressed pixel format.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_MultiPageAtlas is NULL or p_Alignment is not a power 
+//											   of two between 1 and 128)
+//			- K15_IA_RESULT_OUT_OF_RANGE (Images have already been added to the atlas)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetMultiPageAtlasAlignment(K15_IAMultiPageAtlas* p_MultiPageAtlas, kia_u32 p_Alignment);
+
+//Allow every page to rotate images (see K15_IASetAtlasImageRotation). Applies to the current
+//page as well as to pages that get created later on.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_MultiPageAtlas is NULL)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetMultiPageAtlasImageRotation(K15_IAMultiPageAtlas* p_MultiPageAtlas, 
+	kia_b8 p_AllowRotation);
+
+//Set the packer of every page (see K15_IASetAtlasPacker).
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_MultiPageAtlas is NULL or p_Packer is invalid)
+//			- K15_IA_RESULT_OUT_OF_RANGE (Images have already been added to the atlas)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IASetMultiPageAtlasPacker(K15_IAMultiPageAtlas* p_MultiPageAtlas, K15_IAPacker p_Packer);
+
+//Add an image to the current (last) page of a multi page atlas. If the image doesn't fit 
+//anymore, a new page will be created. The page and the position of the image inside that
+//page will be returned using p_OutPage, p_OutX and p_OutY. A handle of the image will be
+//returned using p_OutHandle (can be NULL). Use K15_IARemoveImageFromAtlas with 
+//p_MultiPageAtlas->pages + page to remove the image again.
+//Every page can be baked on its own (e.g. K15_IABakeImageAtlasIntoPixelBuffer with 
+//p_MultiPageAtlas->pages + page) or all pages at once using K15_IABakeMultiPageAtlasIntoTextureArray.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_MultiPageAtlas, p_PixelData, p_OutPage, p_OutX 
+//											   and/or p_OutY are NULL or p_PixelDataWith and/or 
+//											   p_PixelDataHeight are invalid)
+//			- K15_IA_RESULT_ATLAS_TOO_LARGE (The image doesn't fit into an empty page, including
+//											 padding and alignment)
+//			- K15_IA_RESULT_OUT_OF_RANGE (All pages are full)
+//			- K15_IA_RESULT_OUT_OF_MEMORY
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IAAddImageToMultiPageAtlas(K15_IAMultiPageAtlas* p_MultiPageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, void* p_PixelData, kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight,
+	kia_u32* p_OutPage, int* p_OutX, int* p_OutY, kia_u32* p_OutHandle);
+
+//Calculate the amount of memory needed (in bytes) to bake all pages of a multi page atlas
+//into a texture array (see K15_IABakeMultiPageAtlasIntoTextureArray).
+kia_def kia_u32 K15_IACalculateMultiPageAtlasPixelDataSizeInBytes(K15_IAMultiPageAtlas* p_MultiPageAtlas,
+	K15_IAPixelFormat p_PixelFormat);
+
+//Bake all pages of a multi page atlas into a texture array. Every page will be resized to 
+//the dimension of the biggest page, the pages will be stored one after another (page 0 first).
+//The dimension of a single layer will be returned using p_OutWidth and p_OutHeight, the number
+//of layers is p_MultiPageAtlas->numPages.
+//Note: Returns one of the following results:
+//			- K15_IA_RESULT_INVALID_ARGUMENTS (p_MultiPageAtlas or p_DestinationPixelDataBuffer is NULL)
+//			- K15_IA_RESULT_SUCCESS
+kia_def kia_result K15_IABakeMultiPageAtlasIntoTextureArray(K15_IAMultiPageAtlas* p_MultiPageAtlas,
+	K15_IAPixelFormat p_PixelFormat, void* p_DestinationPixelDataBuffer, int* p_OutWidth, int* p_OutHeight);
+
 #ifdef K15_IA_IMPLEMENTATION
 
 #define K15_IA_TRUE 1
@@ -291,6 +948,18 @@ kia_def void K15_IABakeImageAtlasIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas, K
 # define K15_IA_DEFAULT_MIN_ATLAS_DIMENSION 16
 #endif //K15_IA_DEFAULT_MIN_ATLAS_DIMENSION
 
+#ifndef K15_IA_SKYLINE_HEIGHT_WEIGHT
+# define K15_IA_SKYLINE_HEIGHT_WEIGHT 1
+#endif //K15_IA_SKYLINE_HEIGHT_WEIGHT
+
+#ifndef K15_IA_MAX_FIT_ASPECT_RATIO
+# define K15_IA_MAX_FIT_ASPECT_RATIO 2
+#endif //K15_IA_MAX_FIT_ASPECT_RATIO
+
+#ifndef K15_IA_MAX_BLOCK_ROW_IMAGES
+# define K15_IA_MAX_BLOCK_ROW_IMAGES 512
+#endif //K15_IA_MAX_BLOCK_ROW_IMAGES
+
 #if K15_IA_DEFAULT_MIN_ATLAS_DIMENSION <= 8
 # error "'K15_IA_DEFAULT_MIN_ATLAS_DIMENSION' needs to be at least 8"
 #endif
@@ -303,6 +972,24 @@ kia_def void K15_IABakeImageAtlasIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas, K
 # error "'K15_IA_DEFAULT_MIN_ATLAS_DIMENSION' is greater than 'K15_IA_DIMENSION_THRESHOLD'"
 #endif
 
+#if K15_IA_SKYLINE_HEIGHT_WEIGHT > 32
+# error "'K15_IA_SKYLINE_HEIGHT_WEIGHT' can not be greater than 32"
+#endif
+
+#if K15_IA_MAX_FIT_ASPECT_RATIO < 1
+# error "'K15_IA_MAX_FIT_ASPECT_RATIO' needs to be at least 1"
+#endif
+
+#if K15_IA_MAX_BLOCK_ROW_IMAGES < 1
+# error "'K15_IA_MAX_BLOCK_ROW_IMAGES' needs to be at least 1"
+#endif
+
+#if K15_IA_MAX_PENDING_CLEAR_RECTS < 1
+# error "'K15_IA_MAX_PENDING_CLEAR_RECTS' needs to be at least 1"
+#endif
+
+#include <stddef.h> //size_t
+
 #ifndef K15_IA_MALLOC
 # include <stdlib.h>
 # define K15_IA_MALLOC malloc
@@ -341,6 +1028,135 @@ kia_def void K15_IABakeImageAtlasIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas, K
 # define kia_internal static
 #endif //kia_internal
 
+#ifndef K15_IA_MAX_BAKE_JOBS
+# define K15_IA_MAX_BAKE_JOBS 64
+#endif //K15_IA_MAX_BAKE_JOBS
+
+//#define K15_IA_USE_THREADS to let K15_IABakeImageAtlasIntoPixelBufferParallel create its own 
+//threads if no job callback is given (otherwise the jobs run on the calling thread)
+#ifdef K15_IA_USE_THREADS
+# ifdef _WIN32
+#  include <windows.h>
+# else
+#  include <pthread.h>
+# endif //_WIN32
+#endif //K15_IA_USE_THREADS
+
+//#define K15_IA_GET_MILLISECONDS() to provide the wall clock (in milliseconds) that is used for
+//the time budget of K15_IAOptimizeAtlas
+#ifndef K15_IA_GET_MILLISECONDS
+# include <time.h>
+#endif //K15_IA_GET_MILLISECONDS
+
+//SIMD versions of the pixel conversion (and the box mip filter) are used if the compiler targets SSE2/AVX2/NEON.
+//#define K15_IA_NO_SIMD to only use the scalar versions.
+#ifndef K15_IA_NO_SIMD
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define K15_IA_SSE2
+#  include <emmintrin.h>
+# endif
+# if defined(__AVX2__)
+#  define K15_IA_AVX2
+#  include <immintrin.h>
+# endif
+# if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  define K15_IA_NEON
+#  include <arm_neon.h>
+# endif
+#endif //K15_IA_NO_SIMD
+
+//luma weights (0.21, 0.72, 0.07) as 8 bit fixed point values
+#define K15_IA_LUMA_WEIGHT_RED 54
+#define K15_IA_LUMA_WEIGHT_GREEN 184
+#define K15_IA_LUMA_WEIGHT_BLUE 18
+
+//Wasted space rects are sorted into buckets by the power of two of their width and height.
+//16 classes per dimension cover the whole kia_u16 range.
+#define K15_IA_NUM_SIZE_CLASSES 16
+#define K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS (K15_IA_NUM_SIZE_CLASSES * K15_IA_NUM_SIZE_CLASSES)
+#define K15_IA_INVALID_INDEX (~0u)
+#define K15_IA_NUM_OPTIMIZE_PACKERS 7
+#define K15_IA_SERIALIZED_ATLAS_MAGIC 0x4135314Bu //'K15A' in little endian
+#define K15_IA_SERIALIZED_ATLAS_VERSION 1
+#define K15_IA_SERIALIZED_ATLAS_ALIGNMENT 8
+
+//Rotated images are transposed in tiles of this many pixels per side while baking
+#define K15_IA_TRANSPOSE_BLOCK_SIZE 32
+
+//Number of taps per dimension of KIA_MIP_FILTER_KAISER
+#define K15_IA_KAISER_NUM_TAPS 6
+
+//Width and height of a block of the block compressed pixel formats
+#define K15_IA_BLOCK_DIMENSION 4
+
+//Converts p_NumPixels pixels of a single row from one pixel format to another
+typedef void (*K15_IAConvertRowFnc)(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels);
+
+typedef struct _K15_IABakeJobData
+{
+	K15_ImageAtlas* imageAtlas;
+	kia_byte* destinationPixelData;
+	K15_IAPixelFormat destinationPixelFormat;
+	kia_u32 numJobs;
+	kia_u32 bakeFlags;
+} K15_IABakeJobData;
+
+typedef struct _K15_IAOptimizeJobData
+{
+	K15_ImageAtlas* imageAtlas;
+	K15_ImageAtlas* scratchAtlases;		//<! Two per job, the current trial and the best result so far
+	kia_u32 numTrials;
+	kia_u32 numJobs;
+	kia_u32 timeBudgetInMilliseconds;
+	kia_u32 startTimeInMilliseconds;
+} K15_IAOptimizeJobData;
+
+//Layout of a serialized atlas, every field is stored as 32bit little endian value. The arrays 
+//follow the header (see K15_IACalculateSerializedAtlasLayout)
+typedef struct _K15_IASerializedAtlasHeader
+{
+	kia_u32 magic;
+	kia_u32 version;
+	kia_u32 sizeInBytes;
+	kia_u32 imageNodeSizeInBytes;
+	kia_u32 skylineSizeInBytes;
+	kia_u32 rectSizeInBytes;
+	kia_u32 rectLinkSizeInBytes;
+	kia_u32 numWastedSpaceRectBuckets;
+
+	kia_u32 width;
+	kia_u32 height;
+	kia_u32 growStep;
+	kia_u32 maxDimension;
+	kia_u32 flags;
+	kia_u32 padding;
+	kia_u32 alignment;
+	kia_u32 packer;
+	kia_u32 skylineHeuristic;
+
+	kia_u32 numImageNodes;
+	kia_u32 numMaxImageNodes;
+	kia_u32 numRemovedImageNodes;
+	kia_u32 firstFreeImageNodeIndex;
+	kia_u32 firstDirtyImageNodeIndex;
+	kia_u32 numSkylines;
+	kia_u32 numMaxSkylines;
+	kia_u32 numWastedSpaceRects;
+	kia_u32 numMaxWastedSpaceRects;
+
+	kia_u32 bakedWidth;
+	kia_u32 bakedHeight;
+	kia_u32 bakedPixelFormat;
+
+	kia_u32 imageNodesOffset;
+	kia_u32 skylinesOffset;
+	kia_u32 skylineWindowIndicesOffset;
+	kia_u32 wastedSpaceRectsOffset;
+	kia_u32 wastedSpaceRectLinksOffset;
+	kia_u32 wastedSpaceRectBucketsOffset;
+	kia_u32 reserved;
+} K15_IASerializedAtlasHeader;
+
 typedef struct _K15_IARect
 {
 	kia_u16 posX;
@@ -349,10 +1165,24 @@ typedef struct _K15_IARect
 	kia_u16 height;
 } K15_IARect;
 
+typedef enum _K15_IAImageNodeFlags
+{
+	KIA_IMAGE_NODE_REMOVED = 0x01,	//<! Node has been removed, the slot can be reused
+	KIA_IMAGE_NODE_DIRTY = 0x02,	//<! Node changed since the last bake (linked by nextDirtyIndex)
+	KIA_IMAGE_NODE_ROTATED = 0x04	//<! Image is stored transposed, rect is the area inside the atlas
+} K15_IAImageNodeFlags;
+
 typedef struct _K15_IAImageNode
 {
 	K15_IAPixelFormat pixelDataFormat;
 	K15_IARect rect;
+	kia_u32 batchIndex;			//<! Index of the image in the input arrays of K15_IAAddImagesToAtlas
+	kia_u32 nextFreeIndex;		//<! Next removed node (only used for removed nodes)
+	kia_u32 nextDirtyIndex;		//<! Next node that changed since the last bake (only used for dirty nodes)
+	kia_u8 flags;				//<! See K15_IAImageNodeFlags
+	kia_u8 padding;				//<! Padding on each side of the image (part of rect)
+	kia_u16 pixelDataWidth;		//<! Width of the image (rect can be bigger due to padding, alignment and rotation)
+	kia_u16 pixelDataHeight;	//<! Height of the image
 	kia_byte* pixelData;
 } K15_IAImageNode;
 
@@ -363,869 +1193,6458 @@ typedef struct _K15_IASkyline
 	kia_u32 baseLineWidth;
 } K15_IASkyline;
 
+typedef struct _K15_IARectLink
+{
+	kia_u32 previousIndex;
+	kia_u32 nextIndex;
+} K15_IARectLink;
+
+typedef int (*K15_IASortFnc)(const void*, const void*);
+
 /*********************************************************************************/
-kia_internal int K15_IASortSkylineByXPos(const void* p_SkylineA, const void* p_SkylineB)
+kia_internal int K15_IACompareImageNodeKeys(const K15_IAImageNode* p_ImageNodeA, const K15_IAImageNode* p_ImageNodeB,
+	kia_u32 p_PrimaryKeyA, kia_u32 p_PrimaryKeyB, kia_u32 p_SecondaryKeyA, kia_u32 p_SecondaryKeyB)
 {
-	K15_IASkyline* skylineA = (K15_IASkyline*)p_SkylineA;
-	K15_IASkyline* skylineB = (K15_IASkyline*)p_SkylineB;
+	//sort descending by primary and secondary key. Use the batch index as last resort
+	//to get the same result regardless of the qsort implementation
+	if (p_PrimaryKeyA != p_PrimaryKeyB)
+		return p_PrimaryKeyA > p_PrimaryKeyB ? -1 : 1;
+
+	if (p_SecondaryKeyA != p_SecondaryKeyB)
+		return p_SecondaryKeyA > p_SecondaryKeyB ? -1 : 1;
 
-	return skylineA->baseLinePosX - skylineB->baseLinePosX;
+	if (p_ImageNodeA->batchIndex != p_ImageNodeB->batchIndex)
+		return p_ImageNodeA->batchIndex < p_ImageNodeB->batchIndex ? -1 : 1;
+
+	return 0;
 }
 /*********************************************************************************/
+kia_internal int K15_IASortImageNodeByHeight(const void* p_ImageNodeA, const void* p_ImageNodeB)
+{
+	K15_IAImageNode* imageNodeA = (K15_IAImageNode*)p_ImageNodeA;
+	K15_IAImageNode* imageNodeB = (K15_IAImageNode*)p_ImageNodeB;
 
+	return K15_IACompareImageNodeKeys(imageNodeA, imageNodeB, 
+		imageNodeA->rect.height, imageNodeB->rect.height,
+		imageNodeA->rect.width, imageNodeB->rect.width);
+}
+/*********************************************************************************/
+kia_internal int K15_IASortImageNodeByArea(const void* p_ImageNodeA, const void* p_ImageNodeB)
+{
+	K15_IAImageNode* imageNodeA = (K15_IAImageNode*)p_ImageNodeA;
+	K15_IAImageNode* imageNodeB = (K15_IAImageNode*)p_ImageNodeB;
 
+	return K15_IACompareImageNodeKeys(imageNodeA, imageNodeB, 
+		imageNodeA->rect.width * imageNodeA->rect.height, imageNodeB->rect.width * imageNodeB->rect.height,
+		imageNodeA->rect.height, imageNodeB->rect.height);
+}
+/*********************************************************************************/
+kia_internal int K15_IASortImageNodeByMaxSide(const void* p_ImageNodeA, const void* p_ImageNodeB)
+{
+	K15_IAImageNode* imageNodeA = (K15_IAImageNode*)p_ImageNodeA;
+	K15_IAImageNode* imageNodeB = (K15_IAImageNode*)p_ImageNodeB;
+
+	return K15_IACompareImageNodeKeys(imageNodeA, imageNodeB, 
+		K15_IA_MAX(imageNodeA->rect.width, imageNodeA->rect.height),
+		K15_IA_MAX(imageNodeB->rect.width, imageNodeB->rect.height),
+		K15_IA_MIN(imageNodeA->rect.width, imageNodeA->rect.height),
+		K15_IA_MIN(imageNodeB->rect.width, imageNodeB->rect.height));
+}
+/*********************************************************************************/
+kia_internal int K15_IASortImageNodeByPerimeter(const void* p_ImageNodeA, const void* p_ImageNodeB)
+{
+	K15_IAImageNode* imageNodeA = (K15_IAImageNode*)p_ImageNodeA;
+	K15_IAImageNode* imageNodeB = (K15_IAImageNode*)p_ImageNodeB;
 
+	return K15_IACompareImageNodeKeys(imageNodeA, imageNodeB, 
+		imageNodeA->rect.width + imageNodeA->rect.height, imageNodeB->rect.width + imageNodeB->rect.height,
+		imageNodeA->rect.height, imageNodeB->rect.height);
+}
 /*********************************************************************************/
-kia_internal void K15_IAConvertPixel(kia_u8* p_SourcePixel, kia_u8* p_DestinationPixel,
-	K15_IAPixelFormat p_SourcePixelFormat, K15_IAPixelFormat p_DestinationPixelFormat)
+kia_internal K15_IASortFnc K15_IAGetImageNodeSortFunction(K15_IASortKey p_SortKey)
 {
-	if (p_SourcePixelFormat == KIA_PIXEL_FORMAT_R8)
-	{
-		kia_s32 colorIndex = 0;
-		for (colorIndex = 0;
-			colorIndex < p_DestinationPixelFormat;
-			++colorIndex)
-		{
-			p_DestinationPixel[colorIndex] = *p_SourcePixel;
-		}
-	}
-	else if (p_SourcePixelFormat == KIA_PIXEL_FORMAT_R8A8)
-	{
-		kia_u8 sourcePixel = (kia_u8)((float)p_SourcePixel[0] * (float)((p_SourcePixel[1]) / 255));
+	if (p_SortKey == KIA_SORT_BY_AREA)
+		return K15_IASortImageNodeByArea;
+	else if (p_SortKey == KIA_SORT_BY_MAX_SIDE)
+		return K15_IASortImageNodeByMaxSide;
+	else if (p_SortKey == KIA_SORT_BY_PERIMETER)
+		return K15_IASortImageNodeByPerimeter;
+
+	return K15_IASortImageNodeByHeight;
+}
+/*********************************************************************************/
+kia_internal void K15_IASortImageNodes(K15_IAImageNode* p_ImageNodes, kia_u32 p_NumImageNodes,
+	K15_IASortKey p_SortKey)
+{
+	K15_IA_QSORT(p_ImageNodes, p_NumImageNodes, sizeof(K15_IAImageNode), 
+		K15_IAGetImageNodeSortFunction(p_SortKey));
+}
+/*********************************************************************************/
 
-		if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8)
-			p_DestinationPixel[0] = sourcePixel;
-		else if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8G8B8)
-		{
-			p_DestinationPixel[0] = sourcePixel;
-			p_DestinationPixel[1] = sourcePixel;
-			p_DestinationPixel[2] = sourcePixel;
-		}
-		else if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8G8B8A8)
-		{
-			p_DestinationPixel[0] = p_SourcePixel[0];
-			p_DestinationPixel[1] = p_SourcePixel[0];
-			p_DestinationPixel[2] = p_SourcePixel[0];
-			p_DestinationPixel[3] = p_SourcePixel[1];
-		}
-	}
-	else if (p_SourcePixelFormat == KIA_PIXEL_FORMAT_R8G8B8)
-	{
-		kia_u8 greyscale = (kia_u8)((float)(p_SourcePixel[0]) * 0.21f +
-			(float)(p_SourcePixel[1]) * 0.72f +
-			(float)(p_SourcePixel[2]) * 0.07f);
 
-		if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8)
-			p_DestinationPixel[0] = greyscale;
-		else if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8A8)
-		{
-			p_DestinationPixel[0] = greyscale;
-			p_DestinationPixel[1] = 255;
-		}
-		else if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8G8B8A8)
-		{
-			p_DestinationPixel[0] = p_SourcePixel[0];
-			p_DestinationPixel[1] = p_SourcePixel[1];
-			p_DestinationPixel[2] = p_SourcePixel[2];
-			p_DestinationPixel[3] = 255;
-		}
-	}
-	else if (p_SourcePixelFormat == KIA_PIXEL_FORMAT_R8G8B8A8)
-	{
-		float greyscale = (float)(p_SourcePixel[0]) * 0.21f +
-			(float)(p_SourcePixel[1]) * 0.72f +
-			(float)(p_SourcePixel[2]) * 0.07f;
 
-		float alpha = (float)(p_SourcePixel[3] / 255.f);
-		float greyscaleWithAlpha = greyscale * alpha;
+/*********************************************************************************/
+kia_internal kia_u8 K15_IACalculateLuma(kia_u32 p_Red, kia_u32 p_Green, kia_u32 p_Blue)
+{
+	//0.21, 0.72 and 0.07 as 8 bit fixed point weights (they add up to 256, so white stays white)
+	return (kia_u8)((p_Red * K15_IA_LUMA_WEIGHT_RED + p_Green * K15_IA_LUMA_WEIGHT_GREEN + 
+		p_Blue * K15_IA_LUMA_WEIGHT_BLUE + 128) >> 8);
+}
+/*********************************************************************************/
+kia_internal kia_u8 K15_IAMultiplyByAlpha(kia_u32 p_Value, kia_u32 p_Alpha)
+{
+	//(p_Value * p_Alpha) / 255 rounded to the nearest integer without a division
+	kia_u32 value = p_Value * p_Alpha + 128;
+	return (kia_u8)((value + (value >> 8)) >> 8);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8ToR8A8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
 
-		if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8)
-			p_DestinationPixel[0] = (kia_u8)(greyscaleWithAlpha + 0.5f);
-		else if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8A8)
-		{
-			p_DestinationPixel[0] = (kia_u8)(greyscale + 0.5f);
-			p_DestinationPixel[1] = p_SourcePixel[3];
-		}
-		else if (p_DestinationPixelFormat == KIA_PIXEL_FORMAT_R8G8B8)
-		{
-			p_DestinationPixel[0] = (kia_u8)((float)(p_SourcePixel[0]) * alpha);
-			p_DestinationPixel[1] = (kia_u8)((float)(p_SourcePixel[1]) * alpha);
-			p_DestinationPixel[2] = (kia_u8)((float)(p_SourcePixel[2]) * alpha);
-		}
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		p_Destination[0] = p_Source[pixelIndex];
+		p_Destination[1] = p_Source[pixelIndex];
+		p_Destination += 2;
 	}
 }
 /*********************************************************************************/
-kia_internal kia_result K15_IAConvertPixelData(kia_byte* p_DestinationPixelData, kia_byte* p_SourcePixelData,
-	K15_IAPixelFormat p_DestinationPixelFormat, K15_IAPixelFormat p_SourcePixelFormat,
-	kia_u32 p_PixelDataStride)
+kia_internal void K15_IAConvertRowR8ToR8G8B8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
 {
-	kia_u32 sourcePixelIndex = 0;
-	kia_u32 destinationPixelIndex = 0;
 	kia_u32 pixelIndex = 0;
-	if (!p_SourcePixelData || !p_DestinationPixelData || p_PixelDataStride == 0)
+
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
 	{
-		return K15_IA_RESULT_INVALID_ARGUMENTS;
+		p_Destination[0] = p_Source[pixelIndex];
+		p_Destination[1] = p_Source[pixelIndex];
+		p_Destination[2] = p_Source[pixelIndex];
+		p_Destination += 3;
 	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8ToR8G8B8A8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
 
-	//convert pixel by pixel
 	for (pixelIndex = 0;
-		pixelIndex < p_PixelDataStride;
+		pixelIndex < p_NumPixels;
 		++pixelIndex)
 	{
-		sourcePixelIndex = pixelIndex * p_SourcePixelFormat;
-		destinationPixelIndex = pixelIndex * p_DestinationPixelFormat;
-
-		K15_IAConvertPixel(p_SourcePixelData + sourcePixelIndex,
-			p_DestinationPixelData + destinationPixelIndex,
-			p_SourcePixelFormat, p_DestinationPixelFormat);
+		p_Destination[0] = p_Source[pixelIndex];
+		p_Destination[1] = p_Source[pixelIndex];
+		p_Destination[2] = p_Source[pixelIndex];
+		p_Destination[3] = p_Source[pixelIndex];
+		p_Destination += 4;
 	}
-
-	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_internal kia_u32 K15_IARemoveSkylineByIndex(K15_IASkyline* p_Skylines, kia_u32 p_NumSkylines,
-	kia_u32 p_SkylineIndex)
+kia_internal void K15_IAConvertRowR8A8ToR8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
 {
-	kia_u32 numSkylines = p_NumSkylines;
-	kia_u32 numSkylinesToMove = 0;
+	kia_u32 pixelIndex = 0;
 
-	if (p_SkylineIndex + 1 < numSkylines)
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
 	{
-		numSkylinesToMove = numSkylines - p_SkylineIndex;
-		K15_IA_MEMMOVE(p_Skylines + p_SkylineIndex, p_Skylines + p_SkylineIndex + 1,
-			numSkylinesToMove * sizeof(K15_IASkyline));
+		p_Destination[pixelIndex] = K15_IAMultiplyByAlpha(p_Source[0], p_Source[1]);
+		p_Source += 2;
 	}
-
-	return --numSkylines;
 }
 /*********************************************************************************/
-kia_internal kia_u32 K15_IAAddWastedSpaceRect(K15_IARect* p_WastedSpaceRects, kia_u32 p_NumWastedSpaceRects,
-	kia_u32 p_PosX, kia_u32 p_PosY, kia_u32 p_Width, kia_u32 p_Height)
+kia_internal void K15_IAConvertRowR8A8ToR8G8B8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
 {
-	if (p_NumWastedSpaceRects == K15_IA_MAX_WASTED_SPACE_RECTS)
-		return p_NumWastedSpaceRects;
-
-	p_WastedSpaceRects[p_NumWastedSpaceRects].posX = p_PosX;
-	p_WastedSpaceRects[p_NumWastedSpaceRects].posY = p_PosY;
-	p_WastedSpaceRects[p_NumWastedSpaceRects].width = p_Width;
-	p_WastedSpaceRects[p_NumWastedSpaceRects].height = p_Height;
+	kia_u32 pixelIndex = 0;
+	kia_u8 value = 0;
 
-	return p_NumWastedSpaceRects + 1;
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		value = K15_IAMultiplyByAlpha(p_Source[0], p_Source[1]);
+		p_Destination[0] = value;
+		p_Destination[1] = value;
+		p_Destination[2] = value;
+		p_Destination += 3;
+		p_Source += 2;
+	}
 }
 /*********************************************************************************/
-kia_internal void K15_IAFindWastedSpaceAndRemoveObscuredSkylines(K15_IASkyline* p_Skylines,
-	kia_u32* p_NumSkylinesOutIn, K15_IARect* p_WastedSpaceRects, kia_u32* p_NumWastedSpaceRectsOutIn,
-	kia_u32 p_PosX, kia_u32 p_PosY, kia_u32 p_Width)
+kia_internal void K15_IAConvertRowR8A8ToR8G8B8A8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
 {
-	kia_u32 baseLinePosX = 0;
-	kia_u32 baseLinePosY = 0;
-	kia_u32 baseLineWidth = 0;
-	kia_u32 rightPos = p_PosX + p_Width;
-	kia_u32 baseLineRightPos = 0;
-	kia_u32 numSkylines = *p_NumSkylinesOutIn;
-	kia_u32 numWastedSpaceRects = *p_NumWastedSpaceRectsOutIn;
-	kia_u32 skylineIndex = 0;
-	K15_IASkyline* skyline = 0;
+	kia_u32 pixelIndex = 0;
 
-	for (skylineIndex = 0;
-		skylineIndex < numSkylines;
-		++skylineIndex)
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
 	{
-		skyline = p_Skylines + skylineIndex;
-		baseLinePosX = skyline->baseLinePosX;
-		baseLinePosY = skyline->baseLinePosY;
-		baseLineWidth = skyline->baseLineWidth;
+		p_Destination[0] = p_Source[0];
+		p_Destination[1] = p_Source[0];
+		p_Destination[2] = p_Source[0];
+		p_Destination[3] = p_Source[1];
+		p_Destination += 4;
+		p_Source += 2;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8ToR8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
 
-		if (p_PosX < baseLinePosX && rightPos > baseLinePosX && p_PosY >= baseLinePosY)
-		{
-			//Split if we 'reach' into another skyline
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		p_Destination[pixelIndex] = K15_IACalculateLuma(p_Source[0], p_Source[1], p_Source[2]);
+		p_Source += 3;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8ToR8A8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		p_Destination[0] = K15_IACalculateLuma(p_Source[0], p_Source[1], p_Source[2]);
+		p_Destination[1] = 255;
+		p_Destination += 2;
+		p_Source += 3;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8ToR8G8B8A8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		p_Destination[0] = p_Source[0];
+		p_Destination[1] = p_Source[1];
+		p_Destination[2] = p_Source[2];
+		p_Destination[3] = 255;
+		p_Destination += 4;
+		p_Source += 3;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	kia_u8 luma = 0;
+
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		luma = K15_IACalculateLuma(p_Source[0], p_Source[1], p_Source[2]);
+		p_Destination[pixelIndex] = K15_IAMultiplyByAlpha(luma, p_Source[3]);
+		p_Source += 4;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8A8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		p_Destination[0] = K15_IACalculateLuma(p_Source[0], p_Source[1], p_Source[2]);
+		p_Destination[1] = p_Source[3];
+		p_Destination += 2;
+		p_Source += 4;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8G8B8(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+
+	for (pixelIndex = 0;
+		pixelIndex < p_NumPixels;
+		++pixelIndex)
+	{
+		p_Destination[0] = K15_IAMultiplyByAlpha(p_Source[0], p_Source[3]);
+		p_Destination[1] = K15_IAMultiplyByAlpha(p_Source[1], p_Source[3]);
+		p_Destination[2] = K15_IAMultiplyByAlpha(p_Source[2], p_Source[3]);
+		p_Destination += 3;
+		p_Source += 4;
+	}
+}
+/*********************************************************************************/
+#ifdef K15_IA_SSE2
+/*********************************************************************************/
+kia_internal __m128i K15_IACalculateLumaSSE2(__m128i p_Pixels)
+{
+	//p_Pixels contains 4 RGBA pixels, result contains the luma of each pixel in 32 bit lanes
+	__m128i mask = _mm_set1_epi32(0xFF);
+	__m128i red = _mm_and_si128(p_Pixels, mask);
+	__m128i green = _mm_and_si128(_mm_srli_epi32(p_Pixels, 8), mask);
+	__m128i blue = _mm_and_si128(_mm_srli_epi32(p_Pixels, 16), mask);
+	__m128i luma = _mm_add_epi32(_mm_mullo_epi16(red, _mm_set1_epi32(K15_IA_LUMA_WEIGHT_RED)),
+		_mm_mullo_epi16(green, _mm_set1_epi32(K15_IA_LUMA_WEIGHT_GREEN)));
+
+	luma = _mm_add_epi32(luma, _mm_mullo_epi16(blue, _mm_set1_epi32(K15_IA_LUMA_WEIGHT_BLUE)));
+	return _mm_srli_epi32(_mm_add_epi32(luma, _mm_set1_epi32(128)), 8);
+}
+/*********************************************************************************/
+kia_internal __m128i K15_IAMultiplyByAlphaSSE2(__m128i p_Values, __m128i p_Alphas)
+{
+	//works on 16 bit and 32 bit lanes (as long as the upper 16 bits are zero)
+	__m128i values = _mm_add_epi16(_mm_mullo_epi16(p_Values, p_Alphas), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(values, _mm_srli_epi16(values, 8)), 8);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8ToR8A8SSE2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	__m128i pixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		pixels = _mm_loadu_si128((__m128i*)(p_Source + pixelIndex));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 2), _mm_unpacklo_epi8(pixels, pixels));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 2 + 16), _mm_unpackhi_epi8(pixels, pixels));
+	}
+
+	K15_IAConvertRowR8ToR8A8(p_Destination + pixelIndex * 2, p_Source + pixelIndex, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8ToR8G8B8A8SSE2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	__m128i pixels;
+	__m128i pixelsLow;
+	__m128i pixelsHigh;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		pixels = _mm_loadu_si128((__m128i*)(p_Source + pixelIndex));
+		pixelsLow = _mm_unpacklo_epi8(pixels, pixels);
+		pixelsHigh = _mm_unpackhi_epi8(pixels, pixels);
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 4), _mm_unpacklo_epi16(pixelsLow, pixelsLow));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 4 + 16), _mm_unpackhi_epi16(pixelsLow, pixelsLow));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 4 + 32), _mm_unpacklo_epi16(pixelsHigh, pixelsHigh));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 4 + 48), _mm_unpackhi_epi16(pixelsHigh, pixelsHigh));
+	}
+
+	K15_IAConvertRowR8ToR8G8B8A8(p_Destination + pixelIndex * 4, p_Source + pixelIndex, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8A8ToR8SSE2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	__m128i mask = _mm_set1_epi16(0xFF);
+	__m128i pixels[2];
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		pixels[0] = _mm_loadu_si128((__m128i*)(p_Source + pixelIndex * 2));
+		pixels[1] = _mm_loadu_si128((__m128i*)(p_Source + pixelIndex * 2 + 16));
+		pixels[0] = K15_IAMultiplyByAlphaSSE2(_mm_and_si128(pixels[0], mask), _mm_srli_epi16(pixels[0], 8));
+		pixels[1] = K15_IAMultiplyByAlphaSSE2(_mm_and_si128(pixels[1], mask), _mm_srli_epi16(pixels[1], 8));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex), _mm_packus_epi16(pixels[0], pixels[1]));
+	}
+
+	K15_IAConvertRowR8A8ToR8(p_Destination + pixelIndex, p_Source + pixelIndex * 2, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8A8ToR8G8B8A8SSE2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	__m128i mask = _mm_set1_epi16(0xFF);
+	__m128i pixels;
+	__m128i red;
+
+	for (pixelIndex = 0;
+		pixelIndex + 8 <= p_NumPixels;
+		pixelIndex += 8)
+	{
+		//RA -> RR + RA = RRRA
+		pixels = _mm_loadu_si128((__m128i*)(p_Source + pixelIndex * 2));
+		red = _mm_and_si128(pixels, mask);
+		red = _mm_or_si128(red, _mm_slli_epi16(red, 8));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 4), _mm_unpacklo_epi16(red, pixels));
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 4 + 16), _mm_unpackhi_epi16(red, pixels));
+	}
+
+	K15_IAConvertRowR8A8ToR8G8B8A8(p_Destination + pixelIndex * 4, p_Source + pixelIndex * 2, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8SSE2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	kia_u32 blockIndex = 0;
+	__m128i pixels[4];
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		for (blockIndex = 0;
+			blockIndex < 4;
+			++blockIndex)
+		{
+			pixels[blockIndex] = _mm_loadu_si128((__m128i*)(p_Source + pixelIndex * 4 + blockIndex * 16));
+			pixels[blockIndex] = K15_IAMultiplyByAlphaSSE2(K15_IACalculateLumaSSE2(pixels[blockIndex]), 
+				_mm_srli_epi32(pixels[blockIndex], 24));
+		}
+
+		pixels[0] = _mm_packs_epi32(pixels[0], pixels[1]);
+		pixels[2] = _mm_packs_epi32(pixels[2], pixels[3]);
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex), _mm_packus_epi16(pixels[0], pixels[2]));
+	}
+
+	K15_IAConvertRowR8G8B8A8ToR8(p_Destination + pixelIndex, p_Source + pixelIndex * 4, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8A8SSE2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	kia_u32 blockIndex = 0;
+	__m128i pixels[2];
+
+	for (pixelIndex = 0;
+		pixelIndex + 8 <= p_NumPixels;
+		pixelIndex += 8)
+	{
+		for (blockIndex = 0;
+			blockIndex < 2;
+			++blockIndex)
+		{
+			pixels[blockIndex] = _mm_loadu_si128((__m128i*)(p_Source + pixelIndex * 4 + blockIndex * 16));
+			pixels[blockIndex] = _mm_or_si128(K15_IACalculateLumaSSE2(pixels[blockIndex]), 
+				_mm_slli_epi32(_mm_srli_epi32(pixels[blockIndex], 24), 8));
+
+			//sign extend, so _mm_packs_epi32 doesn't saturate
+			pixels[blockIndex] = _mm_srai_epi32(_mm_slli_epi32(pixels[blockIndex], 16), 16);
+		}
+
+		_mm_storeu_si128((__m128i*)(p_Destination + pixelIndex * 2), _mm_packs_epi32(pixels[0], pixels[1]));
+	}
+
+	K15_IAConvertRowR8G8B8A8ToR8A8(p_Destination + pixelIndex * 2, p_Source + pixelIndex * 4, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+# define K15_IA_CONVERT_ROW_R8_TO_R8A8 K15_IAConvertRowR8ToR8A8SSE2
+# define K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8 K15_IAConvertRowR8ToR8G8B8A8SSE2
+# define K15_IA_CONVERT_ROW_R8A8_TO_R8 K15_IAConvertRowR8A8ToR8SSE2
+# define K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8A8 K15_IAConvertRowR8A8ToR8G8B8A8SSE2
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8 K15_IAConvertRowR8G8B8A8ToR8SSE2
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8 K15_IAConvertRowR8G8B8A8ToR8A8SSE2
+#endif //K15_IA_SSE2
+/*********************************************************************************/
+#ifdef K15_IA_AVX2
+/*********************************************************************************/
+kia_internal __m256i K15_IACalculateLumaAVX2(__m256i p_Pixels)
+{
+	//p_Pixels contains 8 RGBA pixels, result contains the luma of each pixel in 32 bit lanes
+	__m256i mask = _mm256_set1_epi32(0xFF);
+	__m256i red = _mm256_and_si256(p_Pixels, mask);
+	__m256i green = _mm256_and_si256(_mm256_srli_epi32(p_Pixels, 8), mask);
+	__m256i blue = _mm256_and_si256(_mm256_srli_epi32(p_Pixels, 16), mask);
+	__m256i luma = _mm256_add_epi32(_mm256_mullo_epi16(red, _mm256_set1_epi32(K15_IA_LUMA_WEIGHT_RED)),
+		_mm256_mullo_epi16(green, _mm256_set1_epi32(K15_IA_LUMA_WEIGHT_GREEN)));
+
+	luma = _mm256_add_epi32(luma, _mm256_mullo_epi16(blue, _mm256_set1_epi32(K15_IA_LUMA_WEIGHT_BLUE)));
+	return _mm256_srli_epi32(_mm256_add_epi32(luma, _mm256_set1_epi32(128)), 8);
+}
+/*********************************************************************************/
+kia_internal __m256i K15_IAMultiplyByAlphaAVX2(__m256i p_Values, __m256i p_Alphas)
+{
+	__m256i values = _mm256_add_epi16(_mm256_mullo_epi16(p_Values, p_Alphas), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(values, _mm256_srli_epi16(values, 8)), 8);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8ToR8G8B8A8AVX2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	__m256i pixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 8 <= p_NumPixels;
+		pixelIndex += 8)
+	{
+		//R -> RRRR
+		pixels = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(p_Source + pixelIndex)));
+		pixels = _mm256_mullo_epi32(pixels, _mm256_set1_epi32(0x01010101));
+		_mm256_storeu_si256((__m256i*)(p_Destination + pixelIndex * 4), pixels);
+	}
+
+	K15_IAConvertRowR8ToR8G8B8A8(p_Destination + pixelIndex * 4, p_Source + pixelIndex, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8AVX2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	kia_u32 blockIndex = 0;
+	__m256i pixels[4];
+
+	for (pixelIndex = 0;
+		pixelIndex + 32 <= p_NumPixels;
+		pixelIndex += 32)
+	{
+		for (blockIndex = 0;
+			blockIndex < 4;
+			++blockIndex)
+		{
+			pixels[blockIndex] = _mm256_loadu_si256((__m256i*)(p_Source + pixelIndex * 4 + blockIndex * 32));
+			pixels[blockIndex] = K15_IAMultiplyByAlphaAVX2(K15_IACalculateLumaAVX2(pixels[blockIndex]), 
+				_mm256_srli_epi32(pixels[blockIndex], 24));
+		}
+
+		//packing works per 128 bit lane, so the pixels have to be put back in order afterwards
+		pixels[0] = _mm256_packs_epi32(pixels[0], pixels[1]);
+		pixels[2] = _mm256_packs_epi32(pixels[2], pixels[3]);
+		pixels[0] = _mm256_packus_epi16(pixels[0], pixels[2]);
+		pixels[0] = _mm256_permutevar8x32_epi32(pixels[0], _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+		_mm256_storeu_si256((__m256i*)(p_Destination + pixelIndex), pixels[0]);
+	}
+
+	K15_IAConvertRowR8G8B8A8ToR8(p_Destination + pixelIndex, p_Source + pixelIndex * 4, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8A8AVX2(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	kia_u32 blockIndex = 0;
+	__m256i pixels[2];
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		for (blockIndex = 0;
+			blockIndex < 2;
+			++blockIndex)
+		{
+			pixels[blockIndex] = _mm256_loadu_si256((__m256i*)(p_Source + pixelIndex * 4 + blockIndex * 32));
+			pixels[blockIndex] = _mm256_or_si256(K15_IACalculateLumaAVX2(pixels[blockIndex]), 
+				_mm256_slli_epi32(_mm256_srli_epi32(pixels[blockIndex], 24), 8));
+
+			//sign extend, so _mm256_packs_epi32 doesn't saturate
+			pixels[blockIndex] = _mm256_srai_epi32(_mm256_slli_epi32(pixels[blockIndex], 16), 16);
+		}
+
+		pixels[0] = _mm256_permute4x64_epi64(_mm256_packs_epi32(pixels[0], pixels[1]), 0xD8);
+		_mm256_storeu_si256((__m256i*)(p_Destination + pixelIndex * 2), pixels[0]);
+	}
+
+	K15_IAConvertRowR8G8B8A8ToR8A8(p_Destination + pixelIndex * 2, p_Source + pixelIndex * 4, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+# undef K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8
+# undef K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8
+# undef K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8
+# define K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8 K15_IAConvertRowR8ToR8G8B8A8AVX2
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8 K15_IAConvertRowR8G8B8A8ToR8AVX2
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8 K15_IAConvertRowR8G8B8A8ToR8A8AVX2
+#endif //K15_IA_AVX2
+/*********************************************************************************/
+#ifdef K15_IA_NEON
+/*********************************************************************************/
+kia_internal uint8x8_t K15_IACalculateLumaNEON(uint8x8_t p_Red, uint8x8_t p_Green, uint8x8_t p_Blue)
+{
+	uint16x8_t luma = vmull_u8(p_Red, vdup_n_u8(K15_IA_LUMA_WEIGHT_RED));
+	luma = vmlal_u8(luma, p_Green, vdup_n_u8(K15_IA_LUMA_WEIGHT_GREEN));
+	luma = vmlal_u8(luma, p_Blue, vdup_n_u8(K15_IA_LUMA_WEIGHT_BLUE));
+
+	return vrshrn_n_u16(luma, 8);
+}
+/*********************************************************************************/
+kia_internal uint8x16_t K15_IACalculateLumaQNEON(uint8x16_t p_Red, uint8x16_t p_Green, uint8x16_t p_Blue)
+{
+	return vcombine_u8(
+		K15_IACalculateLumaNEON(vget_low_u8(p_Red), vget_low_u8(p_Green), vget_low_u8(p_Blue)),
+		K15_IACalculateLumaNEON(vget_high_u8(p_Red), vget_high_u8(p_Green), vget_high_u8(p_Blue)));
+}
+/*********************************************************************************/
+kia_internal uint8x16_t K15_IAMultiplyByAlphaQNEON(uint8x16_t p_Values, uint8x16_t p_Alphas)
+{
+	uint16x8_t valuesLow = vmull_u8(vget_low_u8(p_Values), vget_low_u8(p_Alphas));
+	uint16x8_t valuesHigh = vmull_u8(vget_high_u8(p_Values), vget_high_u8(p_Alphas));
+
+	return vcombine_u8(
+		vrshrn_n_u16(vrsraq_n_u16(valuesLow, valuesLow, 8), 8),
+		vrshrn_n_u16(vrsraq_n_u16(valuesHigh, valuesHigh, 8), 8));
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8ToR8G8B8A8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x4_t destinationPixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		destinationPixels.val[0] = vld1q_u8(p_Source + pixelIndex);
+		destinationPixels.val[1] = destinationPixels.val[0];
+		destinationPixels.val[2] = destinationPixels.val[0];
+		destinationPixels.val[3] = destinationPixels.val[0];
+		vst4q_u8(p_Destination + pixelIndex * 4, destinationPixels);
+	}
+
+	K15_IAConvertRowR8ToR8G8B8A8(p_Destination + pixelIndex * 4, p_Source + pixelIndex, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8A8ToR8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x2_t sourcePixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		sourcePixels = vld2q_u8(p_Source + pixelIndex * 2);
+		vst1q_u8(p_Destination + pixelIndex, K15_IAMultiplyByAlphaQNEON(sourcePixels.val[0], sourcePixels.val[1]));
+	}
+
+	K15_IAConvertRowR8A8ToR8(p_Destination + pixelIndex, p_Source + pixelIndex * 2, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8A8ToR8G8B8A8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x2_t sourcePixels;
+	uint8x16x4_t destinationPixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		sourcePixels = vld2q_u8(p_Source + pixelIndex * 2);
+		destinationPixels.val[0] = sourcePixels.val[0];
+		destinationPixels.val[1] = sourcePixels.val[0];
+		destinationPixels.val[2] = sourcePixels.val[0];
+		destinationPixels.val[3] = sourcePixels.val[1];
+		vst4q_u8(p_Destination + pixelIndex * 4, destinationPixels);
+	}
+
+	K15_IAConvertRowR8A8ToR8G8B8A8(p_Destination + pixelIndex * 4, p_Source + pixelIndex * 2, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8ToR8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x3_t sourcePixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		sourcePixels = vld3q_u8(p_Source + pixelIndex * 3);
+		vst1q_u8(p_Destination + pixelIndex, 
+			K15_IACalculateLumaQNEON(sourcePixels.val[0], sourcePixels.val[1], sourcePixels.val[2]));
+	}
+
+	K15_IAConvertRowR8G8B8ToR8(p_Destination + pixelIndex, p_Source + pixelIndex * 3, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8ToR8G8B8A8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x3_t sourcePixels;
+	uint8x16x4_t destinationPixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		sourcePixels = vld3q_u8(p_Source + pixelIndex * 3);
+		destinationPixels.val[0] = sourcePixels.val[0];
+		destinationPixels.val[1] = sourcePixels.val[1];
+		destinationPixels.val[2] = sourcePixels.val[2];
+		destinationPixels.val[3] = vdupq_n_u8(255);
+		vst4q_u8(p_Destination + pixelIndex * 4, destinationPixels);
+	}
+
+	K15_IAConvertRowR8G8B8ToR8G8B8A8(p_Destination + pixelIndex * 4, p_Source + pixelIndex * 3, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x4_t sourcePixels;
+	uint8x16_t luma;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		sourcePixels = vld4q_u8(p_Source + pixelIndex * 4);
+		luma = K15_IACalculateLumaQNEON(sourcePixels.val[0], sourcePixels.val[1], sourcePixels.val[2]);
+		vst1q_u8(p_Destination + pixelIndex, K15_IAMultiplyByAlphaQNEON(luma, sourcePixels.val[3]));
+	}
+
+	K15_IAConvertRowR8G8B8A8ToR8(p_Destination + pixelIndex, p_Source + pixelIndex * 4, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8A8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x4_t sourcePixels;
+	uint8x16x2_t destinationPixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		sourcePixels = vld4q_u8(p_Source + pixelIndex * 4);
+		destinationPixels.val[0] = K15_IACalculateLumaQNEON(sourcePixels.val[0], sourcePixels.val[1], sourcePixels.val[2]);
+		destinationPixels.val[1] = sourcePixels.val[3];
+		vst2q_u8(p_Destination + pixelIndex * 2, destinationPixels);
+	}
+
+	K15_IAConvertRowR8G8B8A8ToR8A8(p_Destination + pixelIndex * 2, p_Source + pixelIndex * 4, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertRowR8G8B8A8ToR8G8B8NEON(kia_u8* p_Destination, kia_u8* p_Source, kia_u32 p_NumPixels)
+{
+	kia_u32 pixelIndex = 0;
+	uint8x16x4_t sourcePixels;
+	uint8x16x3_t destinationPixels;
+
+	for (pixelIndex = 0;
+		pixelIndex + 16 <= p_NumPixels;
+		pixelIndex += 16)
+	{
+		sourcePixels = vld4q_u8(p_Source + pixelIndex * 4);
+		destinationPixels.val[0] = K15_IAMultiplyByAlphaQNEON(sourcePixels.val[0], sourcePixels.val[3]);
+		destinationPixels.val[1] = K15_IAMultiplyByAlphaQNEON(sourcePixels.val[1], sourcePixels.val[3]);
+		destinationPixels.val[2] = K15_IAMultiplyByAlphaQNEON(sourcePixels.val[2], sourcePixels.val[3]);
+		vst3q_u8(p_Destination + pixelIndex * 3, destinationPixels);
+	}
+
+	K15_IAConvertRowR8G8B8A8ToR8G8B8(p_Destination + pixelIndex * 3, p_Source + pixelIndex * 4, p_NumPixels - pixelIndex);
+}
+/*********************************************************************************/
+# define K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8 K15_IAConvertRowR8ToR8G8B8A8NEON
+# define K15_IA_CONVERT_ROW_R8A8_TO_R8 K15_IAConvertRowR8A8ToR8NEON
+# define K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8A8 K15_IAConvertRowR8A8ToR8G8B8A8NEON
+# define K15_IA_CONVERT_ROW_R8G8B8_TO_R8 K15_IAConvertRowR8G8B8ToR8NEON
+# define K15_IA_CONVERT_ROW_R8G8B8_TO_R8G8B8A8 K15_IAConvertRowR8G8B8ToR8G8B8A8NEON
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8 K15_IAConvertRowR8G8B8A8ToR8NEON
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8 K15_IAConvertRowR8G8B8A8ToR8A8NEON
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8G8B8 K15_IAConvertRowR8G8B8A8ToR8G8B8NEON
+#endif //K15_IA_NEON
+/*********************************************************************************/
+//use the scalar versions for everything that doesn't have a SIMD version
+#ifndef K15_IA_CONVERT_ROW_R8_TO_R8A8
+# define K15_IA_CONVERT_ROW_R8_TO_R8A8 K15_IAConvertRowR8ToR8A8
+#endif //K15_IA_CONVERT_ROW_R8_TO_R8A8
+
+#ifndef K15_IA_CONVERT_ROW_R8_TO_R8G8B8
+# define K15_IA_CONVERT_ROW_R8_TO_R8G8B8 K15_IAConvertRowR8ToR8G8B8
+#endif //K15_IA_CONVERT_ROW_R8_TO_R8G8B8
+
+#ifndef K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8
+# define K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8 K15_IAConvertRowR8ToR8G8B8A8
+#endif //K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8
+
+#ifndef K15_IA_CONVERT_ROW_R8A8_TO_R8
+# define K15_IA_CONVERT_ROW_R8A8_TO_R8 K15_IAConvertRowR8A8ToR8
+#endif //K15_IA_CONVERT_ROW_R8A8_TO_R8
+
+#ifndef K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8
+# define K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8 K15_IAConvertRowR8A8ToR8G8B8
+#endif //K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8
+
+#ifndef K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8A8
+# define K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8A8 K15_IAConvertRowR8A8ToR8G8B8A8
+#endif //K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8A8
+
+#ifndef K15_IA_CONVERT_ROW_R8G8B8_TO_R8
+# define K15_IA_CONVERT_ROW_R8G8B8_TO_R8 K15_IAConvertRowR8G8B8ToR8
+#endif //K15_IA_CONVERT_ROW_R8G8B8_TO_R8
+
+#ifndef K15_IA_CONVERT_ROW_R8G8B8_TO_R8A8
+# define K15_IA_CONVERT_ROW_R8G8B8_TO_R8A8 K15_IAConvertRowR8G8B8ToR8A8
+#endif //K15_IA_CONVERT_ROW_R8G8B8_TO_R8A8
+
+#ifndef K15_IA_CONVERT_ROW_R8G8B8_TO_R8G8B8A8
+# define K15_IA_CONVERT_ROW_R8G8B8_TO_R8G8B8A8 K15_IAConvertRowR8G8B8ToR8G8B8A8
+#endif //K15_IA_CONVERT_ROW_R8G8B8_TO_R8G8B8A8
+
+#ifndef K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8 K15_IAConvertRowR8G8B8A8ToR8
+#endif //K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8
+
+#ifndef K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8 K15_IAConvertRowR8G8B8A8ToR8A8
+#endif //K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8
+
+#ifndef K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8G8B8
+# define K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8G8B8 K15_IAConvertRowR8G8B8A8ToR8G8B8
+#endif //K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8G8B8
+/*********************************************************************************/
+kia_internal K15_IAConvertRowFnc K15_IAGetConvertRowFnc(K15_IAPixelFormat p_SourcePixelFormat, 
+	K15_IAPixelFormat p_DestinationPixelFormat)
+{
+	//indexed by [source pixel format - 1][destination pixel format - 1]
+	static const K15_IAConvertRowFnc convertRowFncs[4][4] = {
+		{0, K15_IA_CONVERT_ROW_R8_TO_R8A8, K15_IA_CONVERT_ROW_R8_TO_R8G8B8, K15_IA_CONVERT_ROW_R8_TO_R8G8B8A8},
+		{K15_IA_CONVERT_ROW_R8A8_TO_R8, 0, K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8, K15_IA_CONVERT_ROW_R8A8_TO_R8G8B8A8},
+		{K15_IA_CONVERT_ROW_R8G8B8_TO_R8, K15_IA_CONVERT_ROW_R8G8B8_TO_R8A8, 0, K15_IA_CONVERT_ROW_R8G8B8_TO_R8G8B8A8},
+		{K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8, K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8A8, K15_IA_CONVERT_ROW_R8G8B8A8_TO_R8G8B8, 0}
+	};
+
+	return convertRowFncs[p_SourcePixelFormat - 1][p_DestinationPixelFormat - 1];
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAReallocateArray(K15_ImageAtlas* p_ImageAtlas, void** p_ArrayInOut,
+	kia_u32 p_ElementSizeInBytes, kia_u32 p_NumElements)
+{
+	void* newArray = p_ImageAtlas->reallocFnc(*p_ArrayInOut, p_ElementSizeInBytes * p_NumElements, 
+		p_ImageAtlas->allocatorUserData);
+
+	if (!newArray)
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+
+	*p_ArrayInOut = newArray;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculateGrownCapacity(kia_u32 p_Capacity, kia_u32 p_MinCapacity)
+{
+	kia_u32 capacity = K15_IA_MAX(p_Capacity, 8);
+
+	while (capacity < p_MinCapacity)
+		capacity = capacity << 1;
+
+	return capacity;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAReserveImageNodes(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumImageNodes)
+{
+	kia_u32 capacity = p_ImageAtlas->numMaxImageNodes;
+	void* imageNodes = p_ImageAtlas->imageNodes;
+
+	if (p_NumImageNodes <= capacity)
+		return K15_IA_RESULT_SUCCESS;
+
+	if ((p_ImageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) == 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	capacity = K15_IACalculateGrownCapacity(capacity << 1, p_NumImageNodes);
+
+	if (K15_IAReallocateArray(p_ImageAtlas, &imageNodes, sizeof(K15_IAImageNode), capacity) != K15_IA_RESULT_SUCCESS)
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+
+	p_ImageAtlas->imageNodes = (K15_IAImageNode*)imageNodes;
+	p_ImageAtlas->numMaxImageNodes = capacity;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAReserveSkylines(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumSkylines)
+{
+	kia_u32 capacity = p_ImageAtlas->numMaxSkylines;
+	void* skylines = p_ImageAtlas->skylines;
+	void* skylineWindowIndices = p_ImageAtlas->skylineWindowIndices;
+
+	if (p_NumSkylines <= capacity)
+		return K15_IA_RESULT_SUCCESS;
+
+	if ((p_ImageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) == 0)
+		return K15_IA_RESULT_TOO_FEW_SKYLINES;
+
+	capacity = K15_IACalculateGrownCapacity(capacity << 1, p_NumSkylines);
+
+	if (K15_IAReallocateArray(p_ImageAtlas, &skylines, sizeof(K15_IASkyline), capacity) != K15_IA_RESULT_SUCCESS)
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+
+	p_ImageAtlas->skylines = (K15_IASkyline*)skylines;
+
+	if (K15_IAReallocateArray(p_ImageAtlas, &skylineWindowIndices, sizeof(kia_u32), capacity) != K15_IA_RESULT_SUCCESS)
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+
+	p_ImageAtlas->skylineWindowIndices = (kia_u32*)skylineWindowIndices;
+	p_ImageAtlas->numMaxSkylines = capacity;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAReserveWastedSpaceRects(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumWastedSpaceRects)
+{
+	kia_u32 capacity = p_ImageAtlas->numMaxWastedSpaceRects;
+	void* wastedSpaceRects = p_ImageAtlas->wastedSpaceRects;
+	void* wastedSpaceRectLinks = p_ImageAtlas->wastedSpaceRectLinks;
+
+	if (p_NumWastedSpaceRects <= capacity)
+		return K15_IA_RESULT_SUCCESS;
+
+	if ((p_ImageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) == 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	capacity = K15_IACalculateGrownCapacity(capacity << 1, p_NumWastedSpaceRects);
+
+	if (K15_IAReallocateArray(p_ImageAtlas, &wastedSpaceRects, sizeof(K15_IARect), capacity) != K15_IA_RESULT_SUCCESS)
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+
+	p_ImageAtlas->wastedSpaceRects = (K15_IARect*)wastedSpaceRects;
+
+	if (K15_IAReallocateArray(p_ImageAtlas, &wastedSpaceRectLinks, sizeof(K15_IARectLink), capacity) != K15_IA_RESULT_SUCCESS)
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+
+	p_ImageAtlas->wastedSpaceRectLinks = (K15_IARectLink*)wastedSpaceRectLinks;
+	p_ImageAtlas->numMaxWastedSpaceRects = capacity;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IARemoveSkylineByIndex(K15_IASkyline* p_Skylines, kia_u32 p_NumSkylines,
+	kia_u32 p_SkylineIndex)
+{
+	kia_u32 numSkylines = p_NumSkylines;
+	kia_u32 numSkylinesToMove = 0;
+
+	if (p_SkylineIndex + 1 < numSkylines)
+	{
+		numSkylinesToMove = numSkylines - p_SkylineIndex - 1;
+		K15_IA_MEMMOVE(p_Skylines + p_SkylineIndex, p_Skylines + p_SkylineIndex + 1,
+			numSkylinesToMove * sizeof(K15_IASkyline));
+	}
+
+	return --numSkylines;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculateSizeClass(kia_u32 p_Value)
+{
+	kia_u32 sizeClass = 0;
+
+	while (p_Value > 1 && sizeClass + 1 < K15_IA_NUM_SIZE_CLASSES)
+	{
+		p_Value = p_Value >> 1;
+		++sizeClass;
+	}
+
+	return sizeClass;
+}
+/*********************************************************************************/
+kia_internal kia_u32* K15_IAGetWastedSpaceRectBucket(K15_ImageAtlas* p_ImageAtlas, K15_IARect* p_WastedSpaceRect)
+{
+	kia_u32 widthClass = K15_IACalculateSizeClass(p_WastedSpaceRect->width);
+	kia_u32 heightClass = K15_IACalculateSizeClass(p_WastedSpaceRect->height);
+
+	return p_ImageAtlas->wastedSpaceRectBuckets + widthClass * K15_IA_NUM_SIZE_CLASSES + heightClass;
+}
+/*********************************************************************************/
+kia_internal void K15_IALinkWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Index)
+{
+	kia_u32* bucket = K15_IAGetWastedSpaceRectBucket(p_ImageAtlas, p_ImageAtlas->wastedSpaceRects + p_Index);
+	K15_IARectLink* links = p_ImageAtlas->wastedSpaceRectLinks;
+
+	links[p_Index].previousIndex = K15_IA_INVALID_INDEX;
+	links[p_Index].nextIndex = *bucket;
+
+	if (*bucket != K15_IA_INVALID_INDEX)
+		links[*bucket].previousIndex = p_Index;
+
+	*bucket = p_Index;
+}
+/*********************************************************************************/
+kia_internal void K15_IAUnlinkWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Index)
+{
+	K15_IARectLink* links = p_ImageAtlas->wastedSpaceRectLinks;
+	K15_IARectLink* link = links + p_Index;
+
+	if (link->previousIndex == K15_IA_INVALID_INDEX)
+		*K15_IAGetWastedSpaceRectBucket(p_ImageAtlas, p_ImageAtlas->wastedSpaceRects + p_Index) = link->nextIndex;
+	else
+		links[link->previousIndex].nextIndex = link->nextIndex;
+
+	if (link->nextIndex != K15_IA_INVALID_INDEX)
+		links[link->nextIndex].previousIndex = link->previousIndex;
+}
+/*********************************************************************************/
+kia_internal void K15_IARemoveWastedSpaceRectByIndex(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Index);
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAFindAdjacentWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, K15_IARect* p_Rect)
+{
+	kia_u32 widthClass = K15_IACalculateSizeClass(p_Rect->width);
+	kia_u32 heightClass = K15_IACalculateSizeClass(p_Rect->height);
+	kia_u32 sizeClass = 0;
+	kia_u32 rectIndex = 0;
+	K15_IARect* wastedSpaceRect = 0;
+
+	//rects that share the complete left or right edge have the same height and are
+	//therefore in the same row of buckets...
+	for (sizeClass = 0;
+		sizeClass < K15_IA_NUM_SIZE_CLASSES;
+		++sizeClass)
+	{
+		rectIndex = p_ImageAtlas->wastedSpaceRectBuckets[sizeClass * K15_IA_NUM_SIZE_CLASSES + heightClass];
+
+		while (rectIndex != K15_IA_INVALID_INDEX)
+		{
+			wastedSpaceRect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+
+			if (wastedSpaceRect->posY == p_Rect->posY && wastedSpaceRect->height == p_Rect->height &&
+				(wastedSpaceRect->posX + wastedSpaceRect->width == p_Rect->posX || 
+				p_Rect->posX + p_Rect->width == wastedSpaceRect->posX))
+			{
+				return rectIndex;
+			}
+
+			rectIndex = p_ImageAtlas->wastedSpaceRectLinks[rectIndex].nextIndex;
+		}
+	}
+
+	//...and rects that share the complete top or bottom edge are in the same column
+	for (sizeClass = 0;
+		sizeClass < K15_IA_NUM_SIZE_CLASSES;
+		++sizeClass)
+	{
+		rectIndex = p_ImageAtlas->wastedSpaceRectBuckets[widthClass * K15_IA_NUM_SIZE_CLASSES + sizeClass];
+
+		while (rectIndex != K15_IA_INVALID_INDEX)
+		{
+			wastedSpaceRect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+
+			if (wastedSpaceRect->posX == p_Rect->posX && wastedSpaceRect->width == p_Rect->width &&
+				(wastedSpaceRect->posY + wastedSpaceRect->height == p_Rect->posY || 
+				p_Rect->posY + p_Rect->height == wastedSpaceRect->posY))
+			{
+				return rectIndex;
+			}
+
+			rectIndex = p_ImageAtlas->wastedSpaceRectLinks[rectIndex].nextIndex;
+		}
+	}
+
+	return K15_IA_INVALID_INDEX;
+}
+/*********************************************************************************/
+kia_internal void K15_IAInsertWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_PosX, kia_u32 p_PosY,
+	kia_u32 p_Width, kia_u32 p_Height)
+{
+	kia_u32 rectIndex = p_ImageAtlas->numWastedSpaceRects;
+	K15_IARect* newRect = 0;
+
+	if (p_Width == 0 || p_Height == 0)
+		return;
+
+	//the space is lost if we can't keep track of it
+	if (K15_IAReserveWastedSpaceRects(p_ImageAtlas, rectIndex + 1) != K15_IA_RESULT_SUCCESS)
+		return;
+
+	newRect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+	newRect->posX = (kia_u16)p_PosX;
+	newRect->posY = (kia_u16)p_PosY;
+	newRect->width = (kia_u16)p_Width;
+	newRect->height = (kia_u16)p_Height;
+
+	K15_IALinkWastedSpaceRect(p_ImageAtlas, rectIndex);
+	++p_ImageAtlas->numWastedSpaceRects;
+}
+/*********************************************************************************/
+kia_internal void K15_IAAddWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_PosX, kia_u32 p_PosY,
+	kia_u32 p_Width, kia_u32 p_Height)
+{
+	kia_u32 adjacentRectIndex = 0;
+	K15_IARect newRect;
+	K15_IARect adjacentRect;
+
+	//nothing can be placed in here
+	if (p_Width == 0 || p_Height == 0)
+		return;
+
+	newRect.posX = p_PosX;
+	newRect.posY = p_PosY;
+	newRect.width = p_Width;
+	newRect.height = p_Height;
+
+	//merge the new rect with all rects that share a complete edge with it. This keeps the
+	//number of rects down and creates bigger rects that can be reused by bigger images.
+	while ((adjacentRectIndex = K15_IAFindAdjacentWastedSpaceRect(p_ImageAtlas, &newRect)) != K15_IA_INVALID_INDEX)
+	{
+		adjacentRect = p_ImageAtlas->wastedSpaceRects[adjacentRectIndex];
+		K15_IARemoveWastedSpaceRectByIndex(p_ImageAtlas, adjacentRectIndex);
+
+		if (adjacentRect.posY == newRect.posY && adjacentRect.height == newRect.height)
+		{
+			newRect.posX = K15_IA_MIN(newRect.posX, adjacentRect.posX);
+			newRect.width = newRect.width + adjacentRect.width;
+		}
+		else
+		{
+			newRect.posY = K15_IA_MIN(newRect.posY, adjacentRect.posY);
+			newRect.height = newRect.height + adjacentRect.height;
+		}
+	}
+
+	K15_IAInsertWastedSpaceRect(p_ImageAtlas, newRect.posX, newRect.posY, newRect.width, newRect.height);
+}
+/*********************************************************************************/
+kia_internal void K15_IAMoveWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_FromIndex, kia_u32 p_ToIndex)
+{
+	//p_ToIndex has to be unlinked already
+	K15_IAUnlinkWastedSpaceRect(p_ImageAtlas, p_FromIndex);
+	p_ImageAtlas->wastedSpaceRects[p_ToIndex] = p_ImageAtlas->wastedSpaceRects[p_FromIndex];
+	K15_IALinkWastedSpaceRect(p_ImageAtlas, p_ToIndex);
+}
+/*********************************************************************************/
+kia_internal void K15_IARemoveWastedSpaceRectByIndex(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Index)
+{
+	kia_u32 lastIndex = p_ImageAtlas->numWastedSpaceRects - 1;
+
+	K15_IAUnlinkWastedSpaceRect(p_ImageAtlas, p_Index);
+
+	//move the last rect into the free slot, so we don't have to shift the whole array
+	if (p_Index != lastIndex)
+		K15_IAMoveWastedSpaceRect(p_ImageAtlas, lastIndex, p_Index);
+
+	p_ImageAtlas->numWastedSpaceRects = lastIndex;
+}
+/*********************************************************************************/
+kia_internal void K15_IARemoveContainedWastedSpaceRects(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_FirstIndex)
+{
+	kia_u32 rectIndex = p_FirstIndex;
+	kia_u32 otherRectIndex = 0;
+	kia_b8 contained = K15_IA_FALSE;
+
+	K15_IARect* rect = 0;
+	K15_IARect* otherRect = 0;
+
+	//remove all rects starting at p_FirstIndex that lie completely inside another rect
+	while (rectIndex < p_ImageAtlas->numWastedSpaceRects)
+	{
+		rect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+		contained = K15_IA_FALSE;
+
+		for (otherRectIndex = 0;
+			otherRectIndex < p_ImageAtlas->numWastedSpaceRects;
+			++otherRectIndex)
+		{
+			otherRect = p_ImageAtlas->wastedSpaceRects + otherRectIndex;
+
+			if (otherRectIndex != rectIndex && 
+				otherRect->posX <= rect->posX && otherRect->posY <= rect->posY &&
+				otherRect->posX + otherRect->width >= rect->posX + rect->width &&
+				otherRect->posY + otherRect->height >= rect->posY + rect->height)
+			{
+				contained = K15_IA_TRUE;
+				break;
+			}
+		}
+
+		//the last rect gets moved into this slot and has to be checked, too
+		if (contained)
+			K15_IARemoveWastedSpaceRectByIndex(p_ImageAtlas, rectIndex);
+		else
+			++rectIndex;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IASplitWastedSpaceRects(K15_ImageAtlas* p_ImageAtlas, K15_IARect* p_UsedRect,
+	kia_b8 p_MaximalRects)
+{
+	kia_u32 usedPosX = p_UsedRect->posX;
+	kia_u32 usedPosY = p_UsedRect->posY;
+	kia_u32 usedRightPos = usedPosX + p_UsedRect->width;
+	kia_u32 usedTopPos = usedPosY + p_UsedRect->height;
+	kia_u32 numRectsToCheck = p_ImageAtlas->numWastedSpaceRects;
+	kia_u32 rectIndex = 0;
+	kia_u32 lastIndex = 0;
+	kia_u32 rectRightPos = 0;
+	kia_u32 rectTopPos = 0;
+	kia_u32 innerLeftPos = 0;
+	kia_u32 innerRightPos = 0;
+	K15_IARect rect;
+
+	//Every rect that overlaps the used rect gets replaced by the (up to 4) parts of it that
+	//are left and right of, below and above the used rect. The new rects get appended and
+	//are kept behind the rects that still have to be checked.
+	while (rectIndex < numRectsToCheck)
+	{
+		rect = p_ImageAtlas->wastedSpaceRects[rectIndex];
+		rectRightPos = rect.posX + rect.width;
+		rectTopPos = rect.posY + rect.height;
+
+		if (rect.posX >= usedRightPos || rectRightPos <= usedPosX ||
+			rect.posY >= usedTopPos || rectTopPos <= usedPosY)
+		{
+			++rectIndex;
+			continue;
+		}
+
+		lastIndex = p_ImageAtlas->numWastedSpaceRects - 1;
+		--numRectsToCheck;
+
+		K15_IAUnlinkWastedSpaceRect(p_ImageAtlas, rectIndex);
+
+		if (rectIndex != numRectsToCheck)
+			K15_IAMoveWastedSpaceRect(p_ImageAtlas, numRectsToCheck, rectIndex);
+
+		if (numRectsToCheck != lastIndex)
+			K15_IAMoveWastedSpaceRect(p_ImageAtlas, lastIndex, numRectsToCheck);
+
+		p_ImageAtlas->numWastedSpaceRects = lastIndex;
+
+		//maximal rects span the whole width of the old rect (and overlap the left and 
+		//right part), otherwise the parts below and above are as wide as the used rect
+		innerLeftPos = p_MaximalRects ? rect.posX : K15_IA_MAX(rect.posX, usedPosX);
+		innerRightPos = p_MaximalRects ? rectRightPos : K15_IA_MIN(rectRightPos, usedRightPos);
+
+		if (usedPosX > rect.posX)
+			K15_IAInsertWastedSpaceRect(p_ImageAtlas, rect.posX, rect.posY, usedPosX - rect.posX, rect.height);
+
+		if (rectRightPos > usedRightPos)
+			K15_IAInsertWastedSpaceRect(p_ImageAtlas, usedRightPos, rect.posY, rectRightPos - usedRightPos, rect.height);
+
+		if (usedPosY > rect.posY)
+		{
+			K15_IAInsertWastedSpaceRect(p_ImageAtlas, innerLeftPos, rect.posY, innerRightPos - innerLeftPos, 
+				usedPosY - rect.posY);
+		}
+
+		if (rectTopPos > usedTopPos)
+		{
+			K15_IAInsertWastedSpaceRect(p_ImageAtlas, innerLeftPos, usedTopPos, innerRightPos - innerLeftPos, 
+				rectTopPos - usedTopPos);
+		}
+	}
+
+	//new maximal rects might be part of other rects
+	if (p_MaximalRects)
+		K15_IARemoveContainedWastedSpaceRects(p_ImageAtlas, numRectsToCheck);
+}
+/*********************************************************************************/
+kia_internal void K15_IAFindWastedSpaceAndRemoveObscuredSkylines(K15_ImageAtlas* p_ImageAtlas,
+	kia_u32 p_PosX, kia_u32 p_PosY, kia_u32 p_Width)
+{
+	K15_IASkyline* skylines = p_ImageAtlas->skylines;
+
+	kia_u32 baseLinePosX = 0;
+	kia_u32 baseLinePosY = 0;
+	kia_u32 baseLineWidth = 0;
+	kia_u32 rightPos = p_PosX + p_Width;
+	kia_u32 baseLineRightPos = 0;
+	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
+	kia_u32 skylineIndex = 0;
+	K15_IASkyline* skyline = 0;
+
+	for (skylineIndex = 0;
+		skylineIndex < numSkylines;
+		++skylineIndex)
+	{
+		skyline = skylines + skylineIndex;
+		baseLinePosX = skyline->baseLinePosX;
+		baseLinePosY = skyline->baseLinePosY;
+		baseLineWidth = skyline->baseLineWidth;
+
+		if (p_PosX < baseLinePosX && rightPos > baseLinePosX && p_PosY >= baseLinePosY)
+		{
+			//Split if we 'reach' into another skyline
 			//check first if the current skyline is fully obscured
 			baseLineRightPos = baseLinePosX + baseLineWidth;
 
-			if (rightPos < baseLineRightPos)
-			{
-				numWastedSpaceRects = K15_IAAddWastedSpaceRect(p_WastedSpaceRects, numWastedSpaceRects,
-					baseLinePosX, baseLinePosY, rightPos - baseLinePosX, p_PosY - baseLinePosY);
+			if (rightPos < baseLineRightPos)
+			{
+				K15_IAAddWastedSpaceRect(p_ImageAtlas, baseLinePosX, baseLinePosY, 
+					rightPos - baseLinePosX, p_PosY - baseLinePosY);
+
+				skyline->baseLineWidth = baseLineRightPos - rightPos;
+				skyline->baseLinePosX = rightPos;
+				continue;
+			}
+
+			numSkylines = K15_IARemoveSkylineByIndex(skylines, numSkylines, skylineIndex);
+			K15_IAAddWastedSpaceRect(p_ImageAtlas, baseLinePosX, baseLinePosY, 
+				baseLineWidth, p_PosY - baseLinePosY);
+
+			--skylineIndex;
+		}
+	}
+
+	p_ImageAtlas->numSkylines = numSkylines;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAFindSkylineInsertIndex(K15_IASkyline* p_Skylines, kia_u32 p_NumSkylines,
+	kia_u32 p_BaseLineX)
+{
+	kia_u32 lowerIndex = 0;
+	kia_u32 upperIndex = p_NumSkylines;
+	kia_u32 middleIndex = 0;
+
+	//binary search for the first skyline that starts right of p_BaseLineX
+	while (lowerIndex < upperIndex)
+	{
+		middleIndex = lowerIndex + (upperIndex - lowerIndex) / 2;
+
+		if (p_Skylines[middleIndex].baseLinePosX <= p_BaseLineX)
+			lowerIndex = middleIndex + 1;
+		else
+			upperIndex = middleIndex;
+	}
+
+	return lowerIndex;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IATryToInsertSkyline(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_BaseLineY,
+	kia_u32 p_BaseLineX, kia_u32 p_BaseLineWidth)
+{
+	K15_IASkyline* skylines = p_ImageAtlas->skylines;
+	K15_IASkyline* newSkyline = 0;
+	K15_IASkyline* previousSkyline = 0;
+	K15_IASkyline* nextSkyline = 0;
+
+	kia_result result = K15_IA_RESULT_SUCCESS;
+	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
+	kia_u32 insertIndex = K15_IAFindSkylineInsertIndex(skylines, numSkylines, p_BaseLineX);
+
+	previousSkyline = insertIndex > 0 ? skylines + insertIndex - 1 : 0;
+	nextSkyline = insertIndex < numSkylines ? skylines + insertIndex : 0;
+
+	//try to merge with the left neighbor if it has the same baseline (y pos)
+	if (previousSkyline && previousSkyline->baseLinePosY == p_BaseLineY &&
+		previousSkyline->baseLinePosX + previousSkyline->baseLineWidth == p_BaseLineX)
+	{
+		previousSkyline->baseLineWidth += p_BaseLineWidth;
+
+		//the new skyline might close the gap between the left and right neighbor
+		if (nextSkyline && nextSkyline->baseLinePosY == p_BaseLineY &&
+			nextSkyline->baseLinePosX == p_BaseLineX + p_BaseLineWidth)
+		{
+			previousSkyline->baseLineWidth += nextSkyline->baseLineWidth;
+			p_ImageAtlas->numSkylines = K15_IARemoveSkylineByIndex(skylines, numSkylines, insertIndex);
+		}
+
+		return K15_IA_RESULT_SUCCESS;
+	}
+
+	//try to merge with the right neighbor if it has the same baseline (y pos)
+	if (nextSkyline && nextSkyline->baseLinePosY == p_BaseLineY &&
+		nextSkyline->baseLinePosX == p_BaseLineX + p_BaseLineWidth)
+	{
+		nextSkyline->baseLinePosX = p_BaseLineX;
+		nextSkyline->baseLineWidth += p_BaseLineWidth;
+
+		return K15_IA_RESULT_SUCCESS;
+	}
+
+	result = K15_IAReserveSkylines(p_ImageAtlas, numSkylines + 1);
+
+	if (result != K15_IA_RESULT_SUCCESS)
+		return result;
+
+	skylines = p_ImageAtlas->skylines;
+
+	//make room for the new skyline so the skylines stay sorted by x position
+	if (insertIndex < numSkylines)
+	{
+		K15_IA_MEMMOVE(skylines + insertIndex + 1, skylines + insertIndex,
+			(numSkylines - insertIndex) * sizeof(K15_IASkyline));
+	}
+
+	newSkyline = skylines + insertIndex;
+	newSkyline->baseLinePosX = p_BaseLineX;
+	newSkyline->baseLinePosY = p_BaseLineY;
+	newSkyline->baseLineWidth = p_BaseLineWidth;
+
+	p_ImageAtlas->numSkylines = numSkylines + 1;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IAIsBlockCompressedPixelFormat(K15_IAPixelFormat p_PixelFormat)
+{
+	return p_PixelFormat >= KIA_PIXEL_FORMAT_BC1;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAGetBlockSizeInBytes(K15_IAPixelFormat p_PixelFormat)
+{
+	return (p_PixelFormat == KIA_PIXEL_FORMAT_BC1 || p_PixelFormat == KIA_PIXEL_FORMAT_BC4) ? 8 : 16;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculatePixelDataSizeInBytes(kia_u32 p_Width, kia_u32 p_Height,
+	K15_IAPixelFormat p_PixelFormat)
+{
+	if (K15_IAIsBlockCompressedPixelFormat(p_PixelFormat))
+	{
+		return ((p_Width + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION) * 
+			((p_Height + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION) * 
+			K15_IAGetBlockSizeInBytes(p_PixelFormat);
+	}
+
+	return p_Width * p_Height * p_PixelFormat;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculateRowOffsetInBytes(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
+	kia_u32 p_Row)
+{
+	//rows of block compressed formats are stored in groups of 4 (one row of blocks)
+	if (K15_IAIsBlockCompressedPixelFormat(p_PixelFormat))
+	{
+		return (p_Row / K15_IA_BLOCK_DIMENSION) * 
+			K15_IACalculatePixelDataSizeInBytes(p_ImageAtlas->width, K15_IA_BLOCK_DIMENSION, p_PixelFormat);
+	}
+
+	return p_Row * p_ImageAtlas->width * p_PixelFormat;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAAlignDimension(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Dimension)
+{
+	kia_u32 alignment = K15_IA_MAX(p_ImageAtlas->alignment, 1);
+
+	return (p_Dimension + alignment - 1) & ~(alignment - 1);
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IAIsMaxRectsPacker(K15_IAPacker p_Packer)
+{
+	return p_Packer == KIA_PACKER_MAX_RECTS_BEST_SHORT_SIDE_FIT || p_Packer == KIA_PACKER_MAX_RECTS_BEST_AREA_FIT ||
+		p_Packer == KIA_PACKER_MAX_RECTS_CONTACT_POINT;
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IAUsesSkylines(K15_ImageAtlas* p_ImageAtlas)
+{
+	//all other packers track the free space using the wasted space rects only
+	return p_ImageAtlas->packer == KIA_PACKER_SKYLINE || p_ImageAtlas->packer == KIA_PACKER_SHELF;
+}
+/*********************************************************************************/
+kia_internal void K15_IAAddGrownGuillotineStrip(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_OldEdge, 
+	kia_u32 p_NewEdge, kia_u32 p_Length, kia_b8 p_RightOfAtlas)
+{
+	kia_u32 rectIndex = 0;
+	kia_u32 position = 0;
+	kia_u32 nextPosition = 0;
+	kia_u32 rectStart = 0;
+	kia_u32 rectEnd = 0;
+	kia_u32 rectNear = 0;
+	kia_u32 rectFar = 0;
+	kia_b8 coveredByRect = K15_IA_FALSE;
+	K15_IARect* rect = 0;
+
+	//rects that touch the old border grow into the new strip. Otherwise a fine grow step would
+	//leave lots of thin strips that are never wide enough to hold an image.
+	for (rectIndex = 0;
+		rectIndex < p_ImageAtlas->numWastedSpaceRects;
+		++rectIndex)
+	{
+		rect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+		rectEnd = p_RightOfAtlas ? rect->posY + rect->height : rect->posX + rect->width;
+		rectFar = p_RightOfAtlas ? rect->posX + rect->width : rect->posY + rect->height;
+
+		if (rectFar != p_OldEdge || rectEnd > p_Length)
+			continue;
+
+		K15_IAUnlinkWastedSpaceRect(p_ImageAtlas, rectIndex);
+
+		if (p_RightOfAtlas)
+			rect->width = (kia_u16)(p_NewEdge - rect->posX);
+		else
+			rect->height = (kia_u16)(p_NewEdge - rect->posY);
+
+		K15_IALinkWastedSpaceRect(p_ImageAtlas, rectIndex);
+	}
+
+	//the parts of the strip that are not covered by a grown rect are new rects
+	while (position < p_Length)
+	{
+		nextPosition = p_Length;
+		coveredByRect = K15_IA_FALSE;
+
+		for (rectIndex = 0;
+			rectIndex < p_ImageAtlas->numWastedSpaceRects;
+			++rectIndex)
+		{
+			rect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+			rectStart = p_RightOfAtlas ? rect->posY : rect->posX;
+			rectEnd = p_RightOfAtlas ? rect->posY + rect->height : rect->posX + rect->width;
+			rectNear = p_RightOfAtlas ? rect->posX : rect->posY;
+			rectFar = p_RightOfAtlas ? rect->posX + rect->width : rect->posY + rect->height;
+
+			if (rectFar != p_NewEdge || rectNear >= p_OldEdge || rectEnd > p_Length)
+				continue;
+
+			if (rectStart == position)
+			{
+				nextPosition = rectEnd;
+				coveredByRect = K15_IA_TRUE;
+				break;
+			}
+
+			if (rectStart > position && rectStart < nextPosition)
+				nextPosition = rectStart;
+		}
+
+		if (!coveredByRect)
+		{
+			if (p_RightOfAtlas)
+				K15_IAInsertWastedSpaceRect(p_ImageAtlas, p_OldEdge, position, p_NewEdge - p_OldEdge, nextPosition - position);
+			else
+				K15_IAInsertWastedSpaceRect(p_ImageAtlas, position, p_OldEdge, nextPosition - position, p_NewEdge - p_OldEdge);
+		}
+
+		position = nextPosition;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAAddGrownAtlasArea(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_OldWidth, kia_u32 p_OldHeight)
+{
+	kia_u32 width = p_ImageAtlas->width;
+	kia_u32 height = p_ImageAtlas->height;
+	kia_u32 rectIndex = 0;
+	K15_IARect* rect = 0;
+
+	if (!K15_IAIsMaxRectsPacker(p_ImageAtlas->packer))
+	{
+		//split the new area into two disjoint strips, the corner belongs to the bottom strip
+		if (width > p_OldWidth)
+			K15_IAAddGrownGuillotineStrip(p_ImageAtlas, p_OldWidth, width, p_OldHeight, K15_IA_TRUE);
+
+		if (height > p_OldHeight)
+			K15_IAAddGrownGuillotineStrip(p_ImageAtlas, p_OldHeight, height, width, K15_IA_FALSE);
+
+		return;
+	}
+
+	//maximal rects that touch the old border grow into the new area...
+	for (rectIndex = 0;
+		rectIndex < p_ImageAtlas->numWastedSpaceRects;
+		++rectIndex)
+	{
+		rect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+
+		if (rect->posX + rect->width != p_OldWidth && rect->posY + rect->height != p_OldHeight)
+			continue;
+
+		K15_IAUnlinkWastedSpaceRect(p_ImageAtlas, rectIndex);
+
+		if (rect->posX + rect->width == p_OldWidth)
+			rect->width = (kia_u16)(width - rect->posX);
+
+		if (rect->posY + rect->height == p_OldHeight)
+			rect->height = (kia_u16)(height - rect->posY);
+
+		K15_IALinkWastedSpaceRect(p_ImageAtlas, rectIndex);
+	}
+
+	//...and the new area is covered by two overlapping rects
+	if (width > p_OldWidth)
+		K15_IAInsertWastedSpaceRect(p_ImageAtlas, p_OldWidth, 0, width - p_OldWidth, height);
+
+	if (height > p_OldHeight)
+		K15_IAInsertWastedSpaceRect(p_ImageAtlas, 0, p_OldHeight, width, height - p_OldHeight);
+
+	K15_IARemoveContainedWastedSpaceRects(p_ImageAtlas, 0);
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAResizeAtlas(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Width, kia_u32 p_Height)
+{
+	kia_u32 oldWidth = p_ImageAtlas->width;
+	kia_u32 oldHeight = p_ImageAtlas->height;
+	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
+	kia_u32 widthExtend = 0;
+
+	K15_IASkyline* lastSkyline = 0;
+
+	if (p_Width > p_ImageAtlas->maxDimension || p_Height > p_ImageAtlas->maxDimension)
+		return K15_IA_RESULT_ATLAS_TOO_LARGE;
+
+	p_ImageAtlas->width = p_Width;
+	p_ImageAtlas->height = p_Height;
+
+	if (!K15_IAUsesSkylines(p_ImageAtlas))
+	{
+		K15_IAAddGrownAtlasArea(p_ImageAtlas, oldWidth, oldHeight);
+		return K15_IA_RESULT_SUCCESS;
+	}
+
+	if (p_Width <= oldWidth)
+		return K15_IA_RESULT_SUCCESS;
+
+	widthExtend = p_Width - oldWidth;
+
+	//extend the right most skyline if it's at the very bottom, otherwise add a new skyline 
+	//that covers the new area
+	lastSkyline = numSkylines > 0 ? p_ImageAtlas->skylines + numSkylines - 1 : 0;
+
+	if (lastSkyline && lastSkyline->baseLinePosY == 0 && 
+		lastSkyline->baseLinePosX + lastSkyline->baseLineWidth == oldWidth)
+	{
+		lastSkyline->baseLineWidth += widthExtend;
+		return K15_IA_RESULT_SUCCESS;
+	}
+
+	//the right most skyline is the open shelf, which gets wider. The new area below 
+	//the shelf can still be filled with images that fit into the wasted space.
+	if (lastSkyline && p_ImageAtlas->packer == KIA_PACKER_SHELF &&
+		lastSkyline->baseLinePosX + lastSkyline->baseLineWidth == oldWidth)
+	{
+		lastSkyline->baseLineWidth += widthExtend;
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, oldWidth, 0, widthExtend, lastSkyline->baseLinePosY);
+		return K15_IA_RESULT_SUCCESS;
+	}
+
+	return K15_IATryToInsertSkyline(p_ImageAtlas, 0, oldWidth, widthExtend);
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculateGrownDimension(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Dimension,
+	kia_u32 p_MinDimension)
+{
+	kia_u32 growStep = p_ImageAtlas->growStep;
+	kia_u32 dimension = K15_IA_MAX(p_Dimension, 1);
+
+	if ((p_ImageAtlas->flags & KIA_FORCE_POWER_OF_TWO_DIMENSION) != 0 || growStep == 0)
+	{
+		while (dimension < p_MinDimension)
+			dimension = dimension << 1;
+
+		return dimension;
+	}
+
+	if (dimension < p_MinDimension || dimension % growStep != 0)
+	{
+		dimension = K15_IA_MAX(dimension, p_MinDimension);
+		dimension = ((dimension + growStep - 1) / growStep) * growStep;
+	}
+
+	//new skylines start at the old dimension, keep them aligned
+	return K15_IAAlignDimension(p_ImageAtlas, dimension);
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IATryToGrowAtlasSize(K15_ImageAtlas* p_ImageAtlas, 
+	kia_u32 p_NodeWidth, kia_u32 p_NodeHeight)
+{
+	kia_u32 width = p_ImageAtlas->width;
+	kia_u32 height = p_ImageAtlas->height;
+
+	if ((p_ImageAtlas->flags & KIA_FORCE_POWER_OF_TWO_DIMENSION) != 0)
+	{
+		if (width > height)
+			height = height << 1;
+		else
+			width = width << 1;
+	}
+	else
+	{
+		//small steps don't help if the node doesn't even fit into the atlas
+		if (p_NodeWidth > width)
+			width = K15_IACalculateGrownDimension(p_ImageAtlas, width, p_NodeWidth);
+		else if (p_NodeHeight > height)
+			height = K15_IACalculateGrownDimension(p_ImageAtlas, height, p_NodeHeight);
+		else if (width > height)
+			height = K15_IACalculateGrownDimension(p_ImageAtlas, height, height + 1);
+		else
+			width = K15_IACalculateGrownDimension(p_ImageAtlas, width, width + 1);
+	}
+
+	return K15_IAResizeAtlas(p_ImageAtlas, width, height);
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IATryToGrowAtlasSizeToFit(K15_ImageAtlas* p_ImageAtlas,
+	kia_u32 p_MinWidth, kia_u32 p_MinHeight, kia_u32 p_MinArea)
+{
+	kia_u32 width = p_ImageAtlas->width;
+	kia_u32 height = p_ImageAtlas->height;
+
+	if (p_MinWidth > p_ImageAtlas->maxDimension || p_MinHeight > p_ImageAtlas->maxDimension)
+		return K15_IA_RESULT_ATLAS_TOO_LARGE;
+
+	//calculate the final size first, so we only have to touch the skylines once
+	width = K15_IACalculateGrownDimension(p_ImageAtlas, width, p_MinWidth);
+	height = K15_IACalculateGrownDimension(p_ImageAtlas, height, p_MinHeight);
+
+	while (width * height < p_MinArea)
+	{
+		if (width > height)
+			height = K15_IACalculateGrownDimension(p_ImageAtlas, height, height + 1);
+		else
+			width = K15_IACalculateGrownDimension(p_ImageAtlas, width, width + 1);
+
+		if (width > p_ImageAtlas->maxDimension || height > p_ImageAtlas->maxDimension)
+			return K15_IA_RESULT_ATLAS_TOO_LARGE;
+	}
+
+	if (width == p_ImageAtlas->width && height == p_ImageAtlas->height)
+		return K15_IA_RESULT_SUCCESS;
+
+	return K15_IAResizeAtlas(p_ImageAtlas, width, height);
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculateUsedAtlasArea(K15_ImageAtlas* p_ImageAtlas)
+{
+	kia_u32 usedArea = 0;
+	kia_u32 nodeIndex = 0;
+	K15_IAImageNode* imageNode = 0;
+
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) == 0)
+			usedArea += imageNode->rect.width * imageNode->rect.height;
+	}
+
+	return usedArea;
+}
+/*********************************************************************************/
+kia_internal void K15_IARemoveOrTrimWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Index,
+	kia_u32 p_Width, kia_u32 p_Height)
+{
+	K15_IARect* wastedSpaceRect = p_ImageAtlas->wastedSpaceRects + p_Index;
+
+	kia_u32 rectWidth = wastedSpaceRect->width;
+	kia_u32 rectHeight = wastedSpaceRect->height;
+
+	kia_u32 restHeight = rectHeight - p_Height;
+	kia_u32 restWidth = rectWidth - p_Width;
+
+	kia_u32 posLowerX = wastedSpaceRect->posX;
+	kia_u32 posLowerY = wastedSpaceRect->posY + p_Height;
+	kia_u32 posRightX = wastedSpaceRect->posX + p_Width;
+	kia_u32 posRightY = wastedSpaceRect->posY;
+
+	//the size (and therefore the bucket) of the rect changes in any case
+	K15_IARemoveWastedSpaceRectByIndex(p_ImageAtlas, p_Index);
+
+	if (restWidth == 0)
+	{
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, posLowerX, posLowerY, rectWidth, restHeight);
+	}
+	else if (restHeight == 0)
+	{
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, posRightX, posRightY, restWidth, rectHeight);
+	}
+	else if (restWidth > restHeight)
+	{
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, posRightX, posRightY, restWidth, rectHeight);
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, posLowerX, posLowerY, p_Width, restHeight);
+	}
+	else
+	{
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, posLowerX, posLowerY, rectWidth, restHeight);
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, posRightX, posRightY, restWidth, p_Height);
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IASetImageNodeDimension(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNode,
+	kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight)
+{
+	p_ImageNode->pixelDataWidth = (kia_u16)p_PixelDataWidth;
+	p_ImageNode->pixelDataHeight = (kia_u16)p_PixelDataHeight;
+	p_ImageNode->padding = p_ImageAtlas->padding;
+	p_ImageNode->rect.width = (kia_u16)K15_IAAlignDimension(p_ImageAtlas, p_PixelDataWidth + 2 * p_ImageAtlas->padding);
+	p_ImageNode->rect.height = (kia_u16)K15_IAAlignDimension(p_ImageAtlas, p_PixelDataHeight + 2 * p_ImageAtlas->padding);
+}
+/*********************************************************************************/
+kia_internal void K15_IARotateImageNode(K15_IAImageNode* p_ImageNode)
+{
+	kia_u16 width = p_ImageNode->rect.width;
+
+	p_ImageNode->rect.width = p_ImageNode->rect.height;
+	p_ImageNode->rect.height = width;
+	p_ImageNode->flags ^= KIA_IMAGE_NODE_ROTATED;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAFindBestWastedSpaceRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NodeWidth,
+	kia_u32 p_NodeHeight, kia_u32* p_InOutBestHeuristic)
+{
+	kia_u32 wastedRectWidth = 0;
+	kia_u32 wastedRectHeight = 0;
+	kia_u32 nodeWidth = p_NodeWidth;
+	kia_u32 nodeHeight = p_NodeHeight;
+	kia_u32 minWidthClass = K15_IACalculateSizeClass(nodeWidth);
+	kia_u32 minHeightClass = K15_IACalculateSizeClass(nodeHeight);
+	kia_u32 minSizeClassSum = minWidthClass + minHeightClass;
+	kia_u32 maxSizeClass = K15_IA_NUM_SIZE_CLASSES - 1;
+	kia_u32 sizeClassSum = 0;
+	kia_u32 widthClass = 0;
+	kia_u32 heightClass = 0;
+	kia_u32 heuristic = 0;
+	kia_u32 bestHeuristic = *p_InOutBestHeuristic;
+	kia_u32 bestFitIndex = K15_IA_INVALID_INDEX;
+	kia_u32 rectIndex = 0;
+	K15_IARect* wastedSpaceRects = p_ImageAtlas->wastedSpaceRects;
+	K15_IARectLink* wastedSpaceRectLinks = p_ImageAtlas->wastedSpaceRectLinks;
+	K15_IARect* wastedSpaceRect = 0;
+
+	//Look for the smallest rect the node fits in. Only buckets whose size classes are at least 
+	//as big as the node's size classes are checked. The buckets are visited in order of their 
+	//smallest possible area (2^(widthClass + heightClass)), so we can stop as soon as no rect
+	//of the remaining buckets can beat the best fit found so far.
+	for (sizeClassSum = minSizeClassSum;
+		sizeClassSum <= maxSizeClass * 2;
+		++sizeClassSum)
+	{
+		if (bestHeuristic <= (1u << sizeClassSum))
+			break;
+
+		for (widthClass = K15_IA_MAX(minWidthClass, sizeClassSum - K15_IA_MIN(sizeClassSum, maxSizeClass));
+			widthClass <= maxSizeClass && widthClass + minHeightClass <= sizeClassSum;
+			++widthClass)
+		{
+			heightClass = sizeClassSum - widthClass;
+			rectIndex = p_ImageAtlas->wastedSpaceRectBuckets[widthClass * K15_IA_NUM_SIZE_CLASSES + heightClass];
+
+			while (rectIndex != K15_IA_INVALID_INDEX)
+			{
+				wastedSpaceRect = wastedSpaceRects + rectIndex;
+				wastedRectWidth = wastedSpaceRect->width;
+				wastedRectHeight = wastedSpaceRect->height;
+
+				if (wastedRectWidth >= nodeWidth &&
+					wastedRectHeight >= nodeHeight)
+				{
+					heuristic = wastedRectWidth * wastedRectHeight;
+
+					if (heuristic < bestHeuristic)
+					{
+						bestHeuristic = heuristic;
+						bestFitIndex = rectIndex;
+					}
+				}
+
+				rectIndex = wastedSpaceRectLinks[rectIndex].nextIndex;
+			}
+		}
+	}
+
+	*p_InOutBestHeuristic = bestHeuristic;
+
+	return bestFitIndex;
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IATryToFitInWastedSpace(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert)
+{
+	kia_u32 nodeWidth = p_NodeToInsert->rect.width;
+	kia_u32 nodeHeight = p_NodeToInsert->rect.height;
+	kia_u32 bestHeuristic = ~0u;
+	kia_u32 bestFitIndex = K15_IA_INVALID_INDEX;
+	kia_u32 rotatedFitIndex = K15_IA_INVALID_INDEX;
+	K15_IARect* wastedSpaceRect = 0;
+
+	bestFitIndex = K15_IAFindBestWastedSpaceRect(p_ImageAtlas, nodeWidth, nodeHeight, &bestHeuristic);
+
+	//the rotated node only wins if it fits into a smaller rect
+	if ((p_ImageAtlas->flags & KIA_ALLOW_IMAGE_ROTATION) != 0 && nodeWidth != nodeHeight)
+	{
+		rotatedFitIndex = K15_IAFindBestWastedSpaceRect(p_ImageAtlas, nodeHeight, nodeWidth, &bestHeuristic);
+
+		if (rotatedFitIndex != K15_IA_INVALID_INDEX)
+		{
+			bestFitIndex = rotatedFitIndex;
+			nodeWidth = p_NodeToInsert->rect.height;
+			nodeHeight = p_NodeToInsert->rect.width;
+			K15_IARotateImageNode(p_NodeToInsert);
+		}
+	}
+
+	if (bestFitIndex != K15_IA_INVALID_INDEX)
+	{
+		//copy position
+		wastedSpaceRect = p_ImageAtlas->wastedSpaceRects + bestFitIndex;
+		p_NodeToInsert->rect.posX = wastedSpaceRect->posX;
+		p_NodeToInsert->rect.posY = wastedSpaceRect->posY;
+
+		K15_IARemoveOrTrimWastedSpaceRect(p_ImageAtlas, bestFitIndex, nodeWidth, nodeHeight);
+	}
+
+	return (bestFitIndex != K15_IA_INVALID_INDEX);
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAFindBestSkylineIndex(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NodeWidth,
+	kia_u32 p_NodeHeight, kia_u32* p_OutHeuristic)
+{
+	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
+	kia_u32 height = p_ImageAtlas->height;
+	kia_u32 width = p_ImageAtlas->width;
+	kia_u32 baseLinePosY = 0;
+	kia_u32 baseLinePosX = 0;
+	kia_u32 baseLineWidth = 0;
+	kia_u32 nodeRightPos = 0;
+	kia_u32 heuristic = 0;
+	kia_u32 wastedArea = 0;
+	kia_u32 minHeuristic = 0;
+	kia_u32 bestHeuristic = ~0u;
+	kia_u32 bestTopPos = ~0u;
+	kia_u32 bestFitIndex = ~0u;
+	kia_u32 skylineIndex = 0;
+	kia_u32 lastSkylineIndex = 0;
+	kia_u32 lastSkylineEnd = 0;
+	kia_u32 lastSkylineOverlap = 0;
+	kia_u32 windowEndIndex = 0;
+	kia_u32 windowWidth = 0;
+	kia_u32 windowArea = 0;
+	kia_u32 collisionWindowEndIndex = 0;
+	kia_u32 maxQueueStart = 0;
+	kia_u32 maxQueueEnd = 0;
+	kia_u32* maxQueue = p_ImageAtlas->skylineWindowIndices;
+	K15_IASkyline* skylines = p_ImageAtlas->skylines;
+	K15_IASkyline* skyline = 0;
+
+	//The node covers all skylines in the window [skylineIndex, windowEndIndex). As the candidate 
+	//moves to the right, the window end only ever moves to the right, too. This allows us to 
+	//keep track of everything we need incrementally (amortized O(1) per candidate):
+	//	- windowWidth/windowArea are the sums of width and width * baseline of all 
+	//	  skylines of the window that are completely covered by the node (all but the last one).
+	//	- maxQueue contains the indices of the skylines right of the candidate that the node 
+	//	  would collide with sorted by decreasing baseline (maxQueue[maxQueueStart] is the highest).
+	//Every heuristic only needs these values, so switching the heuristic doesn't add a rescan.
+
+	//lowest possible score (node placed on the bottom of the atlas without wasting any space)
+	switch (p_ImageAtlas->skylineHeuristic)
+	{
+		case KIA_SKYLINE_MIN_WASTED_AREA:
+			minHeuristic = 0;
+			break;
+
+		case KIA_SKYLINE_MIN_WASTED_AREA_AND_HEIGHT:
+			minHeuristic = K15_IA_SKYLINE_HEIGHT_WEIGHT * p_NodeHeight * p_NodeWidth;
+			break;
+
+		default:
+			minHeuristic = p_NodeHeight;
+			break;
+	}
+
+	for (skylineIndex = 0;
+		skylineIndex < numSkylines;
+		++skylineIndex)
+	{
+		skyline = skylines + skylineIndex;
+		baseLinePosY = skyline->baseLinePosY;
+		baseLinePosX = skyline->baseLinePosX;
+		baseLineWidth = skyline->baseLineWidth;
+		nodeRightPos = baseLinePosX + p_NodeWidth;
+
+		//skylines are sorted by x, so the node won't fit on any of the following skylines either
+		if (nodeRightPos > width)
+			break;
+
+		if (windowEndIndex <= skylineIndex)
+		{
+			windowEndIndex = skylineIndex + 1;
+			windowWidth = 0;
+			windowArea = 0;
+		}
+
+		if (collisionWindowEndIndex <= skylineIndex)
+		{
+			collisionWindowEndIndex = skylineIndex + 1;
+			maxQueueStart = 0;
+			maxQueueEnd = 0;
+		}
+
+		//remove the candidate skyline from the max queue (we only need the skylines right of it)
+		while (maxQueueStart < maxQueueEnd && maxQueue[maxQueueStart] <= skylineIndex)
+			++maxQueueStart;
+
+		//extend the window to all skylines that would be covered by the node
+		while (windowEndIndex < numSkylines && skylines[windowEndIndex].baseLinePosX < nodeRightPos)
+		{
+			lastSkylineIndex = windowEndIndex++ - 1;
+			windowWidth += skylines[lastSkylineIndex].baseLineWidth;
+			windowArea += skylines[lastSkylineIndex].baseLineWidth * skylines[lastSkylineIndex].baseLinePosY;
+		}
+
+		//a skyline that starts exactly at the right edge of the node counts as collision
+		while (collisionWindowEndIndex < numSkylines && 
+			skylines[collisionWindowEndIndex].baseLinePosX <= nodeRightPos)
+		{
+			while (maxQueueEnd > maxQueueStart && skylines[maxQueue[maxQueueEnd - 1]].baseLinePosY <= 
+				skylines[collisionWindowEndIndex].baseLinePosY)
+			{
+				--maxQueueEnd;
+			}
+
+			maxQueue[maxQueueEnd++] = collisionWindowEndIndex++;
+		}
+
+		//check if image fits vertically. If the image is wider than the current skyline,
+		//none of the other skylines that the image covers may be higher than the current skyline.
+		if (height - baseLinePosY >= p_NodeHeight &&
+			(baseLineWidth >= p_NodeWidth || maxQueueStart == maxQueueEnd || 
+			skylines[maxQueue[maxQueueStart]].baseLinePosY <= baseLinePosY))
+		{
+			//node potentially fits. Calculate the area of the space that would be wasted 
+			//underneath the node (only the skylines covered by the node count).
+			lastSkylineIndex = windowEndIndex - 1;
+			lastSkylineEnd = skylines[lastSkylineIndex].baseLinePosX + skylines[lastSkylineIndex].baseLineWidth;
+			lastSkylineOverlap = K15_IA_MIN(lastSkylineEnd, nodeRightPos) - skylines[lastSkylineIndex].baseLinePosX;
+
+			wastedArea = baseLinePosY * (windowWidth + lastSkylineOverlap) - 
+				(windowArea + skylines[lastSkylineIndex].baseLinePosY * lastSkylineOverlap);
+
+			switch (p_ImageAtlas->skylineHeuristic)
+			{
+				case KIA_SKYLINE_BOTTOM_LEFT:
+					heuristic = baseLinePosY + p_NodeHeight;
+					break;
+
+				case KIA_SKYLINE_MIN_WASTED_AREA:
+					heuristic = wastedArea;
+					break;
+
+				case KIA_SKYLINE_MIN_WASTED_AREA_AND_HEIGHT:
+					heuristic = wastedArea + K15_IA_SKYLINE_HEIGHT_WEIGHT * (baseLinePosY + p_NodeHeight) * p_NodeWidth;
+					break;
+
+				//gap between the node and the end of the last covered skyline, the top edge is 
+				//part of the score so lower positions win if the gap is the same
+				default:
+					heuristic = (lastSkylineEnd - K15_IA_MIN(lastSkylineEnd, nodeRightPos)) * (height + 1) + 
+						baseLinePosY + p_NodeHeight;
+					break;
+			}
+
+			//ties are broken by the top edge, so the skylines stay as low as possible
+			if (heuristic < bestHeuristic || (heuristic == bestHeuristic && baseLinePosY + p_NodeHeight < bestTopPos))
+			{
+				bestHeuristic = heuristic;
+				bestTopPos = baseLinePosY + p_NodeHeight;
+				bestFitIndex = skylineIndex;
+			}
+
+			//we can't get better than this
+			if (bestHeuristic == minHeuristic && bestTopPos == p_NodeHeight)
+				break;
+		}
+
+		//move the window start (the candidate skyline is only part of windowWidth/windowArea
+		//if it's not the last skyline of the window)
+		if (skylineIndex + 1 < windowEndIndex)
+		{
+			windowWidth -= baseLineWidth;
+			windowArea -= baseLineWidth * baseLinePosY;
+		}
+	}
+
+	*p_OutHeuristic = bestHeuristic;
+
+	return bestFitIndex;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAAddImageToAtlasSkyline(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert)
+{
+	kia_result result = K15_IA_RESULT_ATLAS_TOO_SMALL;
+	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
+	kia_u32 bestFitIndex = ~0u;
+	kia_u32 rotatedFitIndex = ~0u;
+	kia_u32 bestHeuristic = ~0u;
+	kia_u32 rotatedHeuristic = ~0u;
+	kia_b8 rotated = K15_IA_FALSE;
+	K15_IASkyline* skyline = 0;
+	K15_IASkyline* skylines = p_ImageAtlas->skylines;
+
+	kia_b8 fitsInWastedSpace = K15_IATryToFitInWastedSpace(p_ImageAtlas, p_NodeToInsert);
+
+	if (!fitsInWastedSpace)
+	{
+		bestFitIndex = K15_IAFindBestSkylineIndex(p_ImageAtlas, p_NodeToInsert->rect.width,
+			p_NodeToInsert->rect.height, &bestHeuristic);
+
+		if ((p_ImageAtlas->flags & KIA_ALLOW_IMAGE_ROTATION) != 0 && 
+			p_NodeToInsert->rect.width != p_NodeToInsert->rect.height)
+		{
+			rotatedFitIndex = K15_IAFindBestSkylineIndex(p_ImageAtlas, p_NodeToInsert->rect.height,
+				p_NodeToInsert->rect.width, &rotatedHeuristic);
+
+			//prefer the orientation with the better score. If both score the same,
+			//prefer the one that keeps the skyline lower.
+			if (rotatedFitIndex != ~0u && (bestFitIndex == ~0u || rotatedHeuristic < bestHeuristic ||
+				(rotatedHeuristic == bestHeuristic && 
+				skylines[rotatedFitIndex].baseLinePosY + p_NodeToInsert->rect.width < 
+				skylines[bestFitIndex].baseLinePosY + p_NodeToInsert->rect.height)))
+			{
+				bestFitIndex = rotatedFitIndex;
+				rotated = K15_IA_TRUE;
+				K15_IARotateImageNode(p_NodeToInsert);
+			}
+		}
+
+		if (bestFitIndex != ~0u)
+		{
+			skyline = skylines + bestFitIndex;
+
+			//we need an additional skyline if the node doesn't cover the whole skyline.
+			//Check this before touching any skyline, so the atlas stays intact.
+			if (skyline->baseLineWidth > p_NodeToInsert->rect.width && !(bestFitIndex > 0 && 
+				skylines[bestFitIndex - 1].baseLinePosY == skyline->baseLinePosY + p_NodeToInsert->rect.height))
+			{
+				result = K15_IAReserveSkylines(p_ImageAtlas, numSkylines + 1);
+
+				if (result != K15_IA_RESULT_SUCCESS)
+				{
+					if (rotated)
+						K15_IARotateImageNode(p_NodeToInsert);
+
+					return result;
+				}
+
+				skylines = p_ImageAtlas->skylines;
+				skyline = skylines + bestFitIndex;
+			}
+
+			p_NodeToInsert->rect.posX = skyline->baseLinePosX;
+			p_NodeToInsert->rect.posY = skyline->baseLinePosY;
+
+			if (skyline->baseLineWidth > p_NodeToInsert->rect.width)
+			{
+				skyline->baseLinePosX += p_NodeToInsert->rect.width;
+				skyline->baseLineWidth -= p_NodeToInsert->rect.width;
+			}
+			else
+			{
+				p_ImageAtlas->numSkylines = K15_IARemoveSkylineByIndex(skylines, numSkylines,
+					bestFitIndex);
+			}
+
+			result = K15_IATryToInsertSkyline(p_ImageAtlas, p_NodeToInsert->rect.posY + p_NodeToInsert->rect.height,
+				p_NodeToInsert->rect.posX, p_NodeToInsert->rect.width);
+
+		}
+	}
+	else
+	{
+		result = K15_IA_RESULT_SUCCESS;
+	}
+
+	//remove/trim any skylines that would be obscured by the new skyline
+	if (result == K15_IA_RESULT_SUCCESS)
+	{
+		K15_IAFindWastedSpaceAndRemoveObscuredSkylines(p_ImageAtlas, p_NodeToInsert->rect.posX, 
+			p_NodeToInsert->rect.posY, p_NodeToInsert->rect.width);
+	}
+
+	return result;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculateContactPerimeter(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert,
+	kia_u32 p_PosX, kia_u32 p_PosY, kia_u32 p_Width, kia_u32 p_Height)
+{
+	kia_u32 contactPerimeter = 0;
+	kia_u32 rightPos = p_PosX + p_Width;
+	kia_u32 topPos = p_PosY + p_Height;
+	kia_u32 nodeIndex = 0;
+	kia_u32 overlapStart = 0;
+	kia_u32 overlapEnd = 0;
+
+	K15_IAImageNode* imageNode = 0;
+	K15_IARect* rect = 0;
+
+	//the border of the atlas counts as contact, too
+	if (p_PosX == 0)
+		contactPerimeter += p_Height;
+
+	if (rightPos == p_ImageAtlas->width)
+		contactPerimeter += p_Height;
+
+	if (p_PosY == 0)
+		contactPerimeter += p_Width;
+
+	if (topPos == p_ImageAtlas->height)
+		contactPerimeter += p_Width;
+
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+		rect = &imageNode->rect;
+
+		//a removed node might get reused for the node that is being placed
+		if (imageNode == p_NodeToInsert || (imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
+
+		if (rect->posX + rect->width == p_PosX || rect->posX == rightPos)
+		{
+			overlapStart = K15_IA_MAX(p_PosY, (kia_u32)rect->posY);
+			overlapEnd = K15_IA_MIN(topPos, (kia_u32)(rect->posY + rect->height));
+
+			if (overlapEnd > overlapStart)
+				contactPerimeter += overlapEnd - overlapStart;
+		}
+
+		if (rect->posY + rect->height == p_PosY || rect->posY == topPos)
+		{
+			overlapStart = K15_IA_MAX(p_PosX, (kia_u32)rect->posX);
+			overlapEnd = K15_IA_MIN(rightPos, (kia_u32)(rect->posX + rect->width));
+
+			if (overlapEnd > overlapStart)
+				contactPerimeter += overlapEnd - overlapStart;
+		}
+	}
+
+	return contactPerimeter;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAFindBestMaxRectsFit(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert,
+	kia_u32 p_NodeWidth, kia_u32 p_NodeHeight, kia_u32* p_InOutBestHeuristic, kia_u32* p_InOutBestSecondaryHeuristic)
+{
+	kia_u32 minWidthClass = K15_IACalculateSizeClass(p_NodeWidth);
+	kia_u32 minHeightClass = K15_IACalculateSizeClass(p_NodeHeight);
+	kia_u32 widthClass = 0;
+	kia_u32 heightClass = 0;
+	kia_u32 leftoverWidth = 0;
+	kia_u32 leftoverHeight = 0;
+	kia_u32 heuristic = 0;
+	kia_u32 secondaryHeuristic = 0;
+	kia_u32 bestHeuristic = *p_InOutBestHeuristic;
+	kia_u32 bestSecondaryHeuristic = *p_InOutBestSecondaryHeuristic;
+	kia_u32 bestFitIndex = K15_IA_INVALID_INDEX;
+	kia_u32 rectIndex = 0;
+	K15_IARect* rect = 0;
+
+	//only the buckets whose size classes are at least as big as the node's size classes can 
+	//contain rects the node fits in
+	for (widthClass = minWidthClass;
+		widthClass < K15_IA_NUM_SIZE_CLASSES;
+		++widthClass)
+	{
+		for (heightClass = minHeightClass;
+			heightClass < K15_IA_NUM_SIZE_CLASSES;
+			++heightClass)
+		{
+			rectIndex = p_ImageAtlas->wastedSpaceRectBuckets[widthClass * K15_IA_NUM_SIZE_CLASSES + heightClass];
+
+			while (rectIndex != K15_IA_INVALID_INDEX)
+			{
+				rect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+
+				if (rect->width >= p_NodeWidth && rect->height >= p_NodeHeight)
+				{
+					leftoverWidth = rect->width - p_NodeWidth;
+					leftoverHeight = rect->height - p_NodeHeight;
+
+					if (p_ImageAtlas->packer == KIA_PACKER_MAX_RECTS_BEST_AREA_FIT)
+					{
+						heuristic = rect->width * rect->height - p_NodeWidth * p_NodeHeight;
+						secondaryHeuristic = K15_IA_MIN(leftoverWidth, leftoverHeight);
+					}
+					else if (p_ImageAtlas->packer == KIA_PACKER_MAX_RECTS_CONTACT_POINT)
+					{
+						//length of the node's border that doesn't touch anything
+						heuristic = 2 * (p_NodeWidth + p_NodeHeight) - K15_IACalculateContactPerimeter(p_ImageAtlas,
+							p_NodeToInsert, rect->posX, rect->posY, p_NodeWidth, p_NodeHeight);
+						secondaryHeuristic = rect->posY;
+					}
+					else
+					{
+						heuristic = K15_IA_MIN(leftoverWidth, leftoverHeight);
+						secondaryHeuristic = K15_IA_MAX(leftoverWidth, leftoverHeight);
+					}
+
+					if (heuristic < bestHeuristic || 
+						(heuristic == bestHeuristic && secondaryHeuristic < bestSecondaryHeuristic))
+					{
+						bestHeuristic = heuristic;
+						bestSecondaryHeuristic = secondaryHeuristic;
+						bestFitIndex = rectIndex;
+					}
+				}
+
+				rectIndex = p_ImageAtlas->wastedSpaceRectLinks[rectIndex].nextIndex;
+			}
+		}
+	}
+
+	*p_InOutBestHeuristic = bestHeuristic;
+	*p_InOutBestSecondaryHeuristic = bestSecondaryHeuristic;
+
+	return bestFitIndex;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAAddImageToAtlasMaxRects(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert)
+{
+	kia_u32 nodeWidth = p_NodeToInsert->rect.width;
+	kia_u32 nodeHeight = p_NodeToInsert->rect.height;
+	kia_u32 bestHeuristic = ~0u;
+	kia_u32 bestSecondaryHeuristic = ~0u;
+	kia_u32 bestFitIndex = K15_IA_INVALID_INDEX;
+	kia_u32 rotatedFitIndex = K15_IA_INVALID_INDEX;
+	K15_IARect* wastedSpaceRect = 0;
+
+	//the free space is tracked by the wasted space rects. These are the maximal free rects
+	//(they overlap each other), so every free position is covered by a rect.
+	bestFitIndex = K15_IAFindBestMaxRectsFit(p_ImageAtlas, p_NodeToInsert, nodeWidth, nodeHeight,
+		&bestHeuristic, &bestSecondaryHeuristic);
+
+	//the rotated node only wins if it fits better
+	if ((p_ImageAtlas->flags & KIA_ALLOW_IMAGE_ROTATION) != 0 && nodeWidth != nodeHeight)
+	{
+		rotatedFitIndex = K15_IAFindBestMaxRectsFit(p_ImageAtlas, p_NodeToInsert, nodeHeight, nodeWidth,
+			&bestHeuristic, &bestSecondaryHeuristic);
+
+		if (rotatedFitIndex != K15_IA_INVALID_INDEX)
+		{
+			bestFitIndex = rotatedFitIndex;
+			K15_IARotateImageNode(p_NodeToInsert);
+		}
+	}
+
+	if (bestFitIndex == K15_IA_INVALID_INDEX)
+		return K15_IA_RESULT_ATLAS_TOO_SMALL;
+
+	wastedSpaceRect = p_ImageAtlas->wastedSpaceRects + bestFitIndex;
+	p_NodeToInsert->rect.posX = wastedSpaceRect->posX;
+	p_NodeToInsert->rect.posY = wastedSpaceRect->posY;
+
+	K15_IASplitWastedSpaceRects(p_ImageAtlas, &p_NodeToInsert->rect, K15_IA_TRUE);
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAAddImageToAtlasGuillotine(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert)
+{
+	//the free space is tracked by the wasted space rects (which don't overlap), the node
+	//goes into the smallest rect and the rest of the rect gets split into two rects
+	if (K15_IATryToFitInWastedSpace(p_ImageAtlas, p_NodeToInsert))
+		return K15_IA_RESULT_SUCCESS;
+
+	return K15_IA_RESULT_ATLAS_TOO_SMALL;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAAddImageToAtlasShelf(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert)
+{
+	kia_u32 nodeWidth = p_NodeToInsert->rect.width;
+	kia_u32 nodeHeight = p_NodeToInsert->rect.height;
+	kia_u32 shelfPosY = 0;
+	kia_u32 shelfHeight = 0;
+	kia_u32 skylineIndex = 0;
+	kia_b8 allowRotation = (p_ImageAtlas->flags & KIA_ALLOW_IMAGE_ROTATION) != 0 && nodeWidth != nodeHeight;
+	kia_b8 fits = K15_IA_FALSE;
+	kia_b8 rotatedFits = K15_IA_FALSE;
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	K15_IASkyline* skylines = p_ImageAtlas->skylines;
+	K15_IASkyline* skyline = 0;
+
+	//holes in older shelves are filled first
+	if (K15_IATryToFitInWastedSpace(p_ImageAtlas, p_NodeToInsert))
+		return K15_IA_RESULT_SUCCESS;
+
+	//The open shelf is described by two skylines. The left one is the top of the shelf, 
+	//the right one is the bottom of the shelf where the next image goes.
+	if (p_ImageAtlas->numSkylines == 2 && skylines[0].baseLinePosY > skylines[1].baseLinePosY)
+	{
+		shelfPosY = skylines[1].baseLinePosY;
+		shelfHeight = skylines[0].baseLinePosY - shelfPosY;
+		fits = nodeWidth <= skylines[1].baseLineWidth && nodeHeight <= shelfHeight;
+		rotatedFits = allowRotation && nodeHeight <= skylines[1].baseLineWidth && nodeWidth <= shelfHeight;
+
+		//prefer the taller orientation, less space above the image gets wasted
+		if (rotatedFits && (!fits || nodeWidth > nodeHeight))
+		{
+			K15_IARotateImageNode(p_NodeToInsert);
+			nodeWidth = p_NodeToInsert->rect.width;
+			nodeHeight = p_NodeToInsert->rect.height;
+			fits = K15_IA_TRUE;
+		}
+
+		if (fits)
+		{
+			p_NodeToInsert->rect.posX = skylines[1].baseLinePosX;
+			p_NodeToInsert->rect.posY = (kia_u16)shelfPosY;
+
+			K15_IAAddWastedSpaceRect(p_ImageAtlas, p_NodeToInsert->rect.posX, shelfPosY + nodeHeight,
+				nodeWidth, shelfHeight - nodeHeight);
+
+			skylines[0].baseLineWidth += nodeWidth;
+			skylines[1].baseLinePosX += (kia_u16)nodeWidth;
+			skylines[1].baseLineWidth -= nodeWidth;
+
+			if (skylines[1].baseLineWidth == 0)
+				p_ImageAtlas->numSkylines = 1;
+
+			return K15_IA_RESULT_SUCCESS;
+		}
+	}
+
+	//open a new shelf on top of all other shelves
+	shelfPosY = 0;
+
+	for (skylineIndex = 0;
+		skylineIndex < p_ImageAtlas->numSkylines;
+		++skylineIndex)
+	{
+		shelfPosY = K15_IA_MAX(shelfPosY, (kia_u32)skylines[skylineIndex].baseLinePosY);
+	}
+
+	fits = nodeWidth <= p_ImageAtlas->width && nodeHeight <= p_ImageAtlas->height - shelfPosY;
+	rotatedFits = allowRotation && nodeHeight <= p_ImageAtlas->width && nodeWidth <= p_ImageAtlas->height - shelfPosY;
+
+	//prefer the flat orientation, so the shelf doesn't get too high
+	if (rotatedFits && (!fits || nodeHeight > nodeWidth))
+	{
+		K15_IARotateImageNode(p_NodeToInsert);
+		nodeWidth = p_NodeToInsert->rect.width;
+		nodeHeight = p_NodeToInsert->rect.height;
+		fits = K15_IA_TRUE;
+	}
+
+	if (!fits)
+		return K15_IA_RESULT_ATLAS_TOO_SMALL;
+
+	//close the current shelf, the space that is left in it can still be used as wasted space
+	for (skylineIndex = 0;
+		skylineIndex < p_ImageAtlas->numSkylines;
+		++skylineIndex)
+	{
+		skyline = skylines + skylineIndex;
+
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, skyline->baseLinePosX, skyline->baseLinePosY, 
+			skyline->baseLineWidth, shelfPosY - skyline->baseLinePosY);
+	}
+
+	p_ImageAtlas->numSkylines = 0;
+	p_NodeToInsert->rect.posX = 0;
+	p_NodeToInsert->rect.posY = (kia_u16)shelfPosY;
+
+	result = K15_IATryToInsertSkyline(p_ImageAtlas, shelfPosY + nodeHeight, 0, nodeWidth);
+
+	if (result == K15_IA_RESULT_SUCCESS && nodeWidth < p_ImageAtlas->width)
+		result = K15_IATryToInsertSkyline(p_ImageAtlas, shelfPosY, nodeWidth, p_ImageAtlas->width - nodeWidth);
+
+	return result;
+}
+/*********************************************************************************/
+kia_internal void K15_IAResetAtlasPacking(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Width, kia_u32 p_Height)
+{
+	//forget about all placed images (the image nodes themselves are left untouched)
+	p_ImageAtlas->numSkylines = 0;
+	p_ImageAtlas->numWastedSpaceRects = 0;
+	p_ImageAtlas->width = p_Width;
+	p_ImageAtlas->height = p_Height;
+
+	K15_IA_MEMSET(p_ImageAtlas->wastedSpaceRectBuckets, 0xFF, 
+		sizeof(kia_u32) * K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS);
+
+	if (!K15_IAUsesSkylines(p_ImageAtlas))
+	{
+		K15_IAAddWastedSpaceRect(p_ImageAtlas, 0, 0, p_Width, p_Height);
+		return;
+	}
+
+	//there's always room for at least one skyline
+	K15_IATryToInsertSkyline(p_ImageAtlas, 0, 0, p_Width);
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IARaiseSkylines(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_PosX, kia_u32 p_Width,
+	kia_u32 p_BaseLineY)
+{
+	kia_u32 skylineIndex = 0;
+	kia_u32 skylineEnd = 0;
+	kia_u32 rangeEnd = p_PosX + p_Width;
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	K15_IASkyline* skylines = 0;
+	K15_IASkyline skyline;
+
+	//raise all skylines in [p_PosX, p_PosX + p_Width) to at least p_BaseLineY, 
+	//skylines that are only partly covered get split
+	while (skylineIndex < p_ImageAtlas->numSkylines)
+	{
+		skylines = p_ImageAtlas->skylines;
+		skyline = skylines[skylineIndex];
+		skylineEnd = skyline.baseLinePosX + skyline.baseLineWidth;
+
+		if (skyline.baseLinePosX >= rangeEnd)
+			break;
+
+		if (skylineEnd <= p_PosX || skyline.baseLinePosY >= p_BaseLineY)
+		{
+			++skylineIndex;
+			continue;
+		}
+
+		if (skyline.baseLinePosX < p_PosX || skylineEnd > rangeEnd)
+		{
+			result = K15_IAReserveSkylines(p_ImageAtlas, p_ImageAtlas->numSkylines + 1);
+
+			if (result != K15_IA_RESULT_SUCCESS)
+				return result;
+
+			skylines = p_ImageAtlas->skylines;
+			K15_IA_MEMMOVE(skylines + skylineIndex + 1, skylines + skylineIndex,
+				(p_ImageAtlas->numSkylines - skylineIndex) * sizeof(K15_IASkyline));
+			++p_ImageAtlas->numSkylines;
+
+			if (skyline.baseLinePosX < p_PosX)
+			{
+				//split off the part left of the range, the rest gets handled by the next iteration
+				skylines[skylineIndex].baseLineWidth = p_PosX - skyline.baseLinePosX;
+				skylines[skylineIndex + 1].baseLinePosX = p_PosX;
+				skylines[skylineIndex + 1].baseLineWidth = skylineEnd - p_PosX;
+				++skylineIndex;
+				continue;
+			}
+
+			//split off the part right of the range
+			skylines[skylineIndex].baseLineWidth = rangeEnd - skyline.baseLinePosX;
+			skylines[skylineIndex + 1].baseLinePosX = rangeEnd;
+			skylines[skylineIndex + 1].baseLineWidth = skylineEnd - rangeEnd;
+		}
+
+		skylines[skylineIndex].baseLinePosY = p_BaseLineY;
+		++skylineIndex;
+	}
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal void K15_IARebuildSkylinesFromImageNodes(K15_ImageAtlas* p_ImageAtlas)
+{
+	kia_u32 nodeIndex = 0;
+	kia_u32 skylineIndex = 0;
+	kia_u32 numSkylines = 0;
+	kia_u32 maxBaseLineY = 0;
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	K15_IAImageNode* imageNode = 0;
+	K15_IASkyline* skylines = 0;
+
+	K15_IAResetAtlasPacking(p_ImageAtlas, p_ImageAtlas->width, p_ImageAtlas->height);
+
+	//the skylines follow the top of the highest image of each column. Everything 
+	//below that is considered occupied.
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
+
+		maxBaseLineY = K15_IA_MAX(maxBaseLineY, (kia_u32)(imageNode->rect.posY + imageNode->rect.height));
+
+		if (result == K15_IA_RESULT_SUCCESS)
+		{
+			result = K15_IARaiseSkylines(p_ImageAtlas, imageNode->rect.posX, imageNode->rect.width,
+				imageNode->rect.posY + imageNode->rect.height);
+		}
+	}
+
+	if (result != K15_IA_RESULT_SUCCESS)
+	{
+		//not enough skylines, use a flat skyline above all images
+		p_ImageAtlas->numSkylines = 1;
+		p_ImageAtlas->skylines[0].baseLinePosX = 0;
+		p_ImageAtlas->skylines[0].baseLinePosY = maxBaseLineY;
+		p_ImageAtlas->skylines[0].baseLineWidth = p_ImageAtlas->width;
+		return;
+	}
+
+	//merge neighbouring skylines with the same height
+	skylines = p_ImageAtlas->skylines;
+
+	for (skylineIndex = 1;
+		skylineIndex < p_ImageAtlas->numSkylines;
+		++skylineIndex)
+	{
+		if (skylines[skylineIndex].baseLinePosY == skylines[numSkylines].baseLinePosY)
+			skylines[numSkylines].baseLineWidth += skylines[skylineIndex].baseLineWidth;
+		else
+			skylines[++numSkylines] = skylines[skylineIndex];
+	}
+
+	p_ImageAtlas->numSkylines = numSkylines + 1;
+}
+/*********************************************************************************/
+kia_internal void K15_IARebuildFreeSpaceFromImageNodes(K15_ImageAtlas* p_ImageAtlas)
+{
+	kia_u32 nodeIndex = 0;
+	K15_IAImageNode* imageNode = 0;
+
+	if (K15_IAUsesSkylines(p_ImageAtlas))
+	{
+		K15_IARebuildSkylinesFromImageNodes(p_ImageAtlas);
+		return;
+	}
+
+	//cut the area of every image out of the (initially completely free) atlas
+	K15_IAResetAtlasPacking(p_ImageAtlas, p_ImageAtlas->width, p_ImageAtlas->height);
+
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) == 0)
+		{
+			K15_IASplitWastedSpaceRects(p_ImageAtlas, &imageNode->rect, 
+				K15_IAIsMaxRectsPacker(p_ImageAtlas->packer));
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAMarkImageNodeAsDirty(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NodeIndex)
+{
+	K15_IAImageNode* imageNode = p_ImageAtlas->imageNodes + p_NodeIndex;
+
+	if ((imageNode->flags & KIA_IMAGE_NODE_DIRTY) != 0)
+		return;
+
+	imageNode->flags |= KIA_IMAGE_NODE_DIRTY;
+	imageNode->nextDirtyIndex = p_ImageAtlas->firstDirtyImageNodeIndex;
+	p_ImageAtlas->firstDirtyImageNodeIndex = p_NodeIndex;
+}
+/*********************************************************************************/
+kia_internal void K15_IAClearDirtyImageNodes(K15_ImageAtlas* p_ImageAtlas)
+{
+	kia_u32 nodeIndex = p_ImageAtlas->firstDirtyImageNodeIndex;
+	K15_IAImageNode* imageNode = 0;
+
+	while (nodeIndex != K15_IA_INVALID_INDEX)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+		imageNode->flags &= ~KIA_IMAGE_NODE_DIRTY;
+		nodeIndex = imageNode->nextDirtyIndex;
+	}
+
+	p_ImageAtlas->firstDirtyImageNodeIndex = K15_IA_INVALID_INDEX;
+	p_ImageAtlas->numPendingClearRects = 0;
+	p_ImageAtlas->flags &= ~KIA_CLEAR_FREE_SPACE_PENDING;
+}
+/*********************************************************************************/
+kia_internal void K15_IAAddPendingClearRect(K15_ImageAtlas* p_ImageAtlas, K15_IARect* p_Rect)
+{
+	K15_IADirtyRect* pendingClearRect = 0;
+
+	if ((p_ImageAtlas->flags & KIA_CLEAR_FREE_SPACE_PENDING) != 0)
+		return;
+
+	//too many removed images, clear the whole free space instead
+	if (p_ImageAtlas->numPendingClearRects == K15_IA_MAX_PENDING_CLEAR_RECTS)
+	{
+		p_ImageAtlas->flags |= KIA_CLEAR_FREE_SPACE_PENDING;
+		p_ImageAtlas->numPendingClearRects = 0;
+		return;
+	}
+
+	pendingClearRect = p_ImageAtlas->pendingClearRects + p_ImageAtlas->numPendingClearRects++;
+	pendingClearRect->posX = p_Rect->posX;
+	pendingClearRect->posY = p_Rect->posY;
+	pendingClearRect->width = p_Rect->width;
+	pendingClearRect->height = p_Rect->height;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAPlaceImageNode(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert)
+{
+	switch (p_ImageAtlas->packer)
+	{
+		case KIA_PACKER_MAX_RECTS_BEST_SHORT_SIDE_FIT:
+		case KIA_PACKER_MAX_RECTS_BEST_AREA_FIT:
+		case KIA_PACKER_MAX_RECTS_CONTACT_POINT:
+			return K15_IAAddImageToAtlasMaxRects(p_ImageAtlas, p_NodeToInsert);
+
+		case KIA_PACKER_GUILLOTINE:
+			return K15_IAAddImageToAtlasGuillotine(p_ImageAtlas, p_NodeToInsert);
+
+		case KIA_PACKER_SHELF:
+			return K15_IAAddImageToAtlasShelf(p_ImageAtlas, p_NodeToInsert);
+
+		default:
+			return K15_IAAddImageToAtlasSkyline(p_ImageAtlas, p_NodeToInsert);
+	}
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAInsertImageNode(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert,
+	int* p_OutX, int* p_OutY)
+{
+	kia_result result = K15_IA_RESULT_ATLAS_TOO_SMALL;
+
+	while (result == K15_IA_RESULT_ATLAS_TOO_SMALL)
+	{
+		result = K15_IAPlaceImageNode(p_ImageAtlas, p_NodeToInsert);
+
+		//grow the atlas and try again if the node didn't fit 
+		if (result == K15_IA_RESULT_ATLAS_TOO_SMALL)
+		{
+			kia_result growResult = K15_IATryToGrowAtlasSize(p_ImageAtlas, 
+				p_NodeToInsert->rect.width, p_NodeToInsert->rect.height);
+			++p_ImageAtlas->numGrowRetries;
+
+			if (growResult != K15_IA_RESULT_SUCCESS)
+				return growResult;
+		}
+	}
+
+	//the caller is interested in the position of the image, not of the padding
+	if (result == K15_IA_RESULT_SUCCESS)
+	{
+		*p_OutX = p_NodeToInsert->rect.posX + p_NodeToInsert->padding;
+		*p_OutY = p_NodeToInsert->rect.posY + p_NodeToInsert->padding;
+	}
+
+	return result;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAClampToImageNodeContent(kia_u32 p_Position, kia_u32 p_ContentStart, 
+	kia_u32 p_ContentSize)
+{
+	//positions inside the padding map to the nearest edge of the image
+	if (p_Position < p_ContentStart)
+		return 0;
+
+	return K15_IA_MIN(p_Position - p_ContentStart, p_ContentSize - 1);
+}
+/*********************************************************************************/
+kia_internal void K15_IAExtrudeImageNodeRows(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNode,
+	K15_IAPixelFormat p_DestinationPixelFormat, kia_byte* p_DestinationPixelData, 
+	kia_u32 p_StartRow, kia_u32 p_EndRow)
+{
+	kia_u32 atlasStride = p_ImageAtlas->width;
+	kia_u32 padding = p_ImageNode->padding;
+	kia_u32 contentWidth = (p_ImageNode->flags & KIA_IMAGE_NODE_ROTATED) != 0 ? 
+		p_ImageNode->pixelDataHeight : p_ImageNode->pixelDataWidth;
+	kia_u32 rightEdgePosX = padding + contentWidth - 1;
+	kia_u32 rowIndex = 0;
+	kia_u32 pixelIndex = 0;
+	kia_byte* destinationPixelData = 0;
+
+	//the edge pixels of the row have already been written, copy them into the padding
+	//(the right side also covers the pixels added by the alignment)
+	for (rowIndex = p_StartRow;
+		rowIndex < p_EndRow;
+		++rowIndex)
+	{
+		destinationPixelData = p_DestinationPixelData + (p_ImageNode->rect.posX + (rowIndex - p_StartRow) * 
+			atlasStride) * p_DestinationPixelFormat;
+
+		for (pixelIndex = 0;
+			pixelIndex < padding;
+			++pixelIndex)
+		{
+			K15_IA_MEMCPY(destinationPixelData + pixelIndex * p_DestinationPixelFormat, 
+				destinationPixelData + padding * p_DestinationPixelFormat, p_DestinationPixelFormat);
+		}
+
+		for (pixelIndex = rightEdgePosX + 1;
+			pixelIndex < p_ImageNode->rect.width;
+			++pixelIndex)
+		{
+			K15_IA_MEMCPY(destinationPixelData + pixelIndex * p_DestinationPixelFormat, 
+				destinationPixelData + rightEdgePosX * p_DestinationPixelFormat, p_DestinationPixelFormat);
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal kia_u16 K15_IAConvertToR5G6B5(int* p_Color)
+{
+	return (kia_u16)(((p_Color[0] * 31 + 127) / 255) << 11 | ((p_Color[1] * 63 + 127) / 255) << 5 | 
+		((p_Color[2] * 31 + 127) / 255));
+}
+/*********************************************************************************/
+kia_internal void K15_IAConvertFromR5G6B5(kia_u32 p_Color, int* p_OutColor)
+{
+	kia_u32 red = (p_Color >> 11) & 31;
+	kia_u32 green = (p_Color >> 5) & 63;
+	kia_u32 blue = p_Color & 31;
+
+	p_OutColor[0] = (red << 3) | (red >> 2);
+	p_OutColor[1] = (green << 2) | (green >> 4);
+	p_OutColor[2] = (blue << 3) | (blue >> 2);
+}
+/*********************************************************************************/
+kia_internal void K15_IAEncodeBC4Block(kia_byte* p_Values, kia_u32 p_Stride, kia_byte* p_OutBlock)
+{
+	//index of the palette entry for each of the 8 steps between min and max
+	static const kia_u32 stepIndices[8] = {1, 7, 6, 5, 4, 3, 2, 0};
+
+	kia_u32 minValue = 255;
+	kia_u32 maxValue = 0;
+	kia_u32 range = 0;
+	kia_u32 step = 0;
+	kia_u32 pixelIndex = 0;
+	kia_u32 indices[2] = {0, 0};
+
+	for (pixelIndex = 0;
+		pixelIndex < 16;
+		++pixelIndex)
+	{
+		minValue = K15_IA_MIN(minValue, p_Values[pixelIndex * p_Stride]);
+		maxValue = K15_IA_MAX(maxValue, p_Values[pixelIndex * p_Stride]);
+	}
+
+	range = maxValue - minValue;
+
+	//max > min selects the mode with 8 interpolated values
+	for (pixelIndex = 0;
+		pixelIndex < 16;
+		++pixelIndex)
+	{
+		step = range == 0 ? 0 : ((p_Values[pixelIndex * p_Stride] - minValue) * 7 + range / 2) / range;
+		indices[pixelIndex / 8] |= stepIndices[step] << (3 * (pixelIndex % 8));
+	}
+
+	p_OutBlock[0] = (kia_byte)maxValue;
+	p_OutBlock[1] = (kia_byte)minValue;
+	p_OutBlock[2] = (kia_byte)indices[0];
+	p_OutBlock[3] = (kia_byte)(indices[0] >> 8);
+	p_OutBlock[4] = (kia_byte)(indices[0] >> 16);
+	p_OutBlock[5] = (kia_byte)indices[1];
+	p_OutBlock[6] = (kia_byte)(indices[1] >> 8);
+	p_OutBlock[7] = (kia_byte)(indices[1] >> 16);
+}
+/*********************************************************************************/
+kia_internal void K15_IAEncodeBC1Block(kia_byte* p_Pixels, kia_byte* p_OutBlock, kia_b8 p_AllowTransparency)
+{
+	int minColor[3] = {255, 255, 255};
+	int maxColor[3] = {0, 0, 0};
+	int meanColor[3] = {0, 0, 0};
+	int palette[4][3];
+	int covarianceRedGreen = 0;
+	int covarianceBlueGreen = 0;
+	int inset = 0;
+	int distance = 0;
+	int bestDistance = 0;
+	int swap = 0;
+	kia_u32 numOpaquePixels = 0;
+	kia_u32 numColors = 4;
+	kia_u32 pixelIndex = 0;
+	kia_u32 channelIndex = 0;
+	kia_u32 colorIndex = 0;
+	kia_u32 bestColorIndex = 0;
+	kia_u32 indices = 0;
+	kia_u16 color0 = 0;
+	kia_u16 color1 = 0;
+	kia_u16 color = 0;
+	kia_b8 transparent = K15_IA_FALSE;
+	kia_byte* pixel = 0;
+
+	//bounding box of the opaque pixels, transparent pixels use their own palette entry
+	for (pixelIndex = 0;
+		pixelIndex < 16;
+		++pixelIndex)
+	{
+		pixel = p_Pixels + pixelIndex * 4;
+
+		if (p_AllowTransparency && pixel[3] < 128)
+		{
+			transparent = K15_IA_TRUE;
+			continue;
+		}
+
+		for (channelIndex = 0;
+			channelIndex < 3;
+			++channelIndex)
+		{
+			minColor[channelIndex] = K15_IA_MIN(minColor[channelIndex], pixel[channelIndex]);
+			maxColor[channelIndex] = K15_IA_MAX(maxColor[channelIndex], pixel[channelIndex]);
+			meanColor[channelIndex] += pixel[channelIndex];
+		}
+
+		++numOpaquePixels;
+	}
+
+	if (numOpaquePixels == 0)
+	{
+		//color0 <= color1 and index 3 everywhere: transparent black
+		K15_IA_MEMSET(p_OutBlock, 0, 4);
+		K15_IA_MEMSET(p_OutBlock + 4, 0xFF, 4);
+		return;
+	}
+
+	for (channelIndex = 0;
+		channelIndex < 3;
+		++channelIndex)
+	{
+		meanColor[channelIndex] /= (int)numOpaquePixels;
+	}
+
+	//pick the diagonal of the bounding box that follows the colors of the block
+	for (pixelIndex = 0;
+		pixelIndex < 16;
+		++pixelIndex)
+	{
+		pixel = p_Pixels + pixelIndex * 4;
+
+		if (p_AllowTransparency && pixel[3] < 128)
+			continue;
+
+		covarianceRedGreen += (pixel[0] - meanColor[0]) * (pixel[1] - meanColor[1]);
+		covarianceBlueGreen += (pixel[2] - meanColor[2]) * (pixel[1] - meanColor[1]);
+	}
+
+	if (covarianceRedGreen < 0)
+	{
+		swap = minColor[0];
+		minColor[0] = maxColor[0];
+		maxColor[0] = swap;
+	}
+
+	if (covarianceBlueGreen < 0)
+	{
+		swap = minColor[2];
+		minColor[2] = maxColor[2];
+		maxColor[2] = swap;
+	}
+
+	//move the end points a bit inwards, the palette covers the range better that way
+	for (channelIndex = 0;
+		channelIndex < 3;
+		++channelIndex)
+	{
+		inset = (maxColor[channelIndex] - minColor[channelIndex]) / 16;
+		maxColor[channelIndex] -= inset;
+		minColor[channelIndex] += inset;
+	}
+
+	color0 = K15_IAConvertToR5G6B5(maxColor);
+	color1 = K15_IAConvertToR5G6B5(minColor);
+
+	//the order of the end points selects the mode (color0 <= color1 means 3 colors + transparent)
+	if (transparent ? color0 > color1 : color0 < color1)
+	{
+		color = color0;
+		color0 = color1;
+		color1 = color;
+	}
+
+	K15_IAConvertFromR5G6B5(color0, palette[0]);
+	K15_IAConvertFromR5G6B5(color1, palette[1]);
+
+	for (channelIndex = 0;
+		channelIndex < 3;
+		++channelIndex)
+	{
+		if (transparent)
+		{
+			palette[2][channelIndex] = (palette[0][channelIndex] + palette[1][channelIndex]) / 2;
+		}
+		else
+		{
+			palette[2][channelIndex] = (2 * palette[0][channelIndex] + palette[1][channelIndex]) / 3;
+			palette[3][channelIndex] = (palette[0][channelIndex] + 2 * palette[1][channelIndex]) / 3;
+		}
+	}
+
+	//color0 == color1 in 4 color mode decodes as 3 color mode, only index 0 is safe to use
+	if (!transparent && color0 == color1)
+		numColors = 1;
+	else if (transparent)
+		numColors = 3;
+
+	for (pixelIndex = 0;
+		pixelIndex < 16;
+		++pixelIndex)
+	{
+		pixel = p_Pixels + pixelIndex * 4;
+		bestColorIndex = 3;
+
+		if (!transparent || pixel[3] >= 128)
+		{
+			bestDistance = 0x7FFFFFFF;
+
+			for (colorIndex = 0;
+				colorIndex < numColors;
+				++colorIndex)
+			{
+				distance = (pixel[0] - palette[colorIndex][0]) * (pixel[0] - palette[colorIndex][0]) +
+					(pixel[1] - palette[colorIndex][1]) * (pixel[1] - palette[colorIndex][1]) +
+					(pixel[2] - palette[colorIndex][2]) * (pixel[2] - palette[colorIndex][2]);
+
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestColorIndex = colorIndex;
+				}
+			}
+		}
+
+		indices |= bestColorIndex << (2 * pixelIndex);
+	}
+
+	p_OutBlock[0] = (kia_byte)color0;
+	p_OutBlock[1] = (kia_byte)(color0 >> 8);
+	p_OutBlock[2] = (kia_byte)color1;
+	p_OutBlock[3] = (kia_byte)(color1 >> 8);
+	p_OutBlock[4] = (kia_byte)indices;
+	p_OutBlock[5] = (kia_byte)(indices >> 8);
+	p_OutBlock[6] = (kia_byte)(indices >> 16);
+	p_OutBlock[7] = (kia_byte)(indices >> 24);
+}
+/*********************************************************************************/
+kia_internal void K15_IAEncodeBlock(K15_IAPixelFormat p_PixelFormat, kia_byte* p_Pixels, kia_byte* p_OutBlock)
+{
+	//p_Pixels are 4x4 pixels in KIA_PIXEL_FORMAT_R8G8B8A8
+	switch (p_PixelFormat)
+	{
+		case KIA_PIXEL_FORMAT_BC1:
+			K15_IAEncodeBC1Block(p_Pixels, p_OutBlock, K15_IA_TRUE);
+			break;
+
+		case KIA_PIXEL_FORMAT_BC3:
+			K15_IAEncodeBC4Block(p_Pixels + 3, 4, p_OutBlock);
+			K15_IAEncodeBC1Block(p_Pixels, p_OutBlock + 8, K15_IA_FALSE);
+			break;
+
+		case KIA_PIXEL_FORMAT_BC4:
+			K15_IAEncodeBC4Block(p_Pixels, 4, p_OutBlock);
+			break;
+
+		case KIA_PIXEL_FORMAT_BC5:
+			K15_IAEncodeBC4Block(p_Pixels, 4, p_OutBlock);
+			K15_IAEncodeBC4Block(p_Pixels + 1, 4, p_OutBlock + 8);
+			break;
+
+		default:
+			break;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAGatherImageNodePixels(K15_IAImageNode* p_ImageNode, kia_u32 p_PosX, kia_u32 p_PosY,
+	kia_u32 p_Width, kia_u32 p_Height, K15_IAConvertRowFnc p_ConvertRowFnc, kia_byte* p_OutPixels)
+{
+	kia_b8 rotated = (p_ImageNode->flags & KIA_IMAGE_NODE_ROTATED) != 0;
+	kia_u32 contentPosX = p_ImageNode->rect.posX + p_ImageNode->padding;
+	kia_u32 contentPosY = p_ImageNode->rect.posY + p_ImageNode->padding;
+	kia_u32 contentWidth = rotated ? p_ImageNode->pixelDataHeight : p_ImageNode->pixelDataWidth;
+	kia_u32 contentHeight = rotated ? p_ImageNode->pixelDataWidth : p_ImageNode->pixelDataHeight;
+	kia_u32 sourceWidth = p_ImageNode->pixelDataWidth;
+	kia_u32 row = 0;
+	kia_u32 column = 0;
+	kia_u32 pixelX = 0;
+	kia_u32 pixelY = 0;
+	kia_u32 sourcePixelIndex = 0;
+	kia_byte* sourcePixelData = p_ImageNode->pixelData;
+	kia_byte* destinationPixel = p_OutPixels;
+
+	K15_IAPixelFormat sourcePixelFormat = p_ImageNode->pixelDataFormat;
+
+	//pixels inside the padding and alignment repeat the edge pixels of the image. 
+	//p_OutPixels is a 4x4 block, the pixels get written to the top left of it.
+	for (pixelY = 0;
+		pixelY < p_Height;
+		++pixelY)
+	{
+		row = K15_IAClampToImageNodeContent(p_PosY + pixelY, contentPosY, contentHeight);
+		destinationPixel = p_OutPixels + pixelY * K15_IA_BLOCK_DIMENSION * 4;
+
+		for (pixelX = 0;
+			pixelX < p_Width;
+			++pixelX)
+		{
+			column = K15_IAClampToImageNodeContent(p_PosX + pixelX, contentPosX, contentWidth);
+
+			//rotated images are stored transposed
+			sourcePixelIndex = rotated ? column * sourceWidth + row : row * sourceWidth + column;
+
+			if (p_ConvertRowFnc)
+				p_ConvertRowFnc(destinationPixel, sourcePixelData + sourcePixelIndex * sourcePixelFormat, 1);
+			else
+				K15_IA_MEMCPY(destinationPixel, sourcePixelData + sourcePixelIndex * sourcePixelFormat, 4);
+
+			destinationPixel += 4;
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IAIsBlockInsideRect(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_BlockX, kia_u32 p_BlockY,
+	kia_u32 p_PosX, kia_u32 p_PosY, kia_u32 p_Width, kia_u32 p_Height)
+{
+	kia_u32 blockLeft = p_BlockX * K15_IA_BLOCK_DIMENSION;
+	kia_u32 blockTop = p_BlockY * K15_IA_BLOCK_DIMENSION;
+	kia_u32 blockRight = K15_IA_MIN(blockLeft + K15_IA_BLOCK_DIMENSION, p_ImageAtlas->width);
+	kia_u32 blockBottom = K15_IA_MIN(blockTop + K15_IA_BLOCK_DIMENSION, p_ImageAtlas->height);
+
+	//blocks at the right and bottom edge of the atlas might not be complete
+	return blockLeft >= p_PosX && blockTop >= p_PosY && 
+		blockRight <= p_PosX + p_Width && blockBottom <= p_PosY + p_Height;
+}
+/*********************************************************************************/
+//p_NodeIndices are the image nodes that might overlap the block (all image nodes if NULL)
+kia_internal void K15_IAGatherAtlasBlock(K15_ImageAtlas* p_ImageAtlas, const kia_u32* p_NodeIndices, 
+	kia_u32 p_NumNodeIndices, kia_u32 p_BlockX, kia_u32 p_BlockY, kia_byte* p_OutPixels)
+{
+	kia_u32 blockLeft = p_BlockX * K15_IA_BLOCK_DIMENSION;
+	kia_u32 blockTop = p_BlockY * K15_IA_BLOCK_DIMENSION;
+	kia_u32 left = 0;
+	kia_u32 top = 0;
+	kia_u32 right = 0;
+	kia_u32 bottom = 0;
+	kia_u32 index = 0;
+	kia_u32 nodeIndex = 0;
+
+	K15_IAImageNode* imageNode = 0;
+	K15_IAConvertRowFnc convertRowFnc = 0;
+
+	//pixels that aren't covered by an image are free space
+	K15_IA_MEMSET(p_OutPixels, 0, K15_IA_BLOCK_DIMENSION * K15_IA_BLOCK_DIMENSION * 4);
+
+	//the block is shared by several images (the atlas isn't aligned to the block dimension), 
+	//so every image that overlaps the block contributes its pixels
+	for (index = 0;
+		index < p_NumNodeIndices;
+		++index)
+	{
+		nodeIndex = p_NodeIndices ? p_NodeIndices[index] : index;
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+
+		//images of a loaded atlas don't have pixel data until K15_IASetImagePixelData got called
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0 || !imageNode->pixelData)
+			continue;
+
+		left = K15_IA_MAX(blockLeft, (kia_u32)imageNode->rect.posX);
+		top = K15_IA_MAX(blockTop, (kia_u32)imageNode->rect.posY);
+		right = K15_IA_MIN(blockLeft + K15_IA_BLOCK_DIMENSION, (kia_u32)(imageNode->rect.posX + imageNode->rect.width));
+		bottom = K15_IA_MIN(blockTop + K15_IA_BLOCK_DIMENSION, (kia_u32)(imageNode->rect.posY + imageNode->rect.height));
+
+		if (left >= right || top >= bottom)
+			continue;
+
+		convertRowFnc = 0;
+
+		if (imageNode->pixelDataFormat != KIA_PIXEL_FORMAT_R8G8B8A8)
+			convertRowFnc = K15_IAGetConvertRowFnc(imageNode->pixelDataFormat, KIA_PIXEL_FORMAT_R8G8B8A8);
+
+		K15_IAGatherImageNodePixels(imageNode, left, top, right - left, bottom - top, convertRowFnc, 
+			p_OutPixels + ((top - blockTop) * K15_IA_BLOCK_DIMENSION + left - blockLeft) * 4);
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IABakeImageNodeBlocks(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNode,
+	K15_IAPixelFormat p_DestinationPixelFormat, kia_byte* p_DestinationPixelData, 
+	kia_u32 p_StartRow, kia_u32 p_EndRow)
+{
+	kia_byte blockPixels[K15_IA_BLOCK_DIMENSION * K15_IA_BLOCK_DIMENSION * 4];
+
+	kia_u32 blockSizeInBytes = K15_IAGetBlockSizeInBytes(p_DestinationPixelFormat);
+	kia_u32 numBlocksPerRow = (p_ImageAtlas->width + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION;
+	kia_u32 startBlockX = p_ImageNode->rect.posX / K15_IA_BLOCK_DIMENSION;
+	kia_u32 endBlockX = (p_ImageNode->rect.posX + p_ImageNode->rect.width + K15_IA_BLOCK_DIMENSION - 1) / 
+		K15_IA_BLOCK_DIMENSION;
+	kia_u32 startBlockY = p_StartRow / K15_IA_BLOCK_DIMENSION;
+	kia_u32 endBlockY = (p_EndRow + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION;
+	kia_u32 blockX = 0;
+	kia_u32 blockY = 0;
+
+	K15_IAConvertRowFnc convertRowFnc = 0;
+
+	//blocks get encoded from 4x4 pixels in R8G8B8A8
+	if (p_ImageNode->pixelDataFormat != KIA_PIXEL_FORMAT_R8G8B8A8)
+		convertRowFnc = K15_IAGetConvertRowFnc(p_ImageNode->pixelDataFormat, KIA_PIXEL_FORMAT_R8G8B8A8);
+
+	for (blockY = startBlockY;
+		blockY < endBlockY;
+		++blockY)
+	{
+		for (blockX = startBlockX;
+			blockX < endBlockX;
+			++blockX)
+		{
+			if (K15_IAIsBlockInsideRect(p_ImageAtlas, blockX, blockY, p_ImageNode->rect.posX, 
+				p_ImageNode->rect.posY, p_ImageNode->rect.width, p_ImageNode->rect.height))
+			{
+				K15_IAGatherImageNodePixels(p_ImageNode, blockX * K15_IA_BLOCK_DIMENSION, 
+					blockY * K15_IA_BLOCK_DIMENSION, K15_IA_BLOCK_DIMENSION, K15_IA_BLOCK_DIMENSION, 
+					convertRowFnc, blockPixels);
+			}
+			else
+			{
+				//only happens if the atlas alignment is smaller than the block dimension
+				K15_IAGatherAtlasBlock(p_ImageAtlas, 0, p_ImageAtlas->numImageNodes, blockX, blockY, blockPixels);
+			}
+
+			K15_IAEncodeBlock(p_DestinationPixelFormat, blockPixels, 
+				p_DestinationPixelData + ((blockY - startBlockY) * numBlocksPerRow + blockX) * blockSizeInBytes);
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IABakeTransposedImageNodeRows(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNode,
+	K15_IAPixelFormat p_DestinationPixelFormat, kia_byte* p_DestinationPixelData, 
+	kia_u32 p_StartRow, kia_u32 p_EndRow)
+{
+	kia_byte tile[K15_IA_TRANSPOSE_BLOCK_SIZE * K15_IA_TRANSPOSE_BLOCK_SIZE * 4];
+	kia_u32 sourceColumnOffsets[K15_IA_TRANSPOSE_BLOCK_SIZE];
+
+	kia_u32 atlasStride = p_ImageAtlas->width;
+	kia_u32 padding = p_ImageNode->padding;
+	kia_u32 imageNodeWidth = p_ImageNode->pixelDataHeight; //rect is the transposed area
+	kia_u32 imageNodePosX = p_ImageNode->rect.posX + padding;
+	kia_u32 imageNodePosY = p_ImageNode->rect.posY + padding;
+	kia_u32 sourceWidth = p_ImageNode->pixelDataWidth;
+	kia_u32 blockRow = 0;
+	kia_u32 blockColumn = 0;
+	kia_u32 numBlockRows = 0;
+	kia_u32 numBlockColumns = 0;
+	kia_u32 rowIndex = 0;
+	kia_u32 columnIndex = 0;
+	kia_u32 byteIndex = 0;
+	kia_byte* imageNodePixelData = p_ImageNode->pixelData;
+	kia_byte* sourcePixelData = 0;
+	kia_byte* tilePixelData = 0;
+	kia_byte* destinationPixelData = 0;
+
+	K15_IAPixelFormat imageNodePixelFormat = p_ImageNode->pixelDataFormat;
+	K15_IAConvertRowFnc convertRowFnc = 0;
+
+	if (imageNodePixelFormat != p_DestinationPixelFormat)
+		convertRowFnc = K15_IAGetConvertRowFnc(imageNodePixelFormat, p_DestinationPixelFormat);
+
+	//Row y of the atlas area is column (y - posY) of the image. Reading a whole column per row 
+	//would touch a new cache line for every pixel, so the image gets transposed tile by tile.
+	//Each tile is read row by row from the image and written row by row into the atlas.
+	for (blockRow = p_StartRow;
+		blockRow < p_EndRow;
+		blockRow += K15_IA_TRANSPOSE_BLOCK_SIZE)
+	{
+		numBlockRows = K15_IA_MIN(K15_IA_TRANSPOSE_BLOCK_SIZE, p_EndRow - blockRow);
+
+		//rows inside the padding repeat the first/last column of the image
+		for (rowIndex = 0;
+			rowIndex < numBlockRows;
+			++rowIndex)
+		{
+			sourceColumnOffsets[rowIndex] = K15_IAClampToImageNodeContent(blockRow + rowIndex, 
+				imageNodePosY, sourceWidth) * imageNodePixelFormat;
+		}
+
+		for (blockColumn = 0;
+			blockColumn < imageNodeWidth;
+			blockColumn += K15_IA_TRANSPOSE_BLOCK_SIZE)
+		{
+			numBlockColumns = K15_IA_MIN(K15_IA_TRANSPOSE_BLOCK_SIZE, imageNodeWidth - blockColumn);
+
+			//gather: image row (blockColumn + columnIndex) becomes tile column columnIndex
+			for (columnIndex = 0;
+				columnIndex < numBlockColumns;
+				++columnIndex)
+			{
+				sourcePixelData = imageNodePixelData + (blockColumn + columnIndex) * sourceWidth * imageNodePixelFormat;
+				tilePixelData = tile + columnIndex * imageNodePixelFormat;
+
+				for (rowIndex = 0;
+					rowIndex < numBlockRows;
+					++rowIndex)
+				{
+					for (byteIndex = 0;
+						byteIndex < (kia_u32)imageNodePixelFormat;
+						++byteIndex)
+					{
+						tilePixelData[byteIndex] = sourcePixelData[sourceColumnOffsets[rowIndex] + byteIndex];
+					}
+
+					tilePixelData += K15_IA_TRANSPOSE_BLOCK_SIZE * imageNodePixelFormat;
+				}
+			}
+
+			//scatter: every tile row is a contiguous part of an atlas row
+			for (rowIndex = 0;
+				rowIndex < numBlockRows;
+				++rowIndex)
+			{
+				destinationPixelData = p_DestinationPixelData + (imageNodePosX + blockColumn + 
+					(blockRow - p_StartRow + rowIndex) * atlasStride) * p_DestinationPixelFormat;
+				tilePixelData = tile + rowIndex * K15_IA_TRANSPOSE_BLOCK_SIZE * imageNodePixelFormat;
+
+				if (convertRowFnc)
+					convertRowFnc(destinationPixelData, tilePixelData, numBlockColumns);
+				else
+					K15_IA_MEMCPY(destinationPixelData, tilePixelData, numBlockColumns * imageNodePixelFormat);
+			}
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IABakeImageNodeRows(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNode,
+	K15_IAPixelFormat p_DestinationPixelFormat, kia_byte* p_DestinationPixelData, 
+	kia_u32 p_StartRow, kia_u32 p_EndRow)
+{
+	kia_u32 atlasStride = p_ImageAtlas->width;
+	kia_u32 padding = p_ImageNode->padding;
+	kia_u32 imageNodeWidth = p_ImageNode->pixelDataWidth;
+	kia_u32 imageNodeHeight = p_ImageNode->pixelDataHeight;
+	kia_u32 imageNodePosX = p_ImageNode->rect.posX + padding;
+	kia_u32 imageNodePosY = p_ImageNode->rect.posY + padding;
+	kia_u32 startRow = K15_IA_MAX(p_StartRow, p_ImageNode->rect.posY);
+	kia_u32 endRow = K15_IA_MIN(p_EndRow, (kia_u32)(p_ImageNode->rect.posY + p_ImageNode->rect.height));
+	kia_u32 destinationPixelDataOffset = 0;
+	kia_u32 imageNodePixelDataOffset = 0;
+	kia_u32 rowIndex = 0;
+	kia_byte* imageNodePixelData = p_ImageNode->pixelData;
+	kia_byte* destinationPixelData = 0;
+
+	K15_IAPixelFormat imageNodePixelFormat = p_ImageNode->pixelDataFormat;
+	K15_IAConvertRowFnc convertRowFnc = 0;
+
+	if (startRow >= endRow)
+		return;
+
+	//p_DestinationPixelData points to row p_StartRow, the functions below expect a pointer to startRow
+	destinationPixelData = p_DestinationPixelData + 
+		K15_IACalculateRowOffsetInBytes(p_ImageAtlas, p_DestinationPixelFormat, startRow) -
+		K15_IACalculateRowOffsetInBytes(p_ImageAtlas, p_DestinationPixelFormat, p_StartRow);
+
+	if (K15_IAIsBlockCompressedPixelFormat(p_DestinationPixelFormat))
+	{
+		K15_IABakeImageNodeBlocks(p_ImageAtlas, p_ImageNode, p_DestinationPixelFormat, 
+			destinationPixelData, startRow, endRow);
+
+		//the padding is part of the blocks
+		return;
+	}
+
+	if ((p_ImageNode->flags & KIA_IMAGE_NODE_ROTATED) != 0)
+	{
+		K15_IABakeTransposedImageNodeRows(p_ImageAtlas, p_ImageNode, p_DestinationPixelFormat,
+			destinationPixelData, startRow, endRow);
+	}
+	else
+	{
+		//pick the conversion once per image instead of per pixel
+		if (imageNodePixelFormat != p_DestinationPixelFormat)
+			convertRowFnc = K15_IAGetConvertRowFnc(imageNodePixelFormat, p_DestinationPixelFormat);
+
+		//rows inside the padding repeat the first/last row of the image
+		for (rowIndex = startRow;
+			rowIndex < endRow;
+			++rowIndex)
+		{
+			destinationPixelDataOffset = (imageNodePosX + (rowIndex - startRow) * atlasStride) * p_DestinationPixelFormat;
+			imageNodePixelDataOffset = K15_IAClampToImageNodeContent(rowIndex, imageNodePosY, imageNodeHeight) * 
+				imageNodeWidth * imageNodePixelFormat;
+
+			//Convert pixels if formats mismatch
+			if (convertRowFnc)
+			{
+				convertRowFnc(destinationPixelData + destinationPixelDataOffset,
+					imageNodePixelData + imageNodePixelDataOffset, imageNodeWidth);
+			}
+			else
+			{
+				K15_IA_MEMCPY(destinationPixelData + destinationPixelDataOffset,
+					imageNodePixelData + imageNodePixelDataOffset, imageNodeWidth * imageNodePixelFormat);
+			}
+		}
+	}
+
+	//extrude the edge pixels into the padding (and the alignment) while the rows are still in the cache
+	if (padding > 0 || p_ImageAtlas->alignment > 1)
+	{
+		K15_IAExtrudeImageNodeRows(p_ImageAtlas, p_ImageNode, p_DestinationPixelFormat,
+			destinationPixelData, startRow, endRow);
+	}
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IACalculateNumMipLevels(kia_u32 p_Width, kia_u32 p_Height)
+{
+	kia_u32 numMipLevels = 1;
+
+	while (p_Width > 1 || p_Height > 1)
+	{
+		p_Width = K15_IA_MAX(p_Width >> 1, 1);
+		p_Height = K15_IA_MAX(p_Height >> 1, 1);
+		++numMipLevels;
+	}
+
+	return numMipLevels;
+}
+/*********************************************************************************/
+kia_internal void K15_IACalculateMipLevelRange(kia_u32 p_Start, kia_u32 p_End, kia_u32* p_OutStart, 
+	kia_u32* p_OutEnd)
+{
+	//every image keeps at least one pixel per mip level
+	*p_OutStart = p_Start >> 1;
+	*p_OutEnd = K15_IA_MAX(*p_OutStart + 1, p_End >> 1);
+}
+/*********************************************************************************/
+kia_internal void K15_IADownsampleImageNodeBox(kia_byte* p_SourcePixelData, kia_u32 p_SourceStride,
+	kia_u32 p_SourceStartX, kia_u32 p_SourceEndX, kia_u32 p_SourceStartY, kia_u32 p_SourceEndY,
+	kia_byte* p_DestinationPixelData, kia_u32 p_DestinationStride, kia_u32 p_StartX, kia_u32 p_EndX, 
+	kia_u32 p_StartY, kia_u32 p_EndY, K15_IAPixelFormat p_PixelFormat)
+{
+	kia_u32 pixelX = 0;
+	kia_u32 pixelY = 0;
+	kia_u32 channelIndex = 0;
+	kia_u32 sourceLeft = 0;
+	kia_u32 sourceRight = 0;
+	kia_byte* sourceTopRow = 0;
+	kia_byte* sourceBottomRow = 0;
+	kia_byte* destinationPixel = 0;
+
+#ifdef K15_IA_SSE2
+	__m128i top;
+	__m128i bottom;
+	__m128i zero = _mm_setzero_si128();
+	__m128i rounding = _mm_set1_epi16(2);
+	__m128i sumLow;
+	__m128i sumHigh;
+#endif //K15_IA_SSE2
+
+	for (pixelY = p_StartY;
+		pixelY < p_EndY;
+		++pixelY)
+	{
+		//samples outside of the image get clamped to the edge of the image
+		sourceTopRow = p_SourcePixelData + K15_IA_MAX(2 * pixelY, p_SourceStartY) * p_SourceStride * p_PixelFormat;
+		sourceBottomRow = p_SourcePixelData + K15_IA_MIN(2 * pixelY + 1, p_SourceEndY - 1) * p_SourceStride * p_PixelFormat;
+		destinationPixel = p_DestinationPixelData + (pixelY * p_DestinationStride + p_StartX) * p_PixelFormat;
+
+		for (pixelX = p_StartX;
+			pixelX < p_EndX;
+			++pixelX)
+		{
+			sourceLeft = K15_IA_MAX(2 * pixelX, p_SourceStartX) * p_PixelFormat;
+			sourceRight = K15_IA_MIN(2 * pixelX + 1, p_SourceEndX - 1) * p_PixelFormat;
+
+#ifdef K15_IA_SSE2
+			//two RGBA pixels at once if none of their samples have to be clamped
+			if (p_PixelFormat == KIA_PIXEL_FORMAT_R8G8B8A8 && pixelX + 1 < p_EndX &&
+				2 * pixelX >= p_SourceStartX && 2 * pixelX + 3 < p_SourceEndX)
+			{
+				top = _mm_loadu_si128((const __m128i*)(sourceTopRow + sourceLeft));
+				bottom = _mm_loadu_si128((const __m128i*)(sourceBottomRow + sourceLeft));
+
+				//16 bit sums of the vertical pairs (low: pixels 0 and 1, high: pixels 2 and 3)
+				sumLow = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+				sumHigh = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+
+				//add the horizontal pairs (0 + 1, 2 + 3), round and divide by 4
+				sumLow = _mm_add_epi16(_mm_unpacklo_epi64(sumLow, sumHigh), _mm_unpackhi_epi64(sumLow, sumHigh));
+				sumLow = _mm_srli_epi16(_mm_add_epi16(sumLow, rounding), 2);
+
+				_mm_storel_epi64((__m128i*)destinationPixel, _mm_packus_epi16(sumLow, sumLow));
+
+				destinationPixel += 2 * p_PixelFormat;
+				++pixelX;
+				continue;
+			}
+#endif //K15_IA_SSE2
+
+			for (channelIndex = 0;
+				channelIndex < (kia_u32)p_PixelFormat;
+				++channelIndex)
+			{
+				destinationPixel[channelIndex] = (kia_byte)((sourceTopRow[sourceLeft + channelIndex] + 
+					sourceTopRow[sourceRight + channelIndex] + sourceBottomRow[sourceLeft + channelIndex] +
+					sourceBottomRow[sourceRight + channelIndex] + 2) >> 2);
+			}
+
+			destinationPixel += p_PixelFormat;
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IADownsampleImageNodeKaiser(kia_byte* p_SourcePixelData, kia_u32 p_SourceStride,
+	kia_u32 p_SourceStartX, kia_u32 p_SourceEndX, kia_u32 p_SourceStartY, kia_u32 p_SourceEndY,
+	kia_byte* p_DestinationPixelData, kia_u32 p_DestinationStride, kia_u32 p_StartX, kia_u32 p_EndX, 
+	kia_u32 p_StartY, kia_u32 p_EndY, K15_IAPixelFormat p_PixelFormat)
+{
+	//Kaiser windowed sinc (alpha = 4) for a 2:1 reduction, 8 bit fixed point (sums up to 256)
+	static const int kaiserWeights[K15_IA_KAISER_NUM_TAPS] = {-6, 27, 107, 107, 27, -6};
+
+	int sums[4];
+	int sourceX = 0;
+	int sourceY = 0;
+	int weight = 0;
+	kia_u32 pixelX = 0;
+	kia_u32 pixelY = 0;
+	kia_u32 tapX = 0;
+	kia_u32 tapY = 0;
+	kia_u32 channelIndex = 0;
+	kia_u32 sourceOffsetsX[K15_IA_KAISER_NUM_TAPS];
+	kia_byte* sourceRow = 0;
+	kia_byte* sourcePixel = 0;
+	kia_byte* destinationPixel = 0;
+
+	for (pixelY = p_StartY;
+		pixelY < p_EndY;
+		++pixelY)
+	{
+		destinationPixel = p_DestinationPixelData + (pixelY * p_DestinationStride + p_StartX) * p_PixelFormat;
+
+		for (pixelX = p_StartX;
+			pixelX < p_EndX;
+			++pixelX)
+		{
+			sums[0] = sums[1] = sums[2] = sums[3] = 1 << 15;
+
+			//taps outside of the image get clamped to the edge of the image
+			for (tapX = 0;
+				tapX < K15_IA_KAISER_NUM_TAPS;
+				++tapX)
+			{
+				sourceX = (int)(2 * pixelX + tapX) - K15_IA_KAISER_NUM_TAPS / 2 + 1;
+				sourceX = K15_IA_MAX(sourceX, (int)p_SourceStartX);
+				sourceX = K15_IA_MIN(sourceX, (int)p_SourceEndX - 1);
+				sourceOffsetsX[tapX] = sourceX * p_PixelFormat;
+			}
+
+			for (tapY = 0;
+				tapY < K15_IA_KAISER_NUM_TAPS;
+				++tapY)
+			{
+				sourceY = (int)(2 * pixelY + tapY) - K15_IA_KAISER_NUM_TAPS / 2 + 1;
+				sourceY = K15_IA_MAX(sourceY, (int)p_SourceStartY);
+				sourceY = K15_IA_MIN(sourceY, (int)p_SourceEndY - 1);
+				sourceRow = p_SourcePixelData + sourceY * p_SourceStride * p_PixelFormat;
+
+				for (tapX = 0;
+					tapX < K15_IA_KAISER_NUM_TAPS;
+					++tapX)
+				{
+					weight = kaiserWeights[tapY] * kaiserWeights[tapX];
+					sourcePixel = sourceRow + sourceOffsetsX[tapX];
+
+					for (channelIndex = 0;
+						channelIndex < (kia_u32)p_PixelFormat;
+						++channelIndex)
+					{
+						sums[channelIndex] += weight * sourcePixel[channelIndex];
+					}
+				}
+			}
+
+			//the negative lobes can over- and undershoot
+			for (channelIndex = 0;
+				channelIndex < (kia_u32)p_PixelFormat;
+				++channelIndex)
+			{
+				sums[channelIndex] = K15_IA_MAX(sums[channelIndex], 0) >> 16;
+				destinationPixel[channelIndex] = (kia_byte)K15_IA_MIN(sums[channelIndex], 255);
+			}
+
+			destinationPixel += p_PixelFormat;
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IABakeImageNodeMipLevels(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNode,
+	K15_IAPixelFormat p_DestinationPixelFormat, kia_byte* p_DestinationPixelData, kia_u32 p_NumMipLevels,
+	K15_IAMipFilter p_MipFilter)
+{
+	kia_u32 mipLevel = 0;
+	kia_u32 sourceWidth = p_ImageAtlas->width;
+	kia_u32 sourceHeight = p_ImageAtlas->height;
+	kia_u32 sourceStartX = p_ImageNode->rect.posX;
+	kia_u32 sourceEndX = sourceStartX + p_ImageNode->rect.width;
+	kia_u32 sourceStartY = p_ImageNode->rect.posY;
+	kia_u32 sourceEndY = sourceStartY + p_ImageNode->rect.height;
+	kia_u32 destinationWidth = 0;
+	kia_u32 destinationHeight = 0;
+	kia_u32 startX = 0;
+	kia_u32 endX = 0;
+	kia_u32 startY = 0;
+	kia_u32 endY = 0;
+	kia_byte* sourcePixelData = p_DestinationPixelData;
+	kia_byte* destinationPixelData = 0;
+
+	//every level only reads the pixels of this image from the previous level, 
+	//which have just been written and are most likely still in the cache
+	for (mipLevel = 1;
+		mipLevel < p_NumMipLevels;
+		++mipLevel)
+	{
+		destinationWidth = K15_IA_MAX(sourceWidth >> 1, 1);
+		destinationHeight = K15_IA_MAX(sourceHeight >> 1, 1);
+		destinationPixelData = sourcePixelData + sourceWidth * sourceHeight * p_DestinationPixelFormat;
+
+		K15_IACalculateMipLevelRange(sourceStartX, sourceEndX, &startX, &endX);
+		K15_IACalculateMipLevelRange(sourceStartY, sourceEndY, &startY, &endY);
+
+		if (p_MipFilter == KIA_MIP_FILTER_KAISER)
+		{
+			K15_IADownsampleImageNodeKaiser(sourcePixelData, sourceWidth, sourceStartX, sourceEndX, 
+				sourceStartY, sourceEndY, destinationPixelData, destinationWidth, startX, endX, 
+				startY, endY, p_DestinationPixelFormat);
+		}
+		else
+		{
+			K15_IADownsampleImageNodeBox(sourcePixelData, sourceWidth, sourceStartX, sourceEndX, 
+				sourceStartY, sourceEndY, destinationPixelData, destinationWidth, startX, endX, 
+				startY, endY, p_DestinationPixelFormat);
+		}
+
+		sourcePixelData = destinationPixelData;
+		sourceWidth = destinationWidth;
+		sourceHeight = destinationHeight;
+		sourceStartX = startX;
+		sourceEndX = endX;
+		sourceStartY = startY;
+		sourceEndY = endY;
+	}
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IAIsFreeSpaceFullyTracked(K15_ImageAtlas* p_ImageAtlas)
+{
+	kia_u32 trackedArea = K15_IACalculateUsedAtlasArea(p_ImageAtlas);
+	kia_u32 skylineIndex = 0;
+	kia_u32 rectIndex = 0;
+
+	K15_IASkyline* skyline = 0;
+	K15_IARect* rect = 0;
+
+	//maximal rects overlap each other, so their area doesn't add up
+	if (K15_IAIsMaxRectsPacker(p_ImageAtlas->packer))
+		return K15_IA_FALSE;
+
+	//the free space is tracked by the skylines (everything above them) and the wasted space
+	//rects. Wasted space rects can get lost (e.g. K15_IA_MAX_WASTED_SPACE_RECTS is too small),
+	//in that case the tracked area doesn't add up to the area of the atlas
+	for (skylineIndex = 0;
+		skylineIndex < p_ImageAtlas->numSkylines;
+		++skylineIndex)
+	{
+		skyline = p_ImageAtlas->skylines + skylineIndex;
+		trackedArea += skyline->baseLineWidth * (p_ImageAtlas->height - skyline->baseLinePosY);
+	}
+
+	for (rectIndex = 0;
+		rectIndex < p_ImageAtlas->numWastedSpaceRects;
+		++rectIndex)
+	{
+		rect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+		trackedArea += rect->width * rect->height;
+	}
+
+	return trackedArea == p_ImageAtlas->width * p_ImageAtlas->height;
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IAIsImageNodeInsideBlockColumn(K15_IAImageNode* p_ImageNode, kia_u32 p_BlockX)
+{
+	kia_u32 blockLeft = p_BlockX * K15_IA_BLOCK_DIMENSION;
+
+	return p_ImageNode->rect.posX < blockLeft + K15_IA_BLOCK_DIMENSION && 
+		(kia_u32)(p_ImageNode->rect.posX + p_ImageNode->rect.width) > blockLeft;
+}
+/*********************************************************************************/
+//Bake all images into a block compressed pixel buffer one block row at a time. Used if the atlas
+//alignment is smaller than the block dimension: Blocks that are shared by several images get
+//gathered only from the images that overlap the block row and get encoded only once (by the 
+//first image that overlaps them).
+kia_internal void K15_IABakeAtlasBlockRows(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_DestinationPixelFormat,
+	kia_byte* p_DestinationPixelData, kia_u32 p_StartRow, kia_u32 p_EndRow)
+{
+	kia_u32 rowNodeIndices[K15_IA_MAX_BLOCK_ROW_IMAGES];
+	kia_byte blockPixels[K15_IA_BLOCK_DIMENSION * K15_IA_BLOCK_DIMENSION * 4];
+
+	kia_u32 blockSizeInBytes = K15_IAGetBlockSizeInBytes(p_DestinationPixelFormat);
+	kia_u32 numBlocksPerRow = (p_ImageAtlas->width + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION;
+	kia_u32 startBlockY = p_StartRow / K15_IA_BLOCK_DIMENSION;
+	kia_u32 endBlockY = (p_EndRow + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION;
+	kia_u32 blockTop = 0;
+	kia_u32 blockBottom = 0;
+	kia_u32 blockX = 0;
+	kia_u32 blockY = 0;
+	kia_u32 endBlockX = 0;
+	kia_u32 nodeIndex = 0;
+	kia_u32 rowNodeIndex = 0;
+	kia_u32 previousRowNodeIndex = 0;
+	kia_u32 numRowNodes = 0;
+	kia_b8 sharedWithPreviousNode = K15_IA_FALSE;
+	kia_byte* destinationBlockRow = 0;
+
+	K15_IAImageNode* imageNode = 0;
+	K15_IAConvertRowFnc convertRowFnc = 0;
+
+	for (blockY = startBlockY;
+		blockY < endBlockY;
+		++blockY)
+	{
+		blockTop = blockY * K15_IA_BLOCK_DIMENSION;
+		blockBottom = K15_IA_MIN(blockTop + K15_IA_BLOCK_DIMENSION, p_ImageAtlas->height);
+		destinationBlockRow = p_DestinationPixelData + (blockY - startBlockY) * numBlocksPerRow * blockSizeInBytes;
+		numRowNodes = 0;
+
+		for (nodeIndex = 0;
+			nodeIndex < p_ImageAtlas->numImageNodes && numRowNodes <= K15_IA_MAX_BLOCK_ROW_IMAGES;
+			++nodeIndex)
+		{
+			imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+
+			if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0 || imageNode->rect.posY >= blockBottom ||
+				(kia_u32)(imageNode->rect.posY + imageNode->rect.height) <= blockTop)
+			{
+				continue;
+			}
+
+			if (numRowNodes < K15_IA_MAX_BLOCK_ROW_IMAGES)
+				rowNodeIndices[numRowNodes] = nodeIndex;
+
+			++numRowNodes;
+		}
+
+		//too many images in this block row, bake them one by one (shared blocks get
+		//gathered from all images)
+		if (numRowNodes > K15_IA_MAX_BLOCK_ROW_IMAGES)
+		{
+			for (nodeIndex = 0;
+				nodeIndex < p_ImageAtlas->numImageNodes;
+				++nodeIndex)
+			{
+				if ((p_ImageAtlas->imageNodes[nodeIndex].flags & KIA_IMAGE_NODE_REMOVED) != 0)
+					continue;
+
+				K15_IABakeImageNodeRows(p_ImageAtlas, p_ImageAtlas->imageNodes + nodeIndex, 
+					p_DestinationPixelFormat, destinationBlockRow, blockTop, blockBottom);
+			}
+
+			continue;
+		}
+
+		for (rowNodeIndex = 0;
+			rowNodeIndex < numRowNodes;
+			++rowNodeIndex)
+		{
+			imageNode = p_ImageAtlas->imageNodes + rowNodeIndices[rowNodeIndex];
+			endBlockX = (imageNode->rect.posX + imageNode->rect.width + K15_IA_BLOCK_DIMENSION - 1) / 
+				K15_IA_BLOCK_DIMENSION;
+			convertRowFnc = 0;
+
+			//blocks get encoded from 4x4 pixels in R8G8B8A8
+			if (imageNode->pixelDataFormat != KIA_PIXEL_FORMAT_R8G8B8A8)
+				convertRowFnc = K15_IAGetConvertRowFnc(imageNode->pixelDataFormat, KIA_PIXEL_FORMAT_R8G8B8A8);
+
+			for (blockX = imageNode->rect.posX / K15_IA_BLOCK_DIMENSION;
+				blockX < endBlockX;
+				++blockX)
+			{
+				if (K15_IAIsBlockInsideRect(p_ImageAtlas, blockX, blockY, imageNode->rect.posX, 
+					imageNode->rect.posY, imageNode->rect.width, imageNode->rect.height))
+				{
+					K15_IAGatherImageNodePixels(imageNode, blockX * K15_IA_BLOCK_DIMENSION, 
+						blockY * K15_IA_BLOCK_DIMENSION, K15_IA_BLOCK_DIMENSION, K15_IA_BLOCK_DIMENSION, 
+						convertRowFnc, blockPixels);
+				}
+				else
+				{
+					sharedWithPreviousNode = K15_IA_FALSE;
+
+					for (previousRowNodeIndex = 0;
+						previousRowNodeIndex < rowNodeIndex && !sharedWithPreviousNode;
+						++previousRowNodeIndex)
+					{
+						sharedWithPreviousNode = K15_IAIsImageNodeInsideBlockColumn(
+							p_ImageAtlas->imageNodes + rowNodeIndices[previousRowNodeIndex], blockX);
+					}
+
+					//the block has already been encoded
+					if (sharedWithPreviousNode)
+						continue;
+
+					K15_IAGatherAtlasBlock(p_ImageAtlas, rowNodeIndices, numRowNodes, blockX, blockY, blockPixels);
+				}
+
+				K15_IAEncodeBlock(p_DestinationPixelFormat, blockPixels, 
+					destinationBlockRow + blockX * blockSizeInBytes);
+			}
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAClearAtlasBlocks(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_DestinationPixelFormat,
+	kia_byte* p_DestinationPixelData, kia_u32 p_PosX, kia_u32 p_Width, kia_u32 p_StartRow, kia_u32 p_EndRow,
+	kia_b8 p_KeepImages)
+{
+	kia_byte clearPixels[K15_IA_BLOCK_DIMENSION * K15_IA_BLOCK_DIMENSION * 4] = {0};
+	kia_byte blockPixels[K15_IA_BLOCK_DIMENSION * K15_IA_BLOCK_DIMENSION * 4];
+	kia_byte clearBlock[16];
+	kia_byte* destinationBlock = 0;
+
+	kia_u32 blockSizeInBytes = K15_IAGetBlockSizeInBytes(p_DestinationPixelFormat);
+	kia_u32 numBlocksPerRow = (p_ImageAtlas->width + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION;
+	kia_u32 startBlockX = p_PosX / K15_IA_BLOCK_DIMENSION;
+	kia_u32 endBlockX = (p_PosX + p_Width + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION;
+	kia_u32 startBlockY = p_StartRow / K15_IA_BLOCK_DIMENSION;
+	kia_u32 endBlockY = (p_EndRow + K15_IA_BLOCK_DIMENSION - 1) / K15_IA_BLOCK_DIMENSION;
+	kia_u32 blockX = 0;
+	kia_u32 blockY = 0;
+
+	//all zero bytes don't decode to transparent black in every format (e.g. BC1)
+	K15_IAEncodeBlock(p_DestinationPixelFormat, clearPixels, clearBlock);
+
+	for (blockY = startBlockY;
+		blockY < endBlockY;
+		++blockY)
+	{
+		for (blockX = startBlockX;
+			blockX < endBlockX;
+			++blockX)
+		{
+			destinationBlock = p_DestinationPixelData + ((blockY - startBlockY) * numBlocksPerRow + blockX) * blockSizeInBytes;
+
+			//blocks that are shared with images which don't get baked again have to keep their pixels
+			if (p_KeepImages && !K15_IAIsBlockInsideRect(p_ImageAtlas, blockX, blockY, p_PosX, p_StartRow, 
+				p_Width, p_EndRow - p_StartRow))
+			{
+				K15_IAGatherAtlasBlock(p_ImageAtlas, 0, p_ImageAtlas->numImageNodes, blockX, blockY, blockPixels);
+				K15_IAEncodeBlock(p_DestinationPixelFormat, blockPixels, destinationBlock);
+			}
+			else
+			{
+				K15_IA_MEMCPY(destinationBlock, clearBlock, blockSizeInBytes);
+			}
+		}
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAClearAtlasRect(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_DestinationPixelFormat,
+	kia_byte* p_DestinationPixelData, kia_u32 p_PosX, kia_u32 p_PosY, kia_u32 p_Width, kia_u32 p_Height,
+	kia_u32 p_StartRow, kia_u32 p_EndRow, kia_b8 p_KeepImages)
+{
+	kia_u32 startRow = K15_IA_MAX(p_StartRow, p_PosY);
+	kia_u32 endRow = K15_IA_MIN(p_EndRow, p_PosY + p_Height);
+	kia_u32 rowSizeInBytes = p_DestinationPixelFormat * p_ImageAtlas->width;
+	kia_u32 rowIndex = 0;
+	kia_byte* destinationPixelData = p_DestinationPixelData + p_PosX * p_DestinationPixelFormat;
+
+	if (startRow >= endRow)
+		return;
+
+	if (K15_IAIsBlockCompressedPixelFormat(p_DestinationPixelFormat))
+	{
+		K15_IAClearAtlasBlocks(p_ImageAtlas, p_DestinationPixelFormat, p_DestinationPixelData + 
+			K15_IACalculateRowOffsetInBytes(p_ImageAtlas, p_DestinationPixelFormat, startRow) -
+			K15_IACalculateRowOffsetInBytes(p_ImageAtlas, p_DestinationPixelFormat, p_StartRow), 
+			p_PosX, p_Width, startRow, endRow, p_KeepImages);
+		return;
+	}
+
+	for (rowIndex = startRow;
+		rowIndex < endRow;
+		++rowIndex)
+	{
+		K15_IA_MEMSET(destinationPixelData + (rowIndex - p_StartRow) * rowSizeInBytes, 0, p_Width * p_DestinationPixelFormat);
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAClearAtlasFreeSpace(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_DestinationPixelFormat,
+	kia_byte* p_DestinationPixelData, kia_u32 p_StartRow, kia_u32 p_EndRow, kia_b8 p_KeepImages)
+{
+	kia_u32 skylineIndex = 0;
+	kia_u32 rectIndex = 0;
+
+	K15_IASkyline* skyline = 0;
+	K15_IARect* rect = 0;
+
+	for (skylineIndex = 0;
+		skylineIndex < p_ImageAtlas->numSkylines;
+		++skylineIndex)
+	{
+		skyline = p_ImageAtlas->skylines + skylineIndex;
+		K15_IAClearAtlasRect(p_ImageAtlas, p_DestinationPixelFormat, p_DestinationPixelData, 
+			skyline->baseLinePosX, skyline->baseLinePosY, skyline->baseLineWidth, 
+			p_ImageAtlas->height - skyline->baseLinePosY, p_StartRow, p_EndRow, p_KeepImages);
+	}
+
+	for (rectIndex = 0;
+		rectIndex < p_ImageAtlas->numWastedSpaceRects;
+		++rectIndex)
+	{
+		rect = p_ImageAtlas->wastedSpaceRects + rectIndex;
+		K15_IAClearAtlasRect(p_ImageAtlas, p_DestinationPixelFormat, p_DestinationPixelData, 
+			rect->posX, rect->posY, rect->width, rect->height, p_StartRow, p_EndRow, p_KeepImages);
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAClearAtlasRows(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_DestinationPixelFormat,
+	kia_byte* p_DestinationPixelData, kia_u32 p_StartRow, kia_u32 p_EndRow, kia_u32 p_BakeFlags)
+{
+	kia_u32 atlasStride = p_ImageAtlas->width;
+
+	if ((p_BakeFlags & KIA_BAKE_SKIP_CLEAR) != 0)
+	{
+		//nothing to clear
+	}
+	else if ((p_BakeFlags & KIA_BAKE_CLEAR_ALL) != 0 && K15_IAIsBlockCompressedPixelFormat(p_DestinationPixelFormat))
+	{
+		K15_IAClearAtlasBlocks(p_ImageAtlas, p_DestinationPixelFormat, p_DestinationPixelData, 
+			0, p_ImageAtlas->width, p_StartRow, p_EndRow, K15_IA_FALSE);
+	}
+	else if ((p_BakeFlags & KIA_BAKE_CLEAR_ALL) != 0)
+	{
+		K15_IA_MEMSET(p_DestinationPixelData, 0, p_DestinationPixelFormat * (p_EndRow - p_StartRow) * atlasStride);
+	}
+	else
+	{
+		K15_IAClearAtlasFreeSpace(p_ImageAtlas, p_DestinationPixelFormat, p_DestinationPixelData,
+			p_StartRow, p_EndRow, K15_IA_FALSE);
+	}
+}
+/*********************************************************************************/
+//p_DestinationPixelData points to the first pixel of row p_StartRow (true for all functions 
+//working on a range of rows), so bands can be baked into a buffer that only holds the band
+kia_internal void K15_IABakeAtlasRows(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_DestinationPixelFormat,
+	kia_byte* p_DestinationPixelData, kia_u32 p_StartRow, kia_u32 p_EndRow, kia_u32 p_BakeFlags)
+{
+	kia_u32 nodeIndex = 0;
+
+	K15_IAClearAtlasRows(p_ImageAtlas, p_DestinationPixelFormat, p_DestinationPixelData, 
+		p_StartRow, p_EndRow, p_BakeFlags);
+
+	//images might share blocks (the alignment is always a power of two)
+	if (K15_IAIsBlockCompressedPixelFormat(p_DestinationPixelFormat) && 
+		K15_IA_MAX(p_ImageAtlas->alignment, 1) < K15_IA_BLOCK_DIMENSION)
+	{
+		K15_IABakeAtlasBlockRows(p_ImageAtlas, p_DestinationPixelFormat, p_DestinationPixelData, 
+			p_StartRow, p_EndRow);
+		return;
+	}
+
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		if ((p_ImageAtlas->imageNodes[nodeIndex].flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
+
+		K15_IABakeImageNodeRows(p_ImageAtlas, p_ImageAtlas->imageNodes + nodeIndex, 
+			p_DestinationPixelFormat, p_DestinationPixelData, p_StartRow, p_EndRow);
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAExecuteBakeJob(void* p_JobData, kia_u32 p_JobIndex)
+{
+	K15_IABakeJobData* bakeJobData = (K15_IABakeJobData*)p_JobData;
+	kia_u32 atlasHeight = bakeJobData->imageAtlas->height;
+	kia_u32 numJobs = bakeJobData->numJobs;
+
+	//each job bakes a horizontal band of the atlas. Nodes never overlap, so the jobs
+	//don't need to be synchronized
+	kia_u32 startRow = (atlasHeight * p_JobIndex) / numJobs;
+	kia_u32 endRow = (atlasHeight * (p_JobIndex + 1)) / numJobs;
+
+	//blocks can't be shared between jobs
+	if (K15_IAIsBlockCompressedPixelFormat(bakeJobData->destinationPixelFormat))
+	{
+		startRow -= startRow % K15_IA_BLOCK_DIMENSION;
+
+		if (endRow != atlasHeight)
+			endRow -= endRow % K15_IA_BLOCK_DIMENSION;
+	}
+
+	K15_IABakeAtlasRows(bakeJobData->imageAtlas, bakeJobData->destinationPixelFormat,
+		bakeJobData->destinationPixelData + K15_IACalculateRowOffsetInBytes(bakeJobData->imageAtlas, 
+		bakeJobData->destinationPixelFormat, startRow), startRow, endRow, bakeJobData->bakeFlags);
+}
+/*********************************************************************************/
+#ifdef K15_IA_USE_THREADS
+/*********************************************************************************/
+typedef struct _K15_IABakeThreadData
+{
+	K15_IABakeJobFnc jobFnc;
+	void* jobData;
+	kia_u32 jobIndex;
+} K15_IABakeThreadData;
+/*********************************************************************************/
+# ifdef _WIN32
+kia_internal DWORD WINAPI K15_IABakeThreadEntry(LPVOID p_Parameter)
+# else
+kia_internal void* K15_IABakeThreadEntry(void* p_Parameter)
+# endif //_WIN32
+{
+	K15_IABakeThreadData* threadData = (K15_IABakeThreadData*)p_Parameter;
+	threadData->jobFnc(threadData->jobData, threadData->jobIndex);
+
+	return 0;
+}
+/*********************************************************************************/
+kia_internal void K15_IARunBakeJobs(K15_IABakeJobFnc p_JobFnc, void* p_JobData, kia_u32 p_NumJobs,
+	void* p_UserData)
+{
+	K15_IABakeThreadData threadData[K15_IA_MAX_BAKE_JOBS];
+	kia_b8 threadCreated[K15_IA_MAX_BAKE_JOBS];
+	kia_u32 jobIndex = 0;
+
+# ifdef _WIN32
+	HANDLE threads[K15_IA_MAX_BAKE_JOBS];
+# else
+	pthread_t threads[K15_IA_MAX_BAKE_JOBS];
+# endif //_WIN32
+
+	(void)p_UserData;
+
+	//job 0 gets executed on the calling thread
+	for (jobIndex = 1;
+		jobIndex < p_NumJobs;
+		++jobIndex)
+	{
+		threadData[jobIndex].jobFnc = p_JobFnc;
+		threadData[jobIndex].jobData = p_JobData;
+		threadData[jobIndex].jobIndex = jobIndex;
+
+# ifdef _WIN32
+		threads[jobIndex] = CreateThread(0, 0, K15_IABakeThreadEntry, threadData + jobIndex, 0, 0);
+		threadCreated[jobIndex] = threads[jobIndex] != 0;
+# else
+		threadCreated[jobIndex] = pthread_create(threads + jobIndex, 0, K15_IABakeThreadEntry, threadData + jobIndex) == 0;
+# endif //_WIN32
+
+		//do the work ourselves if we couldn't get a thread
+		if (!threadCreated[jobIndex])
+			p_JobFnc(p_JobData, jobIndex);
+	}
+
+	p_JobFnc(p_JobData, 0);
+
+	for (jobIndex = 1;
+		jobIndex < p_NumJobs;
+		++jobIndex)
+	{
+		if (!threadCreated[jobIndex])
+			continue;
+
+# ifdef _WIN32
+		WaitForSingleObject(threads[jobIndex], INFINITE);
+		CloseHandle(threads[jobIndex]);
+# else
+		pthread_join(threads[jobIndex], 0);
+# endif //_WIN32
+	}
+}
+/*********************************************************************************/
+#else
+/*********************************************************************************/
+kia_internal void K15_IARunBakeJobs(K15_IABakeJobFnc p_JobFnc, void* p_JobData, kia_u32 p_NumJobs,
+	void* p_UserData)
+{
+	kia_u32 jobIndex = 0;
+
+	(void)p_UserData;
+
+	//no threads available, run the jobs one after another
+	for (jobIndex = 0;
+		jobIndex < p_NumJobs;
+		++jobIndex)
+	{
+		p_JobFnc(p_JobData, jobIndex);
+	}
+}
+/*********************************************************************************/
+#endif //K15_IA_USE_THREADS
+/*********************************************************************************/
+
+
+
+
+/*********************************************************************************/
+kia_def kia_result K15_IACreateAtlas(K15_ImageAtlas* p_OutTextureAtlas, kia_u32 p_NumImages)
+{
+	kia_u32 memoryBufferSizeInBytes = 0;
+	kia_byte* memoryBuffer = 0;
+	kia_result result;
+
+	if (p_NumImages == 0)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	memoryBufferSizeInBytes = K15_IACalculateAtlasMemorySizeInBytes(p_NumImages);
+	memoryBuffer = (kia_byte*)K15_IA_MALLOC(memoryBufferSizeInBytes);
+
+	if (!memoryBuffer)
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+
+	result = K15_IACreateAtlasWithCustomMemory(p_OutTextureAtlas, p_NumImages, memoryBuffer);
+
+	if (result != K15_IA_RESULT_SUCCESS)
+		K15_IA_FREE(memoryBuffer);
+	else
+		p_OutTextureAtlas->flags &= ~KIA_EXTERNAL_MEMORY_FLAG; //Erase 'KIA_EXTERNAL_MEMORY_FLAG' flag
+
+	return result;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IACreateAtlasWithCustomMemory(K15_ImageAtlas* p_OutImageAtlas, kia_u32 p_NumImages,
+	void* p_MemoryBuffer)
+{
+	K15_ImageAtlas atlas = {0};
+
+	kia_byte* memoryBuffer = (kia_byte*)p_MemoryBuffer;
+
+	kia_u32 memoryBufferSizeInBytes = K15_IACalculateAtlasMemorySizeInBytes(p_NumImages);
+	kia_u32 skylineMemoryBufferOffset = sizeof(K15_IAImageNode) * p_NumImages;
+	kia_u32 wastedSpaceMemoryBufferOffset = skylineMemoryBufferOffset + sizeof(K15_IASkyline) * K15_IA_MAX_SKYLINES;
+	kia_u32 wastedSpaceLinkMemoryBufferOffset = wastedSpaceMemoryBufferOffset + sizeof(K15_IARect) * K15_IA_MAX_WASTED_SPACE_RECTS;
+	kia_u32 wastedSpaceBucketMemoryBufferOffset = wastedSpaceLinkMemoryBufferOffset + sizeof(K15_IARectLink) * K15_IA_MAX_WASTED_SPACE_RECTS;
+	kia_u32 skylineWindowMemoryBufferOffset = wastedSpaceBucketMemoryBufferOffset + sizeof(kia_u32) * K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS;
+
+	if (!p_OutImageAtlas || p_NumImages == 0 || !p_MemoryBuffer)
+	{
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+	}
+
+	//clear memory
+	K15_IA_MEMSET(p_MemoryBuffer, 0, memoryBufferSizeInBytes);
+
+	//mark all buckets as empty
+	K15_IA_MEMSET(memoryBuffer + wastedSpaceBucketMemoryBufferOffset, 0xFF, 
+		sizeof(kia_u32) * K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS);
+
+	atlas.height = K15_IA_DEFAULT_MIN_ATLAS_DIMENSION;
+	atlas.width = K15_IA_DEFAULT_MIN_ATLAS_DIMENSION;
+	atlas.numWastedSpaceRects = 0;
+	atlas.numMaxImageNodes = p_NumImages;
+	atlas.numImageNodes = 0;
+	atlas.numSkylines = 0;
+	atlas.numMaxSkylines = K15_IA_MAX_SKYLINES;
+	atlas.numMaxWastedSpaceRects = K15_IA_MAX_WASTED_SPACE_RECTS;
+	atlas.firstFreeImageNodeIndex = K15_IA_INVALID_INDEX;
+	atlas.firstDirtyImageNodeIndex = K15_IA_INVALID_INDEX;
+	atlas.numGrowRetries = 0;
+	atlas.maxDimension = K15_IA_DIMENSION_THRESHOLD;
+	atlas.imageNodes = (K15_IAImageNode*)(memoryBuffer);
+	atlas.skylines = (K15_IASkyline*)(memoryBuffer + skylineMemoryBufferOffset);
+	atlas.wastedSpaceRects = (K15_IARect*)(memoryBuffer + wastedSpaceMemoryBufferOffset);
+	atlas.wastedSpaceRectLinks = (K15_IARectLink*)(memoryBuffer + wastedSpaceLinkMemoryBufferOffset);
+	atlas.wastedSpaceRectBuckets = (kia_u32*)(memoryBuffer + wastedSpaceBucketMemoryBufferOffset);
+	atlas.skylineWindowIndices = (kia_u32*)(memoryBuffer + skylineWindowMemoryBufferOffset);
+	atlas.flags = KIA_EXTERNAL_MEMORY_FLAG | KIA_FORCE_POWER_OF_TWO_DIMENSION;
+
+	K15_IATryToInsertSkyline(&atlas, 0, 0, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION);
+
+	*p_OutImageAtlas = atlas;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IACreateAtlasWithAllocator(K15_ImageAtlas* p_OutImageAtlas, kia_u32 p_NumImages,
+	K15_IAReallocFnc p_ReallocFnc, K15_IAFreeFnc p_FreeFnc, void* p_UserData)
+{
+	K15_ImageAtlas atlas = {0};
+	void* wastedSpaceRectBuckets = 0;
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	if (!p_OutImageAtlas || !p_ReallocFnc || !p_FreeFnc)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	atlas.height = K15_IA_DEFAULT_MIN_ATLAS_DIMENSION;
+	atlas.width = K15_IA_DEFAULT_MIN_ATLAS_DIMENSION;
+	atlas.flags = KIA_DYNAMIC_MEMORY_FLAG | KIA_FORCE_POWER_OF_TWO_DIMENSION;
+	atlas.maxDimension = K15_IA_DIMENSION_THRESHOLD;
+	atlas.firstFreeImageNodeIndex = K15_IA_INVALID_INDEX;
+	atlas.firstDirtyImageNodeIndex = K15_IA_INVALID_INDEX;
+	atlas.reallocFnc = p_ReallocFnc;
+	atlas.freeFnc = p_FreeFnc;
+	atlas.allocatorUserData = p_UserData;
+
+	result = K15_IAReallocateArray(&atlas, &wastedSpaceRectBuckets, sizeof(kia_u32), 
+		K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS);
+
+	if (result == K15_IA_RESULT_SUCCESS)
+	{
+		atlas.wastedSpaceRectBuckets = (kia_u32*)wastedSpaceRectBuckets;
+
+		//mark all buckets as empty
+		K15_IA_MEMSET(wastedSpaceRectBuckets, 0xFF, sizeof(kia_u32) * K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS);
+
+		//the arrays grow on demand, but start with a reasonable size
+		result = K15_IAReserveImageNodes(&atlas, K15_IA_MAX(p_NumImages, 1));
+	}
+
+	if (result == K15_IA_RESULT_SUCCESS)
+		result = K15_IAReserveSkylines(&atlas, 32);
+
+	if (result == K15_IA_RESULT_SUCCESS)
+		result = K15_IAReserveWastedSpaceRects(&atlas, 64);
+
+	if (result == K15_IA_RESULT_SUCCESS)
+		result = K15_IATryToInsertSkyline(&atlas, 0, 0, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION);
+
+	if (result != K15_IA_RESULT_SUCCESS)
+	{
+		K15_IAFreeAtlas(&atlas);
+		return K15_IA_RESULT_OUT_OF_MEMORY;
+	}
+
+	*p_OutImageAtlas = atlas;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasSizeHint(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ExpectedTotalArea,
+	kia_u32 p_MaxImageWidth, kia_u32 p_MaxImageHeight)
+{
+	if (!p_ImageAtlas)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	return K15_IATryToGrowAtlasSizeToFit(p_ImageAtlas, p_MaxImageWidth, p_MaxImageHeight,
+		p_ExpectedTotalArea);
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasGrowStep(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_GrowStep)
+{
+	if (!p_ImageAtlas || p_GrowStep > K15_IA_DIMENSION_THRESHOLD)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	p_ImageAtlas->growStep = p_GrowStep;
+
+	if (p_GrowStep == 0)
+		p_ImageAtlas->flags |= KIA_FORCE_POWER_OF_TWO_DIMENSION;
+	else
+		p_ImageAtlas->flags &= ~KIA_FORCE_POWER_OF_TWO_DIMENSION;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasMaxDimension(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_MaxDimension)
+{
+	if (!p_ImageAtlas || p_MaxDimension > K15_IA_DIMENSION_THRESHOLD)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (p_ImageAtlas->width > p_MaxDimension || p_ImageAtlas->height > p_MaxDimension)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	p_ImageAtlas->maxDimension = p_MaxDimension;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasImageRotation(K15_ImageAtlas* p_ImageAtlas, kia_b8 p_AllowRotation)
+{
+	if (!p_ImageAtlas)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (p_AllowRotation)
+		p_ImageAtlas->flags |= KIA_ALLOW_IMAGE_ROTATION;
+	else
+		p_ImageAtlas->flags &= ~KIA_ALLOW_IMAGE_ROTATION;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasMinimalFit(K15_ImageAtlas* p_ImageAtlas, kia_b8 p_FitMinimal)
+{
+	if (!p_ImageAtlas)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (p_FitMinimal)
+		p_ImageAtlas->flags |= KIA_FIT_MINIMAL_DIMENSION;
+	else
+		p_ImageAtlas->flags &= ~KIA_FIT_MINIMAL_DIMENSION;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasPadding(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Padding)
+{
+	if (!p_ImageAtlas || p_Padding > 0xFF)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	p_ImageAtlas->padding = (kia_u8)p_Padding;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasAlignment(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_Alignment)
+{
+	kia_u32 width = 0;
+	kia_u32 height = 0;
+
+	if (!p_ImageAtlas || p_Alignment == 0 || p_Alignment > 128 || (p_Alignment & (p_Alignment - 1)) != 0)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	//images that have already been placed might not be aligned
+	if (p_ImageAtlas->numImageNodes > 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	p_ImageAtlas->alignment = (kia_u8)p_Alignment;
+
+	//the atlas dimension is where new skylines start once the atlas grows
+	width = K15_IAAlignDimension(p_ImageAtlas, p_ImageAtlas->width);
+	height = K15_IAAlignDimension(p_ImageAtlas, p_ImageAtlas->height);
+
+	if (width != p_ImageAtlas->width || height != p_ImageAtlas->height)
+		return K15_IAResizeAtlas(p_ImageAtlas, width, height);
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasPacker(K15_ImageAtlas* p_ImageAtlas, K15_IAPacker p_Packer)
+{
+	if (!p_ImageAtlas || (kia_u32)p_Packer > KIA_PACKER_SHELF)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	//the free space of the placed images is tracked differently by each packer
+	if (p_ImageAtlas->numImageNodes > 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	p_ImageAtlas->packer = p_Packer;
+	K15_IAResetAtlasPacking(p_ImageAtlas, p_ImageAtlas->width, p_ImageAtlas->height);
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetAtlasSkylineHeuristic(K15_ImageAtlas* p_ImageAtlas, K15_IASkylineHeuristic p_Heuristic)
+{
+	if (!p_ImageAtlas || (kia_u32)p_Heuristic > KIA_SKYLINE_MIN_WASTED_AREA_AND_HEIGHT)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	p_ImageAtlas->skylineHeuristic = p_Heuristic;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAShrinkAtlasToFit(K15_ImageAtlas* p_ImageAtlas)
+{
+	kia_u32 nodeIndex = 0;
+	kia_u32 rectIndex = 0;
+	kia_u32 width = 0;
+	kia_u32 height = 0;
+	kia_u32 skylineEnd = 0;
+	kia_b8 clippedRect = 0;
+
+	K15_IAImageNode* imageNode = 0;
+	K15_IASkyline* skyline = 0;
+	K15_IARect rect;
+
+	if (!p_ImageAtlas)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
+
+		width = K15_IA_MAX(width, (kia_u32)(imageNode->rect.posX + imageNode->rect.width));
+		height = K15_IA_MAX(height, (kia_u32)(imageNode->rect.posY + imageNode->rect.height));
+	}
+
+	//no images, nothing to fit
+	if (width == 0 || height == 0)
+		return K15_IA_RESULT_SUCCESS;
+
+	width = K15_IA_MIN(K15_IACalculateGrownDimension(p_ImageAtlas, 1, width), p_ImageAtlas->width);
+	height = K15_IA_MIN(K15_IACalculateGrownDimension(p_ImageAtlas, 1, height), p_ImageAtlas->height);
+
+	//cut off all skylines that are outside of the new width
+	while (p_ImageAtlas->numSkylines > 0)
+	{
+		skyline = p_ImageAtlas->skylines + p_ImageAtlas->numSkylines - 1;
+		skylineEnd = skyline->baseLinePosX + skyline->baseLineWidth;
+
+		if (skyline->baseLinePosX >= width)
+		{
+			--p_ImageAtlas->numSkylines;
+			continue;
+		}
+
+		if (skylineEnd > width)
+			skyline->baseLineWidth = width - skyline->baseLinePosX;
+
+		break;
+	}
+
+	//clip all wasted space rects (repeat, because re-adding a clipped rect might merge it)
+	do
+	{
+		clippedRect = 0;
+
+		for (rectIndex = 0;
+			rectIndex < p_ImageAtlas->numWastedSpaceRects;
+			++rectIndex)
+		{
+			rect = p_ImageAtlas->wastedSpaceRects[rectIndex];
+
+			if (rect.posX + rect.width <= width && rect.posY + rect.height <= height)
+				continue;
+
+			K15_IARemoveWastedSpaceRectByIndex(p_ImageAtlas, rectIndex);
+
+			if (rect.posX < width && rect.posY < height)
+			{
+				K15_IAAddWastedSpaceRect(p_ImageAtlas, rect.posX, rect.posY, 
+					K15_IA_MIN(rect.width, width - rect.posX), K15_IA_MIN(rect.height, height - rect.posY));
+			}
+
+			clippedRect = 1;
+			break;
+		}
+	} while (clippedRect);
+
+	p_ImageAtlas->width = width;
+	p_ImageAtlas->height = height;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_u32 K15_IACalculateAtlasMemorySizeInBytes(kia_u32 p_NumImages)
+{
+	kia_u32 imageNodeDataSizeInBytes = p_NumImages * sizeof(K15_IAImageNode);
+	kia_u32 skylineDataSizeInBytes = K15_IA_MAX_SKYLINES * sizeof(K15_IASkyline);
+	kia_u32 wastedSpaceRectsSizeInBytes = K15_IA_MAX_WASTED_SPACE_RECTS * sizeof(K15_IARect);
+	kia_u32 wastedSpaceLinksSizeInBytes = K15_IA_MAX_WASTED_SPACE_RECTS * sizeof(K15_IARectLink);
+	kia_u32 wastedSpaceBucketsSizeInBytes = K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS * sizeof(kia_u32);
+	kia_u32 skylineWindowSizeInBytes = K15_IA_MAX_SKYLINES * sizeof(kia_u32);
+
+	return imageNodeDataSizeInBytes + skylineDataSizeInBytes + wastedSpaceRectsSizeInBytes +
+		wastedSpaceLinksSizeInBytes + wastedSpaceBucketsSizeInBytes + skylineWindowSizeInBytes;
+}
+/*********************************************************************************/
+kia_def kia_u32 K15_IACalculateAtlasPixelDataSizeInBytes(K15_ImageAtlas* p_ImageAtlas,
+	K15_IAPixelFormat p_PixelFormat)
+{
+	return K15_IACalculatePixelDataSizeInBytes(p_ImageAtlas->width, p_ImageAtlas->height, p_PixelFormat);
+}
+/*********************************************************************************/
+kia_def void K15_IAFreeAtlas(K15_ImageAtlas* p_ImageAtlas)
+{
+	if (!p_ImageAtlas)
+		return;
+
+	if ((p_ImageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) != 0)
+	{
+		//every array has been allocated individually
+		void* userData = p_ImageAtlas->allocatorUserData;
+
+		if (p_ImageAtlas->imageNodes)
+			p_ImageAtlas->freeFnc(p_ImageAtlas->imageNodes, userData);
+
+		if (p_ImageAtlas->skylines)
+			p_ImageAtlas->freeFnc(p_ImageAtlas->skylines, userData);
+
+		if (p_ImageAtlas->skylineWindowIndices)
+			p_ImageAtlas->freeFnc(p_ImageAtlas->skylineWindowIndices, userData);
+
+		if (p_ImageAtlas->wastedSpaceRects)
+			p_ImageAtlas->freeFnc(p_ImageAtlas->wastedSpaceRects, userData);
+
+		if (p_ImageAtlas->wastedSpaceRectLinks)
+			p_ImageAtlas->freeFnc(p_ImageAtlas->wastedSpaceRectLinks, userData);
+
+		if (p_ImageAtlas->wastedSpaceRectBuckets)
+			p_ImageAtlas->freeFnc(p_ImageAtlas->wastedSpaceRectBuckets, userData);
+	}
+	else if ((p_ImageAtlas->flags & KIA_EXTERNAL_MEMORY_FLAG) == 0)
+	{
+		K15_IA_FREE(p_ImageAtlas->imageNodes); //points to the start of the memory buffer
+	}
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAAddImageToAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
+	void* p_PixelData, kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight,
+	int* p_OutX, int* p_OutY)
+{
+	return K15_IAAddImageToAtlasWithHandle(p_ImageAtlas, p_PixelFormat, p_PixelData, p_PixelDataWidth,
+		p_PixelDataHeight, p_OutX, p_OutY, 0);
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAAddImageToAtlasWithHandle(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
+	void* p_PixelData, kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight,
+	int* p_OutX, int* p_OutY, kia_u32* p_OutHandle)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	kia_u32 imageNodeIndex = 0;
+	kia_b8 reuseRemovedImageNode = K15_IA_FALSE;
+	K15_IAImageNode* imageNode = 0;
+
+	if (!p_ImageAtlas || !p_PixelData || p_PixelDataWidth == 0 || p_PixelDataHeight == 0 ||
+		!p_OutX || !p_OutY || K15_IAIsBlockCompressedPixelFormat(p_PixelFormat))
+	{
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+	}
+
+	//reuse the slot of a removed image. The area of the removed image is tracked separately
+	//(see K15_IAAddPendingClearRect), so every removed slot can be reused right away
+	imageNodeIndex = p_ImageAtlas->firstFreeImageNodeIndex;
+	reuseRemovedImageNode = imageNodeIndex != K15_IA_INVALID_INDEX;
+
+	if (!reuseRemovedImageNode)
+	{
+		result = K15_IAReserveImageNodes(p_ImageAtlas, p_ImageAtlas->numImageNodes + 1);
+
+		if (result != K15_IA_RESULT_SUCCESS)
+			return result;
+
+		imageNodeIndex = p_ImageAtlas->numImageNodes;
+	}
+
+	imageNode = p_ImageAtlas->imageNodes + imageNodeIndex;
+
+	if (reuseRemovedImageNode)
+	{
+		//the removed node is kept intact until the new image has been placed
+		K15_IAImageNode removedImageNode = *imageNode;
+		
+		imageNode->pixelData = (kia_byte*)p_PixelData;
+		imageNode->pixelDataFormat = p_PixelFormat;
+		imageNode->batchIndex = 0;
+
+		//a removed image that has never been baked is still part of the dirty list
+		imageNode->flags &= KIA_IMAGE_NODE_DIRTY;
+		K15_IASetImageNodeDimension(p_ImageAtlas, imageNode, p_PixelDataWidth, p_PixelDataHeight);
+		result = K15_IAInsertImageNode(p_ImageAtlas, imageNode, p_OutX, p_OutY);
+
+		if (result == K15_IA_RESULT_SUCCESS)
+		{
+			p_ImageAtlas->firstFreeImageNodeIndex = removedImageNode.nextFreeIndex;
+			--p_ImageAtlas->numRemovedImageNodes;
+		}
+		else
+		{
+			*imageNode = removedImageNode;
+		}
+	}
+	else
+	{
+		imageNode->pixelData = (kia_byte*)p_PixelData;
+		imageNode->pixelDataFormat = p_PixelFormat;
+		imageNode->batchIndex = 0;
+		imageNode->flags = 0;
+		K15_IASetImageNodeDimension(p_ImageAtlas, imageNode, p_PixelDataWidth, p_PixelDataHeight);
+		result = K15_IAInsertImageNode(p_ImageAtlas, imageNode, p_OutX, p_OutY);
+
+		if (result == K15_IA_RESULT_SUCCESS)
+			++p_ImageAtlas->numImageNodes;
+	}
+
+	if (result == K15_IA_RESULT_SUCCESS)
+	{
+		K15_IAMarkImageNodeAsDirty(p_ImageAtlas, imageNodeIndex);
+
+		if (p_OutHandle)
+			*p_OutHandle = imageNodeIndex;
+	}
+
+	return result;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IARemoveImageFromAtlas(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle)
+{
+	K15_IAImageNode* imageNode = 0;
+
+	if (!p_ImageAtlas)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (p_ImageHandle >= p_ImageAtlas->numImageNodes)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	imageNode = p_ImageAtlas->imageNodes + p_ImageHandle;
+
+	if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	//the area of the image can be used by new images
+	K15_IAAddWastedSpaceRect(p_ImageAtlas, imageNode->rect.posX, imageNode->rect.posY,
+		imageNode->rect.width, imageNode->rect.height);
+
+	imageNode->flags |= KIA_IMAGE_NODE_REMOVED;
+	imageNode->pixelData = 0;
+	imageNode->nextFreeIndex = p_ImageAtlas->firstFreeImageNodeIndex;
+	p_ImageAtlas->firstFreeImageNodeIndex = p_ImageHandle;
+	++p_ImageAtlas->numRemovedImageNodes;
+
+	//the area has to be cleared by the next incremental bake (only relevant if the
+	//atlas has been baked before)
+	if (p_ImageAtlas->bakedWidth != 0)
+		K15_IAAddPendingClearRect(p_ImageAtlas, &imageNode->rect);
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAGetImageRotation(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle, 
+	kia_b8* p_OutRotated)
+{
+	K15_IAImageNode* imageNode = 0;
+
+	if (!p_ImageAtlas || !p_OutRotated)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (p_ImageHandle >= p_ImageAtlas->numImageNodes)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	imageNode = p_ImageAtlas->imageNodes + p_ImageHandle;
+
+	if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	*p_OutRotated = (imageNode->flags & KIA_IMAGE_NODE_ROTATED) != 0;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAGetImagePosition(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle, 
+	int* p_OutX, int* p_OutY)
+{
+	K15_IAImageNode* imageNode = 0;
+
+	if (!p_ImageAtlas || !p_OutX || !p_OutY)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (p_ImageHandle >= p_ImageAtlas->numImageNodes)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	imageNode = p_ImageAtlas->imageNodes + p_ImageHandle;
+
+	if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	//the rect includes the padding
+	*p_OutX = imageNode->rect.posX + imageNode->padding;
+	*p_OutY = imageNode->rect.posY + imageNode->padding;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetImagePixelData(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_ImageHandle,
+	K15_IAPixelFormat p_PixelFormat, void* p_PixelData)
+{
+	K15_IAImageNode* imageNode = 0;
+
+	if (!p_ImageAtlas || !p_PixelData || K15_IAIsBlockCompressedPixelFormat(p_PixelFormat))
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (p_ImageHandle >= p_ImageAtlas->numImageNodes)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	imageNode = p_ImageAtlas->imageNodes + p_ImageHandle;
+
+	if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	imageNode->pixelData = (kia_byte*)p_PixelData;
+	imageNode->pixelDataFormat = p_PixelFormat;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IAPlaceImageNodesFromScratch(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_MaxWidth,
+	kia_u32 p_MaxHeight)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+	kia_u32 numImageNodes = p_ImageAtlas->numImageNodes;
+	kia_u32 nodeIndex = 0;
+	kia_u8 atlasFlags = p_ImageAtlas->flags;
+	int posX = 0;
+	int posY = 0;
+
+	K15_IAImageNode* imageNode = 0;
+
+	//images keep their orientation, otherwise the pixels couldn't simply be copied
+	p_ImageAtlas->flags &= ~KIA_ALLOW_IMAGE_ROTATION;
+
+	//start from scratch and grow the atlas up front like K15_IAAddImagesToAtlas does
+	K15_IAResetAtlasPacking(p_ImageAtlas, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION);
+	result = K15_IATryToGrowAtlasSizeToFit(p_ImageAtlas, p_MaxWidth, p_MaxHeight, 
+		K15_IACalculateUsedAtlasArea(p_ImageAtlas));
+
+	//like in K15_IAAddImagesToAtlas only the images that have already been placed are part 
+	//of the atlas while the next image gets placed (see K15_IACalculateContactPerimeter)
+	for (nodeIndex = 0;
+		nodeIndex < numImageNodes && result == K15_IA_RESULT_SUCCESS;
+		++nodeIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
+		p_ImageAtlas->numImageNodes = nodeIndex;
+
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) == 0)
+			result = K15_IAInsertImageNode(p_ImageAtlas, imageNode, &posX, &posY);
+	}
+
+	p_ImageAtlas->numImageNodes = numImageNodes;
+	p_ImageAtlas->flags = atlasFlags;
+
+	return result;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IARepackAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IASortKey p_SortKey, 
+	K15_IARelocation* p_OutRelocations, kia_u32 p_MaxRelocations, kia_u32* p_OutNumRelocations)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	kia_u32 nodeIndex = 0;
+	kia_u32 targetNodeIndex = 0;
+	kia_u32 numImageNodes = 0;
+	kia_u32 numRelocations = 0;
+	kia_u32 oldWidth = 0;
+	kia_u32 oldHeight = 0;
+	kia_u32 maxWidth = 0;
+	kia_u32 maxHeight = 0;
+
+	K15_IAImageNode* imageNodes = 0;
+	K15_IAImageNode* imageNode = 0;
+	K15_IAImageNode swapImageNode;
+	K15_IARelocation* relocation = 0;
+
+	if (!p_ImageAtlas || !p_OutRelocations || !p_OutNumRelocations)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	*p_OutNumRelocations = 0;
+	numImageNodes = p_ImageAtlas->numImageNodes;
+	imageNodes = p_ImageAtlas->imageNodes;
+
+	if (p_MaxRelocations < numImageNodes - p_ImageAtlas->numRemovedImageNodes)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	//remember the old positions. The batch index is used to restore the order of the
+	//image nodes after sorting them (the handles have to stay the same).
+	for (nodeIndex = 0;
+		nodeIndex < numImageNodes;
+		++nodeIndex)
+	{
+		imageNode = imageNodes + nodeIndex;
+		imageNode->batchIndex = nodeIndex;
+
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
+
+		relocation = p_OutRelocations + numRelocations++;
+		relocation->imageHandle = nodeIndex;
+		relocation->oldPosX = imageNode->rect.posX;
+		relocation->oldPosY = imageNode->rect.posY;
+		relocation->width = imageNode->rect.width;
+		relocation->height = imageNode->rect.height;
+
+		maxWidth = K15_IA_MAX(maxWidth, (kia_u32)imageNode->rect.width);
+		maxHeight = K15_IA_MAX(maxHeight, (kia_u32)imageNode->rect.height);
+	}
+
+	oldWidth = p_ImageAtlas->width;
+	oldHeight = p_ImageAtlas->height;
+
+	K15_IASortImageNodes(imageNodes, numImageNodes, p_SortKey);
+	result = K15_IAPlaceImageNodesFromScratch(p_ImageAtlas, maxWidth, maxHeight);
+
+	//restore the original order of the image nodes
+	for (nodeIndex = 0;
+		nodeIndex < numImageNodes;
+		++nodeIndex)
+	{
+		while (imageNodes[nodeIndex].batchIndex != nodeIndex)
+		{
+			targetNodeIndex = imageNodes[nodeIndex].batchIndex;
+			swapImageNode = imageNodes[targetNodeIndex];
+			imageNodes[targetNodeIndex] = imageNodes[nodeIndex];
+			imageNodes[nodeIndex] = swapImageNode;
+		}
+	}
+
+	if (result != K15_IA_RESULT_SUCCESS || 
+		p_ImageAtlas->width * p_ImageAtlas->height > oldWidth * oldHeight)
+	{
+		//repacking made things worse, move everything back
+		for (nodeIndex = 0;
+			nodeIndex < numRelocations;
+			++nodeIndex)
+		{
+			relocation = p_OutRelocations + nodeIndex;
+			imageNode = imageNodes + relocation->imageHandle;
+			imageNode->rect.posX = relocation->oldPosX;
+			imageNode->rect.posY = relocation->oldPosY;
+		}
+
+		p_ImageAtlas->width = oldWidth;
+		p_ImageAtlas->height = oldHeight;
+		K15_IARebuildFreeSpaceFromImageNodes(p_ImageAtlas);
+
+		return K15_IA_RESULT_ATLAS_TOO_LARGE;
+	}
+
+	for (nodeIndex = 0;
+		nodeIndex < numRelocations;
+		++nodeIndex)
+	{
+		relocation = p_OutRelocations + nodeIndex;
+		imageNode = imageNodes + relocation->imageHandle;
+		relocation->newPosX = imageNode->rect.posX;
+		relocation->newPosY = imageNode->rect.posY;
+	}
+
+	//every image might have moved
+	K15_IAClearDirtyImageNodes(p_ImageAtlas);
+	p_ImageAtlas->bakedWidth = 0;
+	p_ImageAtlas->bakedHeight = 0;
+
+	*p_OutNumRelocations = numRelocations;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAGetMilliseconds(void)
+{
+#if defined(K15_IA_GET_MILLISECONDS)
+	return (kia_u32)K15_IA_GET_MILLISECONDS();
+#elif defined(_WIN32) && defined(K15_IA_USE_THREADS)
+	return (kia_u32)GetTickCount();
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec currentTime;
+	clock_gettime(CLOCK_MONOTONIC, &currentTime);
+
+	return (kia_u32)(currentTime.tv_sec * 1000 + currentTime.tv_nsec / 1000000);
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && defined(TIME_UTC)
+	//CLOCK_MONOTONIC is only defined with POSIX feature macros (e.g. not for -std=c11 on glibc)
+	struct timespec currentTime;
+	timespec_get(&currentTime, TIME_UTC);
+
+	return (kia_u32)(currentTime.tv_sec * 1000 + currentTime.tv_nsec / 1000000);
+#else
+	//wall clock time with MSVC, but processor time of all threads with most other C libraries 
+	//(see K15_IAOptimizeAtlas)
+	return (kia_u32)((double)clock() * 1000.0 / CLOCKS_PER_SEC);
+#endif
+}
+/*********************************************************************************/
+kia_internal void K15_IAGetOptimizeTrialPacker(kia_u32 p_TrialIndex, K15_IAPacker* p_OutPacker,
+	K15_IASkylineHeuristic* p_OutSkylineHeuristic)
+{
+	*p_OutPacker = KIA_PACKER_SKYLINE;
+	*p_OutSkylineHeuristic = KIA_SKYLINE_BEST_WIDTH_FIT;
+
+	//the most promising packers come first, in case the time budget runs out early. 
+	//Contact point and shelf packing are left out (too slow and not dense enough).
+	switch (p_TrialIndex % K15_IA_NUM_OPTIMIZE_PACKERS)
+	{
+		case 1:
+			*p_OutPacker = KIA_PACKER_MAX_RECTS_BEST_SHORT_SIDE_FIT;
+			break;
+
+		case 2:
+			*p_OutSkylineHeuristic = KIA_SKYLINE_BOTTOM_LEFT;
+			break;
+
+		case 3:
+			*p_OutPacker = KIA_PACKER_MAX_RECTS_BEST_AREA_FIT;
+			break;
+
+		case 4:
+			*p_OutPacker = KIA_PACKER_GUILLOTINE;
+			break;
+
+		case 5:
+			*p_OutSkylineHeuristic = KIA_SKYLINE_MIN_WASTED_AREA_AND_HEIGHT;
+			break;
+
+		case 6:
+			*p_OutSkylineHeuristic = KIA_SKYLINE_MIN_WASTED_AREA;
+			break;
+	}
+}
+/*********************************************************************************/
+kia_internal void K15_IAPerturbImageNodes(K15_IAImageNode* p_ImageNodes, kia_u32 p_NumImageNodes,
+	kia_u32 p_Seed)
+{
+	kia_u32 random = p_Seed;
+	kia_u32 swapIndex = 0;
+	kia_u32 numSwaps = p_NumImageNodes / 4 + 1;
+	K15_IAImageNode swapImageNode;
+
+	if (p_NumImageNodes < 2)
+		return;
+
+	//swapping neighbours keeps the order mostly sorted, a complete shuffle packs a lot worse
+	while (numSwaps-- > 0)
+	{
+		random = random * 1103515245u + 12345u;
+		swapIndex = (random >> 8) % (p_NumImageNodes - 1);
+
+		swapImageNode = p_ImageNodes[swapIndex];
+		p_ImageNodes[swapIndex] = p_ImageNodes[swapIndex + 1];
+		p_ImageNodes[swapIndex + 1] = swapImageNode;
+	}
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IACreateScratchAtlas(K15_ImageAtlas* p_ImageAtlas, K15_ImageAtlas* p_OutScratchAtlas,
+	kia_u32 p_NumImages)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	if ((p_ImageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) != 0)
+	{
+		result = K15_IACreateAtlasWithAllocator(p_OutScratchAtlas, p_NumImages, p_ImageAtlas->reallocFnc,
+			p_ImageAtlas->freeFnc, p_ImageAtlas->allocatorUserData);
+	}
+	else
+	{
+		result = K15_IACreateAtlas(p_OutScratchAtlas, p_NumImages);
+	}
+
+	if (result != K15_IA_RESULT_SUCCESS)
+		return result;
+
+	//the scratch atlas has to grow exactly like the atlas itself
+	p_OutScratchAtlas->flags &= ~KIA_FORCE_POWER_OF_TWO_DIMENSION;
+	p_OutScratchAtlas->flags |= p_ImageAtlas->flags & KIA_FORCE_POWER_OF_TWO_DIMENSION;
+	p_OutScratchAtlas->growStep = p_ImageAtlas->growStep;
+	p_OutScratchAtlas->maxDimension = p_ImageAtlas->maxDimension;
+	p_OutScratchAtlas->alignment = p_ImageAtlas->alignment;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal kia_result K15_IARunOptimizeTrial(K15_ImageAtlas* p_ImageAtlas, K15_ImageAtlas* p_TrialAtlas,
+	kia_u32 p_TrialIndex)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+	kia_u32 orderIndex = p_TrialIndex / K15_IA_NUM_OPTIMIZE_PACKERS;
+	kia_u32 nodeIndex = 0;
+	kia_u32 numImageNodes = 0;
+	kia_u32 maxWidth = 0;
+	kia_u32 maxHeight = 0;
+
+	K15_IAImageNode* imageNode = 0;
+
+	//only the images that haven't been removed are part of the trial. The batch index
+	//remembers the handle of each image.
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		if ((p_ImageAtlas->imageNodes[nodeIndex].flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
+
+		imageNode = p_TrialAtlas->imageNodes + numImageNodes++;
+		*imageNode = p_ImageAtlas->imageNodes[nodeIndex];
+		imageNode->batchIndex = nodeIndex;
+
+		maxWidth = K15_IA_MAX(maxWidth, (kia_u32)imageNode->rect.width);
+		maxHeight = K15_IA_MAX(maxHeight, (kia_u32)imageNode->rect.height);
+	}
+
+	p_TrialAtlas->numImageNodes = numImageNodes;
+	K15_IAGetOptimizeTrialPacker(p_TrialIndex, &p_TrialAtlas->packer, &p_TrialAtlas->skylineHeuristic);
+
+	//every sort key gets tried once before the orders get perturbed
+	K15_IASortImageNodes(p_TrialAtlas->imageNodes, numImageNodes, 
+		(K15_IASortKey)(orderIndex % (KIA_SORT_BY_PERIMETER + 1)));
+
+	if (orderIndex > KIA_SORT_BY_PERIMETER)
+		K15_IAPerturbImageNodes(p_TrialAtlas->imageNodes, numImageNodes, p_TrialIndex);
+
+	result = K15_IAPlaceImageNodesFromScratch(p_TrialAtlas, maxWidth, maxHeight);
+
+	if (result == K15_IA_RESULT_SUCCESS)
+		result = K15_IAShrinkAtlasToFit(p_TrialAtlas);
+
+	return result;
+}
+/*********************************************************************************/
+kia_internal void K15_IAOptimizeJob(void* p_JobData, kia_u32 p_JobIndex)
+{
+	K15_IAOptimizeJobData* optimizeJobData = (K15_IAOptimizeJobData*)p_JobData;
+	K15_ImageAtlas* trialAtlas = optimizeJobData->scratchAtlases + p_JobIndex * 2;
+	K15_ImageAtlas* bestAtlas = trialAtlas + 1;
+	K15_ImageAtlas swapAtlas;
+	kia_u32 trialIndex = 0;
+
+	for (trialIndex = p_JobIndex;
+		trialIndex < optimizeJobData->numTrials;
+		trialIndex += optimizeJobData->numJobs)
+	{
+		//the first trial always runs, so there's at least one result
+		if (trialIndex > 0 && optimizeJobData->timeBudgetInMilliseconds > 0 &&
+			K15_IAGetMilliseconds() - optimizeJobData->startTimeInMilliseconds >= 
+			optimizeJobData->timeBudgetInMilliseconds)
+		{
+			break;
+		}
+
+		if (K15_IARunOptimizeTrial(optimizeJobData->imageAtlas, trialAtlas, trialIndex) != K15_IA_RESULT_SUCCESS)
+			continue;
+
+		//the best atlas doesn't contain any images until the first trial succeeded
+		if (bestAtlas->numImageNodes == 0 || 
+			trialAtlas->width * trialAtlas->height < bestAtlas->width * bestAtlas->height)
+		{
+			swapAtlas = *bestAtlas;
+			*bestAtlas = *trialAtlas;
+			*trialAtlas = swapAtlas;
+		}
+	}
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAOptimizeAtlas(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumTrials, 
+	kia_u32 p_TimeBudgetInMilliseconds, kia_u32 p_NumJobs, K15_IARunBakeJobsFnc p_RunJobsFnc, 
+	void* p_UserData, K15_IARelocation* p_OutRelocations, kia_u32 p_MaxRelocations, 
+	kia_u32* p_OutNumRelocations)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	kia_u32 numImages = 0;
+	kia_u32 numJobs = 0;
+	kia_u32 numScratchAtlases = 0;
+	kia_u32 scratchAtlasIndex = 0;
+	kia_u32 jobIndex = 0;
+	kia_u32 nodeIndex = 0;
+
+	K15_ImageAtlas scratchAtlases[K15_IA_MAX_BAKE_JOBS * 2];
+	K15_ImageAtlas* bestAtlas = 0;
+	K15_ImageAtlas* jobAtlas = 0;
+	K15_IAImageNode* trialImageNode = 0;
+	K15_IAImageNode* imageNode = 0;
+	K15_IARelocation* relocation = 0;
+	K15_IAOptimizeJobData optimizeJobData;
+
+	if (!p_ImageAtlas || !p_OutRelocations || !p_OutNumRelocations || p_NumTrials == 0 ||
+		p_NumJobs == 0 || p_NumJobs > K15_IA_MAX_BAKE_JOBS)
+	{
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+	}
+
+	*p_OutNumRelocations = 0;
+	numImages = p_ImageAtlas->numImageNodes - p_ImageAtlas->numRemovedImageNodes;
+
+	if (p_MaxRelocations < numImages)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	//nothing to pack
+	if (numImages == 0)
+		return K15_IA_RESULT_SUCCESS;
+
+	numJobs = K15_IA_MIN(p_NumJobs, p_NumTrials);
+
+	for (scratchAtlasIndex = 0;
+		scratchAtlasIndex < numJobs * 2 && result == K15_IA_RESULT_SUCCESS;
+		++scratchAtlasIndex)
+	{
+		result = K15_IACreateScratchAtlas(p_ImageAtlas, scratchAtlases + scratchAtlasIndex, numImages);
+
+		if (result == K15_IA_RESULT_SUCCESS)
+			++numScratchAtlases;
+	}
+
+	if (result == K15_IA_RESULT_SUCCESS)
+	{
+		optimizeJobData.imageAtlas = p_ImageAtlas;
+		optimizeJobData.scratchAtlases = scratchAtlases;
+		optimizeJobData.numTrials = p_NumTrials;
+		optimizeJobData.numJobs = numJobs;
+		optimizeJobData.timeBudgetInMilliseconds = p_TimeBudgetInMilliseconds;
+		optimizeJobData.startTimeInMilliseconds = K15_IAGetMilliseconds();
+
+		if (p_RunJobsFnc)
+			p_RunJobsFnc(K15_IAOptimizeJob, &optimizeJobData, numJobs, p_UserData);
+		else
+			K15_IARunBakeJobs(K15_IAOptimizeJob, &optimizeJobData, numJobs, p_UserData);
+
+		//pick the smallest result of all jobs
+		for (jobIndex = 0;
+			jobIndex < numJobs;
+			++jobIndex)
+		{
+			jobAtlas = scratchAtlases + jobIndex * 2 + 1;
+
+			if (jobAtlas->numImageNodes > 0 && (!bestAtlas || 
+				jobAtlas->width * jobAtlas->height < bestAtlas->width * bestAtlas->height))
+			{
+				bestAtlas = jobAtlas;
+			}
+		}
+
+		if (!bestAtlas || bestAtlas->width * bestAtlas->height >= p_ImageAtlas->width * p_ImageAtlas->height)
+			result = K15_IA_RESULT_ATLAS_TOO_LARGE;
+	}
+
+	if (result == K15_IA_RESULT_SUCCESS)
+	{
+		for (nodeIndex = 0;
+			nodeIndex < bestAtlas->numImageNodes;
+			++nodeIndex)
+		{
+			trialImageNode = bestAtlas->imageNodes + nodeIndex;
+			imageNode = p_ImageAtlas->imageNodes + trialImageNode->batchIndex;
+
+			relocation = p_OutRelocations + nodeIndex;
+			relocation->imageHandle = trialImageNode->batchIndex;
+			relocation->oldPosX = imageNode->rect.posX;
+			relocation->oldPosY = imageNode->rect.posY;
+			relocation->newPosX = trialImageNode->rect.posX;
+			relocation->newPosY = trialImageNode->rect.posY;
+			relocation->width = imageNode->rect.width;
+			relocation->height = imageNode->rect.height;
+
+			imageNode->rect.posX = trialImageNode->rect.posX;
+			imageNode->rect.posY = trialImageNode->rect.posY;
+		}
+
+		//the free space is rebuilt for the packer of the atlas itself
+		p_ImageAtlas->width = bestAtlas->width;
+		p_ImageAtlas->height = bestAtlas->height;
+		K15_IARebuildFreeSpaceFromImageNodes(p_ImageAtlas);
+
+		//every image might have moved
+		K15_IAClearDirtyImageNodes(p_ImageAtlas);
+		p_ImageAtlas->bakedWidth = 0;
+		p_ImageAtlas->bakedHeight = 0;
+
+		*p_OutNumRelocations = bestAtlas->numImageNodes;
+	}
+
+	for (scratchAtlasIndex = 0;
+		scratchAtlasIndex < numScratchAtlases;
+		++scratchAtlasIndex)
+	{
+		K15_IAFreeAtlas(scratchAtlases + scratchAtlasIndex);
+	}
+
+	return result;
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IATryToPlaceImageNodes(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNodes, 
+	kia_u32 p_NumImageNodes, kia_b8 p_AllowGrowing)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+	kia_u32 numImageNodes = p_ImageAtlas->numImageNodes;
+	kia_u32 nodeIndex = 0;
+	int posX = 0;
+	int posY = 0;
+
+	K15_IAImageNode* imageNode = 0;
+
+	//the image nodes directly follow the image nodes of the atlas (see K15_IAAddImagesToAtlas), 
+	//only the images that have already been placed are part of the atlas
+	for (nodeIndex = 0;
+		nodeIndex < p_NumImageNodes && result == K15_IA_RESULT_SUCCESS;
+		++nodeIndex)
+	{
+		imageNode = p_ImageNodes + nodeIndex;
+
+		//every trial starts with the original orientation
+		if ((imageNode->flags & KIA_IMAGE_NODE_ROTATED) != 0)
+			K15_IARotateImageNode(imageNode);
+
+		p_ImageAtlas->numImageNodes = numImageNodes + nodeIndex;
+
+		if (p_AllowGrowing)
+			result = K15_IAInsertImageNode(p_ImageAtlas, imageNode, &posX, &posY);
+		else
+			result = K15_IAPlaceImageNode(p_ImageAtlas, imageNode);
+	}
+
+	p_ImageAtlas->numImageNodes = numImageNodes;
+
+	return result == K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_internal void K15_IAFitAtlasToImageNodes(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNodes,
+	kia_u32 p_NumImageNodes, kia_u32 p_MaxWidth, kia_u32 p_MaxHeight, kia_u32 p_TotalArea)
+{
+	kia_u32 maxDimension = p_ImageAtlas->maxDimension;
+	kia_u32 numGrowRetries = p_ImageAtlas->numGrowRetries;
+	kia_u32 bestWidth = p_ImageAtlas->width;
+	kia_u32 bestHeight = p_ImageAtlas->height;
+	kia_u32 bestArea = ~0u;
+	kia_u32 width = 0;
+	kia_u32 height = 0;
+	kia_u32 minHeight = 0;
+	kia_u32 maxHeight = 0;
+	kia_u32 middleHeight = 0;
+	kia_u32 nodeIndex = 0;
+
+	//the atlas itself is the scratch memory of all trials. The regular placement (which grows 
+	//the atlas) is the size to beat, the search can't guarantee to find it.
+	K15_IAResetAtlasPacking(p_ImageAtlas, bestWidth, bestHeight);
+
+	if (K15_IATryToGrowAtlasSizeToFit(p_ImageAtlas, p_MaxWidth, p_MaxHeight, p_TotalArea) == K15_IA_RESULT_SUCCESS &&
+		K15_IATryToPlaceImageNodes(p_ImageAtlas, p_ImageNodes, p_NumImageNodes, K15_IA_TRUE))
+	{
+		bestArea = p_ImageAtlas->width * p_ImageAtlas->height;
+	}
+
+	p_ImageAtlas->numGrowRetries = numGrowRetries;
+
+	//the narrowest possible atlas has to be at least as wide as the widest image
+	width = K15_IA_MAX(p_MaxWidth, (p_TotalArea + maxDimension - 1) / maxDimension);
+	width = K15_IACalculateGrownDimension(p_ImageAtlas, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION, width);
+
+	while (width <= maxDimension)
+	{
+		minHeight = K15_IA_MAX(p_MaxHeight, (p_TotalArea + width - 1) / width);
+		maxHeight = K15_IA_MIN(maxDimension, K15_IA_MAX_FIT_ASPECT_RATIO * K15_IA_MAX(width, p_MaxHeight));
+
+		//the atlas shouldn't get a lot wider than high just to save a few pixels
+		if (width > K15_IA_MAX_FIT_ASPECT_RATIO * p_MaxWidth)
+			minHeight = K15_IA_MAX(minHeight, (width + K15_IA_MAX_FIT_ASPECT_RATIO - 1) / K15_IA_MAX_FIT_ASPECT_RATIO);
+
+		//only candidates that are smaller than the best one so far are of interest
+		if (bestArea != ~0u)
+		{
+			if (width * K15_IA_MAX(p_MaxHeight, (p_TotalArea + width - 1) / width) >= bestArea)
+				break;
+
+			maxHeight = K15_IA_MIN(maxHeight, (bestArea - 1) / width);
+		}
+
+		//binary search for the smallest height that fits. If a height doesn't fit, smaller 
+		//heights are assumed not to fit either. 
+		while (minHeight <= maxHeight)
+		{
+			middleHeight = minHeight + (maxHeight - minHeight) / 2;
+			height = K15_IACalculateGrownDimension(p_ImageAtlas, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION, middleHeight);
+
+			//no candidate between the middle and the upper end
+			if (height > maxHeight)
+			{
+				maxHeight = middleHeight - 1;
+				continue;
+			}
+
+			K15_IAResetAtlasPacking(p_ImageAtlas, width, height);
+
+			if (K15_IATryToPlaceImageNodes(p_ImageAtlas, p_ImageNodes, p_NumImageNodes, K15_IA_FALSE))
+			{
+				bestWidth = width;
+				bestHeight = height;
+				bestArea = width * height;
+				maxHeight = height - 1;
+			}
+			else
+			{
+				minHeight = height + 1;
+			}
+		}
+
+		//try widths roughly 6% apart, trying every possible width takes way too long
+		width = K15_IACalculateGrownDimension(p_ImageAtlas, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION, 
+			width + width / 16 + 1);
+	}
+
+	//the batch gets placed into the best size again (or grows from the old size like usual)
+	K15_IAResetAtlasPacking(p_ImageAtlas, bestWidth, bestHeight);
+
+	for (nodeIndex = 0;
+		nodeIndex < p_NumImageNodes;
+		++nodeIndex)
+	{
+		if ((p_ImageNodes[nodeIndex].flags & KIA_IMAGE_NODE_ROTATED) != 0)
+			K15_IARotateImageNode(p_ImageNodes + nodeIndex);
+	}
+}
+/*********************************************************************************/
+//Move a placed image node into the slot of a removed image (or append it to the used part of the
+//image node array). Returns the index of the image node.
+kia_internal kia_u32 K15_IAStoreImageNode(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_ImageNode)
+{
+	kia_u32 imageNodeIndex = p_ImageAtlas->firstFreeImageNodeIndex;
+	K15_IAImageNode* imageNode = 0;
+	K15_IAImageNode removedImageNode;
+
+	if (imageNodeIndex == K15_IA_INVALID_INDEX)
+	{
+		imageNodeIndex = p_ImageAtlas->numImageNodes++;
+		imageNode = p_ImageAtlas->imageNodes + imageNodeIndex;
+
+		if (imageNode != p_ImageNode)
+			*imageNode = *p_ImageNode;
+
+		K15_IAMarkImageNodeAsDirty(p_ImageAtlas, imageNodeIndex);
+
+		return imageNodeIndex;
+	}
+
+	imageNode = p_ImageAtlas->imageNodes + imageNodeIndex;
+	removedImageNode = *imageNode;
+
+	//a removed image that has never been baked is still part of the dirty list
+	*imageNode = *p_ImageNode;
+	imageNode->flags |= removedImageNode.flags & KIA_IMAGE_NODE_DIRTY;
+	imageNode->nextDirtyIndex = removedImageNode.nextDirtyIndex;
+
+	p_ImageAtlas->firstFreeImageNodeIndex = removedImageNode.nextFreeIndex;
+	--p_ImageAtlas->numRemovedImageNodes;
+	K15_IAMarkImageNodeAsDirty(p_ImageAtlas, imageNodeIndex);
+
+	return imageNodeIndex;
+}
+/*********************************************************************************/
+//Fallback of K15_IAAddImagesToAtlas for atlases with a fixed number of images that only have
+//room for the batch in the slots of removed images. The images get added one by one in the
+//same order the sorted batch would have been placed in.
+kia_internal kia_result K15_IAAddImagesToAtlasOneByOne(K15_ImageAtlas* p_ImageAtlas, K15_IASortKey p_SortKey,
+	kia_u32 p_NumImages, K15_IAPixelFormat* p_PixelFormats, void** p_PixelData,
+	kia_u32* p_PixelDataWidths, kia_u32* p_PixelDataHeights, int* p_OutX, int* p_OutY,
+	kia_u32* p_OutHandles)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+	K15_IASortFnc sortFunction = K15_IAGetImageNodeSortFunction(p_SortKey);
+
+	kia_u32 imageIndex = 0;
+	kia_u32 nodeIndex = 0;
+	kia_u32 bestImageIndex = 0;
+	K15_IAImageNode imageNode;
+	K15_IAImageNode bestImageNode;
+
+	K15_IA_MEMSET(&imageNode, 0, sizeof(imageNode));
+	K15_IA_MEMSET(&bestImageNode, 0, sizeof(bestImageNode));
+
+	for (imageIndex = 0;
+		imageIndex < p_NumImages;
+		++imageIndex)
+	{
+		p_OutX[imageIndex] = -1;
+		p_OutY[imageIndex] = -1;
+
+		if (p_OutHandles)
+			p_OutHandles[imageIndex] = K15_IA_INVALID_INDEX;
+	}
+
+	for (nodeIndex = 0;
+		nodeIndex < p_NumImages && result == K15_IA_RESULT_SUCCESS;
+		++nodeIndex)
+	{
+		bestImageIndex = K15_IA_INVALID_INDEX;
+
+		//images that haven't been placed yet still have a x position of -1
+		for (imageIndex = 0;
+			imageIndex < p_NumImages;
+			++imageIndex)
+		{
+			if (p_OutX[imageIndex] != -1)
+				continue;
+
+			imageNode.batchIndex = imageIndex;
+			K15_IASetImageNodeDimension(p_ImageAtlas, &imageNode, p_PixelDataWidths[imageIndex], 
+				p_PixelDataHeights[imageIndex]);
+
+			if (bestImageIndex == K15_IA_INVALID_INDEX || sortFunction(&imageNode, &bestImageNode) < 0)
+			{
+				bestImageIndex = imageIndex;
+				bestImageNode = imageNode;
+			}
+		}
+
+		result = K15_IAAddImageToAtlasWithHandle(p_ImageAtlas, p_PixelFormats[bestImageIndex], 
+			p_PixelData[bestImageIndex], p_PixelDataWidths[bestImageIndex], p_PixelDataHeights[bestImageIndex],
+			p_OutX + bestImageIndex, p_OutY + bestImageIndex, 
+			p_OutHandles ? p_OutHandles + bestImageIndex : 0);
+	}
+
+	return result;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAAddImagesToAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IASortKey p_SortKey,
+	kia_u32 p_NumImages, K15_IAPixelFormat* p_PixelFormats, void** p_PixelData,
+	kia_u32* p_PixelDataWidths, kia_u32* p_PixelDataHeights, int* p_OutX, int* p_OutY,
+	kia_u32* p_OutHandles)
+{
+	kia_result result = K15_IA_RESULT_SUCCESS;
+
+	kia_u32 imageIndex = 0;
+	kia_u32 nodeIndex = 0;
+	kia_u32 imageNodeIndex = 0;
+	kia_u32 maxWidth = 0;
+	kia_u32 maxHeight = 0;
+	kia_u32 totalArea = 0;
+	K15_IAImageNode* imageNodes = 0;
+	K15_IAImageNode* imageNode = 0;
+
+	if (!p_ImageAtlas || p_NumImages == 0 || !p_PixelFormats || !p_PixelData || 
+		!p_PixelDataWidths || !p_PixelDataHeights || !p_OutX || !p_OutY)
+	{
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+	}
+
+	for (imageIndex = 0;
+		imageIndex < p_NumImages;
+		++imageIndex)
+	{
+		if (!p_PixelData[imageIndex] || p_PixelDataWidths[imageIndex] == 0 || 
+			p_PixelDataHeights[imageIndex] == 0 || K15_IAIsBlockCompressedPixelFormat(p_PixelFormats[imageIndex]))
+		{
+			return K15_IA_RESULT_INVALID_ARGUMENTS;
+		}
+	}
+
+	result = K15_IAReserveImageNodes(p_ImageAtlas, p_ImageAtlas->numImageNodes + p_NumImages);
 
-				skyline->baseLineWidth = baseLineRightPos - rightPos;
-				skyline->baseLinePosX = rightPos;
-				continue;
-			}
+	//there's no room to sort the batch at the end of the image node array, but the slots of
+	//removed images are enough to hold all images
+	if (result == K15_IA_RESULT_OUT_OF_RANGE && 
+		p_ImageAtlas->numMaxImageNodes - p_ImageAtlas->numImageNodes + p_ImageAtlas->numRemovedImageNodes >= p_NumImages)
+	{
+		return K15_IAAddImagesToAtlasOneByOne(p_ImageAtlas, p_SortKey, p_NumImages, p_PixelFormats, 
+			p_PixelData, p_PixelDataWidths, p_PixelDataHeights, p_OutX, p_OutY, p_OutHandles);
+	}
 
-			numSkylines = K15_IARemoveSkylineByIndex(p_Skylines, numSkylines, skylineIndex);
-			numWastedSpaceRects = K15_IAAddWastedSpaceRect(p_WastedSpaceRects, numWastedSpaceRects,
-				baseLinePosX, baseLinePosY, baseLineWidth, p_PosY - baseLinePosY);
+	if (result != K15_IA_RESULT_SUCCESS)
+		return result;
 
-			--skylineIndex;
-		}
+	//the unused part of the image node array is used to sort the images, so
+	//we don't need any additional memory
+	imageNodes = p_ImageAtlas->imageNodes + p_ImageAtlas->numImageNodes;
+
+	for (imageIndex = 0;
+		imageIndex < p_NumImages;
+		++imageIndex)
+	{
+		imageNode = imageNodes + imageIndex;
+		imageNode->pixelData = (kia_byte*)p_PixelData[imageIndex];
+		imageNode->pixelDataFormat = p_PixelFormats[imageIndex];
+		imageNode->rect.posX = 0;
+		imageNode->rect.posY = 0;
+		imageNode->batchIndex = imageIndex;
+		imageNode->flags = 0;
+		K15_IASetImageNodeDimension(p_ImageAtlas, imageNode, p_PixelDataWidths[imageIndex], 
+			p_PixelDataHeights[imageIndex]);
+
+		maxWidth = K15_IA_MAX(maxWidth, (kia_u32)imageNode->rect.width);
+		maxHeight = K15_IA_MAX(maxHeight, (kia_u32)imageNode->rect.height);
+		totalArea += imageNode->rect.width * imageNode->rect.height;
+
+		p_OutX[imageIndex] = -1;
+		p_OutY[imageIndex] = -1;
+
+		if (p_OutHandles)
+			p_OutHandles[imageIndex] = K15_IA_INVALID_INDEX;
 	}
 
-	*p_NumSkylinesOutIn = numSkylines;
-	*p_NumWastedSpaceRectsOutIn = numWastedSpaceRects;
-}
-/*********************************************************************************/
-kia_internal kia_u32 K15_IAMergeSkylines(K15_IASkyline* p_Skylines, kia_u32 p_NumSkylines)
-{
-	K15_IASkyline* skyline = 0;
-	K15_IASkyline* previousSkyline = 0;
+	K15_IASortImageNodes(imageNodes, p_NumImages, p_SortKey);
 
-	kia_u32 baselineY = 0;
-	kia_u32 previousBaseLineY = 0;
-	kia_u32 skylineIndex = 1;
-	kia_u32 numSkylines = p_NumSkylines;
+	//the batch is all there is, so the atlas can be sized to fit it
+	if ((p_ImageAtlas->flags & KIA_FIT_MINIMAL_DIMENSION) != 0 && 
+		p_ImageAtlas->numImageNodes == p_ImageAtlas->numRemovedImageNodes)
+	{
+		K15_IAFitAtlasToImageNodes(p_ImageAtlas, imageNodes, p_NumImages, maxWidth, maxHeight, totalArea);
+	}
 
-	if (numSkylines > 1)
+	//grow the atlas up front so that it is at least as big as all images 
+	//combined (saves a lot of failed placement searches)
+	result = K15_IATryToGrowAtlasSizeToFit(p_ImageAtlas, maxWidth, maxHeight, 
+		K15_IACalculateUsedAtlasArea(p_ImageAtlas) + totalArea);
+
+	for (nodeIndex = 0;
+		nodeIndex < p_NumImages && result == K15_IA_RESULT_SUCCESS;
+		++nodeIndex)
 	{
-		for (skylineIndex = 1;
-			skylineIndex < numSkylines;
-			++skylineIndex)
-		{
-			skyline = p_Skylines + skylineIndex;
-			previousSkyline = p_Skylines + skylineIndex - 1;
+		imageNode = imageNodes + nodeIndex;
+		imageIndex = imageNode->batchIndex;
 
-			if (skyline->baseLinePosY == previousSkyline->baseLinePosY)
-			{
-				previousSkyline->baseLineWidth += skyline->baseLineWidth;
+		result = K15_IAInsertImageNode(p_ImageAtlas, imageNode, 
+			p_OutX + imageIndex, p_OutY + imageIndex);
 
-				numSkylines = K15_IARemoveSkylineByIndex(p_Skylines, numSkylines, skylineIndex);
-				--skylineIndex;
-			}
+		if (result == K15_IA_RESULT_SUCCESS)
+		{
+			imageNodeIndex = K15_IAStoreImageNode(p_ImageAtlas, imageNode);
+
+			if (p_OutHandles)
+				p_OutHandles[imageIndex] = imageNodeIndex;
 		}
 	}
 
-	return numSkylines;
+	return result;
 }
 /*********************************************************************************/
-kia_internal kia_result K15_IATryToInsertSkyline(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_BaseLineY,
-	kia_u32 p_BaseLineX, kia_u32 p_BaseLineWidth)
+kia_internal kia_u32 K15_IAResolveBakeFlags(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_BakeFlags)
 {
-	K15_IASkyline* skylines = p_ImageAtlas->skylines;
-	K15_IASkyline* newSkyline = 0;
-	K15_IARect* wastedSpaceRects = p_ImageAtlas->wastedSpaceRects;
-
-	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
-	kia_u32 numWastedSpaceRects = p_ImageAtlas->numWastedSpaceRects;
+	//fall back to clearing everything if we can't tell where the free space is
+	if ((p_BakeFlags & (KIA_BAKE_SKIP_CLEAR | KIA_BAKE_CLEAR_ALL)) == 0 && 
+		!K15_IAIsFreeSpaceFullyTracked(p_ImageAtlas))
+	{
+		p_BakeFlags |= KIA_BAKE_CLEAR_ALL;
+	}
 
-	if (numSkylines == K15_IA_MAX_SKYLINES)
-		return K15_IA_RESULT_TOO_FEW_SKYLINES;
+	return p_BakeFlags;
+}
+/*********************************************************************************/
+kia_internal void K15_IAMarkAtlasAsBaked(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat)
+{
+	K15_IAClearDirtyImageNodes(p_ImageAtlas);
+	p_ImageAtlas->bakedWidth = p_ImageAtlas->width;
+	p_ImageAtlas->bakedHeight = p_ImageAtlas->height;
+	p_ImageAtlas->bakedPixelFormat = p_PixelFormat;
+}
+/*********************************************************************************/
+kia_def void K15_IABakeImageAtlasIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas,
+	K15_IAPixelFormat p_DestinationPixelFormat, void* p_DestinationPixelData,
+	int* p_OutWidth, int* p_OutHeight)
+{
+	kia_u32 bakeFlags = 0;
 
-	newSkyline = skylines + numSkylines++;
-	newSkyline->baseLinePosX = p_BaseLineX;
-	newSkyline->baseLinePosY = p_BaseLineY;
-	newSkyline->baseLineWidth = p_BaseLineWidth;
+	if (!p_ImageAtlas || !p_DestinationPixelData)
+		return;
 
-	//Sort by x position
-	K15_IA_QSORT(skylines, numSkylines, sizeof(K15_IASkyline), K15_IASortSkylineByXPos);
+	bakeFlags = K15_IAResolveBakeFlags(p_ImageAtlas, KIA_BAKE_CLEAR_FREE_SPACE);
+	K15_IABakeAtlasRows(p_ImageAtlas, p_DestinationPixelFormat, (kia_byte*)p_DestinationPixelData,
+		0, p_ImageAtlas->height, bakeFlags);
+	K15_IAMarkAtlasAsBaked(p_ImageAtlas, p_DestinationPixelFormat);
 
-	//try to merge neighbor skylines with the same baseline (y pos)
-	p_ImageAtlas->numSkylines = K15_IAMergeSkylines(skylines, numSkylines);
+	if (p_OutWidth)
+		*p_OutWidth = p_ImageAtlas->width;
 
-	return K15_IA_RESULT_SUCCESS;
+	if (p_OutHeight)
+		*p_OutHeight = p_ImageAtlas->height;
 }
 /*********************************************************************************/
-kia_internal kia_result K15_IATryToGrowAtlasSize(K15_ImageAtlas* p_ImageAtlas)
+kia_def void K15_IABakeImageAtlasIntoPixelBufferParallel(K15_ImageAtlas* p_ImageAtlas,
+	K15_IAPixelFormat p_DestinationPixelFormat, void* p_DestinationPixelData, kia_u32 p_NumJobs,
+	K15_IARunBakeJobsFnc p_RunBakeJobsFnc, void* p_UserData, kia_u32 p_BakeFlags, 
+	int* p_OutWidth, int* p_OutHeight)
 {
-	kia_u32 width = p_ImageAtlas->width;
-	kia_u32 height = p_ImageAtlas->height;
-	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
-	kia_u32 widthExtend = 0;
-	kia_u32 skylineIndex = 0;
-	kia_u32 oldWidth = width;
-	kia_b8 foundSkyline = K15_IA_FALSE;
-
-	K15_IASkyline* skylines = p_ImageAtlas->skylines;
-	K15_IASkyline* skyline = 0;
+	K15_IABakeJobData bakeJobData;
+	kia_u32 numJobs = 0;
 
-	if (width > height)
-		height = height << 1;
-	else
-		width = width << 1;
-
-	if (width > K15_IA_DIMENSION_THRESHOLD || height > K15_IA_DIMENSION_THRESHOLD)
-		return K15_IA_RESULT_ATLAS_TOO_SMALL;
+	if (!p_ImageAtlas || !p_DestinationPixelData)
+		return;
 
-	widthExtend = width - oldWidth;
+	//every job bakes at least one row
+	numJobs = K15_IA_MIN(p_NumJobs, p_ImageAtlas->height);
+	numJobs = K15_IA_MIN(numJobs, K15_IA_MAX_BAKE_JOBS);
+	numJobs = K15_IA_MAX(numJobs, 1);
 
-	p_ImageAtlas->width = width;
-	p_ImageAtlas->height = height;
+	bakeJobData.imageAtlas = p_ImageAtlas;
+	bakeJobData.destinationPixelData = (kia_byte*)p_DestinationPixelData;
+	bakeJobData.destinationPixelFormat = p_DestinationPixelFormat;
+	bakeJobData.numJobs = numJobs;
+	bakeJobData.bakeFlags = K15_IAResolveBakeFlags(p_ImageAtlas, p_BakeFlags);
 
-	//find skylines with pos == 0 (at the very bottom and extend their width)
-	for (skylineIndex = 0;
-		skylineIndex < numSkylines;
-		++skylineIndex)
-	{
-		skyline = skylines + skylineIndex;
+	if (!p_RunBakeJobsFnc)
+		p_RunBakeJobsFnc = K15_IARunBakeJobs;
 
-		if (skyline->baseLinePosY == 0)
-		{
-			skyline->baseLineWidth += widthExtend;
-			foundSkyline = K15_IA_TRUE;
-		}
-	}
+	p_RunBakeJobsFnc(K15_IAExecuteBakeJob, &bakeJobData, numJobs, p_UserData);
+	K15_IAMarkAtlasAsBaked(p_ImageAtlas, p_DestinationPixelFormat);
 
-	if (!foundSkyline)
-		K15_IATryToInsertSkyline(p_ImageAtlas, 0, oldWidth, widthExtend);
+	if (p_OutWidth)
+		*p_OutWidth = p_ImageAtlas->width;
 
-	return K15_IA_RESULT_SUCCESS;
+	if (p_OutHeight)
+		*p_OutHeight = p_ImageAtlas->height;
 }
 /*********************************************************************************/
-kia_internal kia_result K15_IATryToGrowAtlasSizeToFit(K15_ImageAtlas* p_ImageAtlas,
-	kia_u32 p_MinWidth, kia_u32 p_MinHeight)
+kia_def kia_u32 K15_IACalculateAtlasBandPixelDataSizeInBytes(K15_ImageAtlas* p_ImageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, kia_u32 p_NumRowsPerBand)
 {
-	kia_u32 width = p_ImageAtlas->width;
-	kia_u32 height = p_ImageAtlas->height;
+	return K15_IACalculatePixelDataSizeInBytes(p_ImageAtlas->width, 
+		K15_IA_MIN(p_NumRowsPerBand, p_ImageAtlas->height), p_PixelFormat);
+}
+/*********************************************************************************/
+kia_def kia_result K15_IABakeImageAtlasIntoBands(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
+	void* p_BandPixelDataBuffer, kia_u32 p_NumRowsPerBand, K15_IABakeBandFnc p_BakeBandFnc, 
+	void* p_UserData, int* p_OutWidth, int* p_OutHeight)
+{
+	kia_u32 bakeFlags = 0;
+	kia_u32 startRow = 0;
+	kia_u32 endRow = 0;
 
-	if (height >= p_MinHeight &&
-		width >= p_MinWidth)
+	if (!p_ImageAtlas || !p_BandPixelDataBuffer || !p_BakeBandFnc || p_NumRowsPerBand == 0 ||
+		(K15_IAIsBlockCompressedPixelFormat(p_PixelFormat) && p_NumRowsPerBand % K15_IA_BLOCK_DIMENSION != 0))
 	{
-		return K15_IA_RESULT_SUCCESS;
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
 	}
 
-	while (height < p_MinHeight || width < p_MinWidth)
-	{
-		kia_result result = K15_IATryToGrowAtlasSize(p_ImageAtlas);
+	//the band buffer gets reused, so the free space has to be cleared for every band
+	bakeFlags = K15_IAResolveBakeFlags(p_ImageAtlas, KIA_BAKE_CLEAR_FREE_SPACE);
 
-		if (result != K15_IA_RESULT_SUCCESS)
-			return result;
+	//images outside of a band are skipped by comparing their rect against the rows of the 
+	//band, that's cheap compared to copying the pixels and doesn't need any memory
+	for (startRow = 0;
+		startRow < p_ImageAtlas->height;
+		startRow = endRow)
+	{
+		endRow = K15_IA_MIN(startRow + p_NumRowsPerBand, p_ImageAtlas->height);
 
-		width = p_ImageAtlas->width;
-		height = p_ImageAtlas->height;
+		K15_IABakeAtlasRows(p_ImageAtlas, p_PixelFormat, (kia_byte*)p_BandPixelDataBuffer, 
+			startRow, endRow, bakeFlags);
+		p_BakeBandFnc(p_BandPixelDataBuffer, startRow, endRow - startRow, p_UserData);
 	}
 
+	K15_IAMarkAtlasAsBaked(p_ImageAtlas, p_PixelFormat);
+
+	if (p_OutWidth)
+		*p_OutWidth = p_ImageAtlas->width;
+
+	if (p_OutHeight)
+		*p_OutHeight = p_ImageAtlas->height;
+
 	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_u32 K15_IACalculatePlacementHeuristic(kia_u32 p_BaseLinePosX, kia_u32 p_BaseLinePosY, kia_u32 p_NodeWidth,
-	kia_u32 p_NodeHeight, K15_IASkyline* p_Skylines, kia_u32 p_NumSkylines)
+kia_internal void K15_IAAddDirtyRect(K15_IADirtyRect* p_DirtyRects, kia_u32 p_MaxDirtyRects, 
+	kia_u32* p_InOutNumDirtyRects, int p_PosX, int p_PosY, int p_Width, int p_Height)
 {
-	kia_u32 heuristic = 0;
-	kia_u32 skylineIndex = 0;
-	K15_IASkyline* skyline = 0;
+	K15_IADirtyRect* dirtyRect = 0;
+	int dirtyRectRight = 0;
+	int dirtyRectBottom = 0;
 
-	for (skylineIndex = 0;
-		skylineIndex < p_NumSkylines;
-		++skylineIndex)
+	if (*p_InOutNumDirtyRects < p_MaxDirtyRects)
 	{
-		skyline = p_Skylines + skylineIndex;
-
-		if (skyline->baseLinePosX >= skyline->baseLinePosX && skyline->baseLinePosX < p_BaseLinePosX + p_NodeWidth)
-		{
-			kia_u32 right = K15_IA_MIN(skyline->baseLinePosX + skyline->baseLineWidth, p_BaseLinePosX + p_NodeWidth);
-			kia_u32 left = K15_IA_MAX(skyline->baseLinePosX, p_BaseLinePosX);
-
-			kia_u32 width = right - left;
-			kia_u32 height = p_BaseLinePosY - skyline->baseLinePosY;
-
-			heuristic += width * height;
-		}
+		dirtyRect = p_DirtyRects + (*p_InOutNumDirtyRects)++;
+		dirtyRect->posX = p_PosX;
+		dirtyRect->posY = p_PosY;
+		dirtyRect->width = p_Width;
+		dirtyRect->height = p_Height;
+	}
+	else
+	{
+		//out of rects, grow the last rect so that it covers this area as well
+		dirtyRect = p_DirtyRects + p_MaxDirtyRects - 1;
+		dirtyRectRight = K15_IA_MAX(dirtyRect->posX + dirtyRect->width, p_PosX + p_Width);
+		dirtyRectBottom = K15_IA_MAX(dirtyRect->posY + dirtyRect->height, p_PosY + p_Height);
+
+		dirtyRect->posX = K15_IA_MIN(dirtyRect->posX, p_PosX);
+		dirtyRect->posY = K15_IA_MIN(dirtyRect->posY, p_PosY);
+		dirtyRect->width = dirtyRectRight - dirtyRect->posX;
+		dirtyRect->height = dirtyRectBottom - dirtyRect->posY;
 	}
-
-	return heuristic;
 }
 /*********************************************************************************/
-kia_internal kia_u32 K15_IARemoveOrTrimWastedSpaceRect(K15_IARect* p_WastedSpaceRects,
-	kia_u32 p_NumWastedSpaceRects, kia_u32 p_Index, kia_u32 p_Width, kia_u32 p_Height)
+kia_def kia_result K15_IABakeDirtyImagesIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas,
+	K15_IAPixelFormat p_DestinationPixelFormat, void* p_DestinationPixelData, 
+	K15_IADirtyRect* p_OutDirtyRects, kia_u32 p_MaxDirtyRects, kia_u32* p_OutNumDirtyRects)
 {
-	K15_IARect* wastedSpaceRect = p_WastedSpaceRects + p_Index;
+	kia_u32 nodeIndex = 0;
+	kia_u32 rectIndex = 0;
+	kia_u32 numDirtyRects = 0;
+	kia_b8 dirtyAtlas = K15_IA_FALSE;
+
+	K15_IAImageNode* imageNode = 0;
+	K15_IADirtyRect* pendingClearRect = 0;
 
-	if (wastedSpaceRect->width == p_Width &&
-		wastedSpaceRect->height > p_Height)
+	if (!p_ImageAtlas || !p_DestinationPixelData || !p_OutDirtyRects || !p_OutNumDirtyRects || 
+		p_MaxDirtyRects == 0)
 	{
-		wastedSpaceRect->posY += p_Height;
-		wastedSpaceRect->height -= p_Height;
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
 	}
-	else if (wastedSpaceRect->height == p_Height &&
-		wastedSpaceRect->width > p_Width)
+
+	*p_OutNumDirtyRects = 0;
+
+	//the layout of the pixel buffer changes if the atlas got resized
+	if (p_ImageAtlas->bakedWidth != p_ImageAtlas->width || p_ImageAtlas->bakedHeight != p_ImageAtlas->height ||
+		p_ImageAtlas->bakedPixelFormat != p_DestinationPixelFormat)
 	{
-		wastedSpaceRect->posX += p_Width;
-		wastedSpaceRect->width -= p_Width;
+		return K15_IA_RESULT_FULL_BAKE_REQUIRED;
 	}
-	else
+
+	//too many images have been removed to clear them one by one, clear the whole free space instead
+	if ((p_ImageAtlas->flags & KIA_CLEAR_FREE_SPACE_PENDING) != 0)
 	{
-		kia_u32 rectWidth = wastedSpaceRect->width;
-		kia_u32 rectHeight = wastedSpaceRect->height;
+		if (!K15_IAIsFreeSpaceFullyTracked(p_ImageAtlas))
+			return K15_IA_RESULT_FULL_BAKE_REQUIRED;
+
+		K15_IAClearAtlasFreeSpace(p_ImageAtlas, p_DestinationPixelFormat, (kia_byte*)p_DestinationPixelData,
+			0, p_ImageAtlas->height, K15_IA_TRUE);
+		K15_IAAddDirtyRect(p_OutDirtyRects, p_MaxDirtyRects, &numDirtyRects, 
+			0, 0, p_ImageAtlas->width, p_ImageAtlas->height);
+		dirtyAtlas = K15_IA_TRUE;
+	}
 
-		kia_u32 restHeight = wastedSpaceRect->height - p_Height;
-		kia_u32 restWidth = wastedSpaceRect->width - p_Width;
+	//clear the area of removed images first, new images might have been placed there
+	//(the free space of the pixel buffer has already been cleared during the last bake)
+	for (rectIndex = 0;
+		rectIndex < p_ImageAtlas->numPendingClearRects;
+		++rectIndex)
+	{
+		pendingClearRect = p_ImageAtlas->pendingClearRects + rectIndex;
+		K15_IAClearAtlasRect(p_ImageAtlas, p_DestinationPixelFormat, (kia_byte*)p_DestinationPixelData,
+			pendingClearRect->posX, pendingClearRect->posY, pendingClearRect->width, pendingClearRect->height,
+			0, p_ImageAtlas->height, K15_IA_TRUE);
+		K15_IAAddDirtyRect(p_OutDirtyRects, p_MaxDirtyRects, &numDirtyRects, 
+			pendingClearRect->posX, pendingClearRect->posY, pendingClearRect->width, pendingClearRect->height);
+	}
 
-		kia_u32 posLowerX = wastedSpaceRect->posX;
-		kia_u32 posLowerY = wastedSpaceRect->posY + p_Height;
-		kia_u32 posRightX = wastedSpaceRect->posX + p_Width;
-		kia_u32 posRightY = wastedSpaceRect->posY;
+	for (nodeIndex = p_ImageAtlas->firstDirtyImageNodeIndex;
+		nodeIndex != K15_IA_INVALID_INDEX;
+		nodeIndex = imageNode->nextDirtyIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
 
-		if (p_NumWastedSpaceRects > 1)
-		{
-			//Remove
-			kia_u32 numElementsToShift = p_NumWastedSpaceRects - p_Index;
-			K15_IA_MEMMOVE(p_WastedSpaceRects + p_Index, p_WastedSpaceRects + p_Index + 1,
-				sizeof(K15_IARect) * numElementsToShift);
-		}
+		//images that got removed before they have ever been baked
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
 
-		--p_NumWastedSpaceRects;
+		K15_IABakeImageNodeRows(p_ImageAtlas, imageNode, p_DestinationPixelFormat, 
+			(kia_byte*)p_DestinationPixelData, 0, p_ImageAtlas->height);
 
-		if (restWidth != 0 && restHeight != 0)
+		if (!dirtyAtlas)
 		{
-			if (restWidth > restHeight)
-			{
-				p_NumWastedSpaceRects = K15_IAAddWastedSpaceRect(p_WastedSpaceRects, p_NumWastedSpaceRects, posRightX, posRightY, restWidth, rectHeight);
-				p_NumWastedSpaceRects = K15_IAAddWastedSpaceRect(p_WastedSpaceRects, p_NumWastedSpaceRects, posLowerX, posLowerY, p_Width, restHeight);
-			}
-			else
-			{
-				p_NumWastedSpaceRects = K15_IAAddWastedSpaceRect(p_WastedSpaceRects, p_NumWastedSpaceRects, posLowerX, posLowerY, rectWidth, restHeight);
-				p_NumWastedSpaceRects = K15_IAAddWastedSpaceRect(p_WastedSpaceRects, p_NumWastedSpaceRects, posRightX, posRightY, restWidth, p_Height);
-			}
+			K15_IAAddDirtyRect(p_OutDirtyRects, p_MaxDirtyRects, &numDirtyRects, 
+				imageNode->rect.posX, imageNode->rect.posY, imageNode->rect.width, imageNode->rect.height);
 		}
 	}
 
-	return p_NumWastedSpaceRects;
+	K15_IAClearDirtyImageNodes(p_ImageAtlas);
+	*p_OutNumDirtyRects = numDirtyRects;
+
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_internal kia_b8 K15_IATryToFitInWastedSpace(K15_IARect* p_WastedSpaceRects, kia_u32* p_NumWastedSpaceRectsInOut,
-	K15_IAImageNode* p_NodeToInsert)
+kia_def kia_u32 K15_IACalculateAtlasMipChainPixelDataSizeInBytes(K15_ImageAtlas* p_ImageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, kia_u32 p_NumMipLevels)
 {
-	kia_u32 wastedRectWidth = 0;
-	kia_u32 wastedRectHeight = 0;
-	kia_u32 nodeWidth = p_NodeToInsert->rect.width;
-	kia_u32 nodeHeight = p_NodeToInsert->rect.height;
-	kia_u32 numWastedSpaceRects = *p_NumWastedSpaceRectsInOut;
-	kia_u32 heuristic = 0;
-	kia_u32 bestHeuristic = ~0;
-	kia_u32 bestFitIndex = ~0;
-	kia_u32 rectIndex = 0;
-	K15_IARect* wastedSpaceRect = 0;
+	kia_u32 width = p_ImageAtlas->width;
+	kia_u32 height = p_ImageAtlas->height;
+	kia_u32 numMipLevels = K15_IACalculateNumMipLevels(width, height);
+	kia_u32 pixelDataSizeInBytes = 0;
+	kia_u32 mipLevel = 0;
 
-	for (rectIndex = 0;
-		rectIndex < numWastedSpaceRects;
-		++rectIndex)
+	if (p_NumMipLevels != 0)
+		numMipLevels = K15_IA_MIN(numMipLevels, p_NumMipLevels);
+
+	for (mipLevel = 0;
+		mipLevel < numMipLevels;
+		++mipLevel)
 	{
-		wastedSpaceRect = p_WastedSpaceRects + rectIndex;
-		wastedRectWidth = wastedSpaceRect->width;
-		wastedRectHeight = wastedSpaceRect->height;
+		pixelDataSizeInBytes += K15_IACalculatePixelDataSizeInBytes(width, height, p_PixelFormat);
+		width = K15_IA_MAX(width >> 1, 1);
+		height = K15_IA_MAX(height >> 1, 1);
+	}
 
-		if (wastedRectWidth >= nodeWidth &&
-			wastedRectHeight >= nodeHeight)
-		{
-			heuristic = wastedRectWidth * wastedRectHeight;
+	return pixelDataSizeInBytes;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IABakeImageAtlasMipChainIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, void* p_DestinationPixelDataBuffer, kia_u32 p_NumMipLevels,
+	K15_IAMipFilter p_MipFilter, kia_u32* p_OutNumMipLevels)
+{
+	kia_u32 numMipLevels = 0;
+	kia_u32 bakeFlags = 0;
+	kia_u32 levelZeroSizeInBytes = 0;
+	kia_u32 nodeIndex = 0;
+	kia_byte* destinationPixelData = (kia_byte*)p_DestinationPixelDataBuffer;
+	K15_IAImageNode* imageNode = 0;
 
-			if (heuristic < bestHeuristic)
-			{
-				bestHeuristic = heuristic;
-				bestFitIndex = rectIndex;
-			}
-			
-			//we can't get better than this
-			if (bestHeuristic == 0)
-				break;
-		}
+	if (!p_ImageAtlas || !p_DestinationPixelDataBuffer || K15_IAIsBlockCompressedPixelFormat(p_PixelFormat) ||
+		(p_MipFilter != KIA_MIP_FILTER_BOX && p_MipFilter != KIA_MIP_FILTER_KAISER))
+	{
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
 	}
 
-	if (bestFitIndex != ~0)
+	numMipLevels = K15_IACalculateNumMipLevels(p_ImageAtlas->width, p_ImageAtlas->height);
+
+	if (p_NumMipLevels != 0)
+		numMipLevels = K15_IA_MIN(numMipLevels, p_NumMipLevels);
+
+	//the free space of level 0 is known, the smaller levels are simply cleared completely
+	bakeFlags = K15_IAResolveBakeFlags(p_ImageAtlas, KIA_BAKE_CLEAR_FREE_SPACE);
+	K15_IAClearAtlasRows(p_ImageAtlas, p_PixelFormat, destinationPixelData, 0, p_ImageAtlas->height, bakeFlags);
+
+	levelZeroSizeInBytes = K15_IACalculateAtlasPixelDataSizeInBytes(p_ImageAtlas, p_PixelFormat);
+	K15_IA_MEMSET(destinationPixelData + levelZeroSizeInBytes, 0, 
+		K15_IACalculateAtlasMipChainPixelDataSizeInBytes(p_ImageAtlas, p_PixelFormat, numMipLevels) - 
+		levelZeroSizeInBytes);
+
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
 	{
-		//copy position
-		wastedSpaceRect = p_WastedSpaceRects + bestFitIndex;
-		p_NodeToInsert->rect.posX = wastedSpaceRect->posX;
-		p_NodeToInsert->rect.posY = wastedSpaceRect->posY;
+		imageNode = p_ImageAtlas->imageNodes + nodeIndex;
 
-		numWastedSpaceRects = K15_IARemoveOrTrimWastedSpaceRect(p_WastedSpaceRects,
-			numWastedSpaceRects, bestFitIndex, nodeWidth, nodeHeight);
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+			continue;
+
+		K15_IABakeImageNodeRows(p_ImageAtlas, imageNode, p_PixelFormat, destinationPixelData, 
+			0, p_ImageAtlas->height);
+		K15_IABakeImageNodeMipLevels(p_ImageAtlas, imageNode, p_PixelFormat, destinationPixelData,
+			numMipLevels, p_MipFilter);
 	}
 
-	*p_NumWastedSpaceRectsInOut = numWastedSpaceRects;
+	K15_IAMarkAtlasAsBaked(p_ImageAtlas, p_PixelFormat);
+
+	if (p_OutNumMipLevels)
+		*p_OutNumMipLevels = numMipLevels;
 
-	return (bestFitIndex != ~0);
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_internal kia_b8 K15_IACheckCollision(K15_IASkyline* p_Skylines, kia_u32 p_NumSkylines, kia_u32 p_BaseLinePosY,
-	kia_u32 p_BaseLinePosX, kia_u32 p_Width)
+kia_internal kia_b8 K15_IAIsLittleEndianPlatform()
 {
-	kia_u32 baseLinePosRight = p_BaseLinePosX + p_Width;
-	kia_u32 skylineIndex = 0;
-	K15_IASkyline* skyline = 0;
-	kia_b8 collision = K15_IA_FALSE;
+	kia_u32 value = 1;
+	return *(kia_byte*)&value == 1;
+}
+/*********************************************************************************/
+kia_internal kia_u32 K15_IAAlignSerializedAtlasOffset(kia_u32 p_Offset)
+{
+	return (p_Offset + K15_IA_SERIALIZED_ATLAS_ALIGNMENT - 1) & ~(K15_IA_SERIALIZED_ATLAS_ALIGNMENT - 1);
+}
+/*********************************************************************************/
+kia_internal void K15_IACalculateSerializedAtlasLayout(K15_IASerializedAtlasHeader* p_Header)
+{
+	kia_u32 offset = K15_IAAlignSerializedAtlasOffset(sizeof(K15_IASerializedAtlasHeader));
 
-	for (skylineIndex = 0;
-		skylineIndex < p_NumSkylines;
-		++skylineIndex)
-	{
-		skyline = p_Skylines + skylineIndex;
+	//the capacities decide where the arrays start, so the loader only has to verify the offsets
+	p_Header->imageNodesOffset = offset;
+	offset = K15_IAAlignSerializedAtlasOffset(offset + p_Header->numMaxImageNodes * sizeof(K15_IAImageNode));
 
-		if (skyline->baseLinePosX > baseLinePosRight)
-			break;
+	p_Header->skylinesOffset = offset;
+	offset = K15_IAAlignSerializedAtlasOffset(offset + p_Header->numMaxSkylines * sizeof(K15_IASkyline));
 
-		if (skyline->baseLinePosY > p_BaseLinePosY)
-		{
-			collision = K15_IA_TRUE;
-			break;
-		}
+	p_Header->skylineWindowIndicesOffset = offset;
+	offset = K15_IAAlignSerializedAtlasOffset(offset + p_Header->numMaxSkylines * sizeof(kia_u32));
+
+	p_Header->wastedSpaceRectsOffset = offset;
+	offset = K15_IAAlignSerializedAtlasOffset(offset + p_Header->numMaxWastedSpaceRects * sizeof(K15_IARect));
+
+	p_Header->wastedSpaceRectLinksOffset = offset;
+	offset = K15_IAAlignSerializedAtlasOffset(offset + p_Header->numMaxWastedSpaceRects * sizeof(K15_IARectLink));
+
+	p_Header->wastedSpaceRectBucketsOffset = offset;
+	offset = K15_IAAlignSerializedAtlasOffset(offset + K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS * sizeof(kia_u32));
+
+	p_Header->sizeInBytes = offset;
+}
+/*********************************************************************************/
+kia_internal void K15_IAFillSerializedAtlasHeader(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumAdditionalImages,
+	K15_IASerializedAtlasHeader* p_OutHeader)
+{
+	K15_IA_MEMSET(p_OutHeader, 0, sizeof(K15_IASerializedAtlasHeader));
+
+	p_OutHeader->magic = K15_IA_SERIALIZED_ATLAS_MAGIC;
+	p_OutHeader->version = K15_IA_SERIALIZED_ATLAS_VERSION;
+	p_OutHeader->imageNodeSizeInBytes = sizeof(K15_IAImageNode);
+	p_OutHeader->skylineSizeInBytes = sizeof(K15_IASkyline);
+	p_OutHeader->rectSizeInBytes = sizeof(K15_IARect);
+	p_OutHeader->rectLinkSizeInBytes = sizeof(K15_IARectLink);
+	p_OutHeader->numWastedSpaceRectBuckets = K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS;
+
+	p_OutHeader->width = p_ImageAtlas->width;
+	p_OutHeader->height = p_ImageAtlas->height;
+	p_OutHeader->growStep = p_ImageAtlas->growStep;
+	p_OutHeader->maxDimension = p_ImageAtlas->maxDimension;
+	p_OutHeader->flags = p_ImageAtlas->flags & ~(KIA_EXTERNAL_MEMORY_FLAG | KIA_DYNAMIC_MEMORY_FLAG);
+
+	//the pending clear rects of removed images aren't serialized, the loaded atlas
+	//clears the whole free space during the next incremental bake instead
+	if (p_ImageAtlas->numPendingClearRects > 0)
+		p_OutHeader->flags |= KIA_CLEAR_FREE_SPACE_PENDING;
+
+	p_OutHeader->padding = p_ImageAtlas->padding;
+	p_OutHeader->alignment = p_ImageAtlas->alignment;
+	p_OutHeader->packer = p_ImageAtlas->packer;
+	p_OutHeader->skylineHeuristic = p_ImageAtlas->skylineHeuristic;
+
+	//the loaded atlas can't grow its arrays, so it gets at least the capacity of a regular atlas
+	p_OutHeader->numImageNodes = p_ImageAtlas->numImageNodes;
+	p_OutHeader->numMaxImageNodes = p_ImageAtlas->numImageNodes + p_NumAdditionalImages;
+	p_OutHeader->numRemovedImageNodes = p_ImageAtlas->numRemovedImageNodes;
+	p_OutHeader->firstFreeImageNodeIndex = p_ImageAtlas->firstFreeImageNodeIndex;
+	p_OutHeader->firstDirtyImageNodeIndex = p_ImageAtlas->firstDirtyImageNodeIndex;
+	p_OutHeader->numSkylines = p_ImageAtlas->numSkylines;
+	p_OutHeader->numMaxSkylines = K15_IA_MAX(p_ImageAtlas->numMaxSkylines, K15_IA_MAX_SKYLINES);
+	p_OutHeader->numWastedSpaceRects = p_ImageAtlas->numWastedSpaceRects;
+	p_OutHeader->numMaxWastedSpaceRects = K15_IA_MAX(p_ImageAtlas->numMaxWastedSpaceRects, 
+		K15_IA_MAX_WASTED_SPACE_RECTS);
+
+	p_OutHeader->bakedWidth = p_ImageAtlas->bakedWidth;
+	p_OutHeader->bakedHeight = p_ImageAtlas->bakedHeight;
+	p_OutHeader->bakedPixelFormat = p_ImageAtlas->bakedPixelFormat;
+
+	K15_IACalculateSerializedAtlasLayout(p_OutHeader);
+}
+/*********************************************************************************/
+kia_def kia_u32 K15_IACalculateSerializedAtlasSizeInBytes(K15_ImageAtlas* p_ImageAtlas, 
+	kia_u32 p_NumAdditionalImages)
+{
+	K15_IASerializedAtlasHeader header;
+
+	if (!p_ImageAtlas)
+		return 0;
+
+	K15_IAFillSerializedAtlasHeader(p_ImageAtlas, p_NumAdditionalImages, &header);
+
+	return header.sizeInBytes;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASerializeAtlas(K15_ImageAtlas* p_ImageAtlas, kia_u32 p_NumAdditionalImages,
+	void* p_Buffer, kia_u32 p_BufferSizeInBytes, kia_u32* p_OutSizeInBytes)
+{
+	kia_byte* buffer = (kia_byte*)p_Buffer;
+	kia_u32 nodeIndex = 0;
+
+	K15_IASerializedAtlasHeader header;
+	K15_IAImageNode imageNode;
+
+	if (!p_ImageAtlas || !p_Buffer)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	//the arrays are stored like they are stored in memory
+	if (!K15_IAIsLittleEndianPlatform())
+		return K15_IA_RESULT_INCOMPATIBLE_DATA;
+
+	K15_IAFillSerializedAtlasHeader(p_ImageAtlas, p_NumAdditionalImages, &header);
+
+	if (p_BufferSizeInBytes < header.sizeInBytes)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	//unused capacity and the scratch memory of the skyline search are stored as zeros
+	K15_IA_MEMSET(buffer, 0, header.sizeInBytes);
+	K15_IA_MEMCPY(buffer, &header, sizeof(header));
+
+	//the pixel data belongs to the caller, the pointers are meaningless once loaded again.
+	//p_Buffer doesn't have to be aligned, so every node gets copied as a whole.
+	for (nodeIndex = 0;
+		nodeIndex < p_ImageAtlas->numImageNodes;
+		++nodeIndex)
+	{
+		imageNode = p_ImageAtlas->imageNodes[nodeIndex];
+		imageNode.pixelData = 0;
+
+		K15_IA_MEMCPY(buffer + header.imageNodesOffset + nodeIndex * sizeof(K15_IAImageNode), 
+			&imageNode, sizeof(K15_IAImageNode));
 	}
 
-	return collision;
+	K15_IA_MEMCPY(buffer + header.skylinesOffset, p_ImageAtlas->skylines, 
+		p_ImageAtlas->numSkylines * sizeof(K15_IASkyline));
+	K15_IA_MEMCPY(buffer + header.wastedSpaceRectsOffset, p_ImageAtlas->wastedSpaceRects, 
+		p_ImageAtlas->numWastedSpaceRects * sizeof(K15_IARect));
+	K15_IA_MEMCPY(buffer + header.wastedSpaceRectLinksOffset, p_ImageAtlas->wastedSpaceRectLinks, 
+		p_ImageAtlas->numWastedSpaceRects * sizeof(K15_IARectLink));
+	K15_IA_MEMCPY(buffer + header.wastedSpaceRectBucketsOffset, p_ImageAtlas->wastedSpaceRectBuckets, 
+		K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS * sizeof(kia_u32));
+
+	if (p_OutSizeInBytes)
+		*p_OutSizeInBytes = header.sizeInBytes;
+
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_internal kia_result K15_IAAddImageToAtlasSkyline(K15_ImageAtlas* p_ImageAtlas, K15_IAImageNode* p_NodeToInsert,
-	int* p_OutX, int* p_OutY)
+kia_internal kia_b8 K15_IAIsValidIndex(kia_u32 p_Index, kia_u32 p_NumElements)
 {
-	kia_result result = K15_IA_RESULT_ATLAS_TOO_SMALL;
-	kia_u32 numSkylines = p_ImageAtlas->numSkylines;
-	kia_u32 numImageNodes = p_ImageAtlas->numImageNodes;
-	kia_u32 numWastedSpaceRects = p_ImageAtlas->numWastedSpaceRects;
-	kia_u32 height = p_ImageAtlas->height;
-	kia_u32 width = p_ImageAtlas->width;
-	kia_u32 lowerPixelSpace = 0;
-	kia_u32 nodeWidth = p_NodeToInsert->rect.width;
-	kia_u32 nodeHeight = p_NodeToInsert->rect.height;
-	kia_u32 baseLinePosY = 0;
-	kia_u32 baseLinePosX = 0;
-	kia_u32 baseLineWidth = 0;
-	kia_u32 heuristic = 0;
-	kia_u32 bestHeuristic = ~0;
-	kia_u32 bestFitIndex = ~0;
-	kia_u32 skylineIndex = 0;
-	kia_u32 numSkylinesLeft = 0;
-	K15_IASkyline* skyline = 0;
-	K15_IASkyline* skylines = p_ImageAtlas->skylines;
-	K15_IASkyline* nextSkyline = 0;
-	K15_IAImageNode* imageNodes = p_ImageAtlas->imageNodes;
-	K15_IARect* wastedSpaceRects = p_ImageAtlas->wastedSpaceRects;
+	return p_Index == K15_IA_INVALID_INDEX || p_Index < p_NumElements;
+}
+/*********************************************************************************/
+kia_internal kia_b8 K15_IAIsRectInsideAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IARect* p_Rect)
+{
+	return (kia_u32)(p_Rect->posX + p_Rect->width) <= p_ImageAtlas->width &&
+		(kia_u32)(p_Rect->posY + p_Rect->height) <= p_ImageAtlas->height;
+}
+/*********************************************************************************/
+//Every index and rect of a loaded atlas gets used without further checks, so a corrupt atlas
+//would read and write outside of its arrays (or loop forever in one of its lists)
+kia_internal kia_b8 K15_IAIsLoadedAtlasValid(K15_ImageAtlas* p_ImageAtlas)
+{
+	kia_u32 index = 0;
+	kia_u32 numListNodes = 0;
+	kia_u32 contentWidth = 0;
+	kia_u32 contentHeight = 0;
 
-	kia_b8 fitsInWastedSpace = K15_IATryToFitInWastedSpace(wastedSpaceRects,
-		&p_ImageAtlas->numWastedSpaceRects, p_NodeToInsert);
+	K15_IAImageNode* imageNode = 0;
+	K15_IASkyline* skyline = 0;
+	K15_IARectLink* rectLink = 0;
 
-	kia_b8 nodeCollides = K15_IA_FALSE;
-	if (!fitsInWastedSpace)
+	for (index = 0;
+		index < p_ImageAtlas->numImageNodes;
+		++index)
 	{
-		for (skylineIndex = 0;
-			skylineIndex < numSkylines;
-			++skylineIndex)
+		imageNode = p_ImageAtlas->imageNodes + index;
+
+		//the list indices are only used (and only initialized) while a node is part of the list
+		if ((imageNode->flags & KIA_IMAGE_NODE_DIRTY) != 0 && 
+			!K15_IAIsValidIndex(imageNode->nextDirtyIndex, p_ImageAtlas->numImageNodes))
 		{
-			skyline = skylines + skylineIndex;
-			baseLinePosY = skyline->baseLinePosY;
-			baseLinePosX = skyline->baseLinePosX;
-			baseLineWidth = skyline->baseLineWidth;
-			lowerPixelSpace = height - baseLinePosY;
+			return K15_IA_FALSE;
+		}
 
-			nodeCollides = K15_IA_FALSE;
+		if ((imageNode->flags & KIA_IMAGE_NODE_REMOVED) != 0)
+		{
+			if (!K15_IAIsValidIndex(imageNode->nextFreeIndex, p_ImageAtlas->numImageNodes))
+				return K15_IA_FALSE;
 
-			//check if image fits vertically and does not go out of the atlas if placed
-			//on this skyline
-			if (lowerPixelSpace >= nodeHeight &&
-				baseLinePosX + nodeWidth <= width)
-			{
-				//we need additional checks if the image is wider than the current skyline
-				if (baseLineWidth < nodeWidth)
-				{
-					//due to the nature of the algorithm we just need to check the next skylines.
-					//if they're vertically smaller than the current skyline, we can safely place
-					//the image at this position. However, this would introduce wasted space
-					//(which we track)
-
-					//No need to check. If this would be the last skyline (and we therefore would 
-					//access out of bounds here), we would never end in this code as the node
-					//would exceed the atlas width.
-					nextSkyline = skyline + 1;
-					numSkylinesLeft = (numSkylines - skylineIndex - 1);
-
-					nodeCollides = K15_IACheckCollision(nextSkyline, numSkylinesLeft,
-						baseLinePosY, baseLinePosX, nodeWidth);
-				}
+			continue;
+		}
 
-				if (!nodeCollides)
-				{
-					//node potentially fits. Calculate and save heuristic
-					heuristic = K15_IACalculatePlacementHeuristic(baseLinePosX, baseLinePosY, 
-						nodeWidth, nodeHeight, skylines, numSkylines);
+		if (!K15_IAIsRectInsideAtlas(p_ImageAtlas, &imageNode->rect))
+			return K15_IA_FALSE;
 
-					if (heuristic < bestHeuristic)
-					{
-						bestHeuristic = heuristic;
-						bestFitIndex = skylineIndex;
-					}
+		//the image (and its padding) has to fit into the rect of the node
+		contentWidth = (imageNode->flags & KIA_IMAGE_NODE_ROTATED) != 0 ? imageNode->pixelDataHeight : imageNode->pixelDataWidth;
+		contentHeight = (imageNode->flags & KIA_IMAGE_NODE_ROTATED) != 0 ? imageNode->pixelDataWidth : imageNode->pixelDataHeight;
 
-					//we can't get better than this
-					if (bestHeuristic == 0)
-						break;
-				}
-			}
+		if (contentWidth == 0 || contentHeight == 0 || 
+			contentWidth + 2 * imageNode->padding > imageNode->rect.width ||
+			contentHeight + 2 * imageNode->padding > imageNode->rect.height)
+		{
+			return K15_IA_FALSE;
 		}
+	}
 
-		if (bestFitIndex != ~0)
-		{
-			skyline = skylines + bestFitIndex;
-			p_NodeToInsert->rect.posX = skyline->baseLinePosX;
-			p_NodeToInsert->rect.posY = skyline->baseLinePosY;
+	for (index = 0;
+		index < p_ImageAtlas->numSkylines;
+		++index)
+	{
+		skyline = p_ImageAtlas->skylines + index;
 
-			if (skyline->baseLineWidth > p_NodeToInsert->rect.width)
-			{
-				skyline->baseLinePosX += p_NodeToInsert->rect.width;
-				skyline->baseLineWidth -= p_NodeToInsert->rect.width;
-			}
-			else
-			{
-				p_ImageAtlas->numSkylines = K15_IARemoveSkylineByIndex(skylines, numSkylines,
-					bestFitIndex);
-			}
+		if (skyline->baseLineWidth > p_ImageAtlas->width || 
+			skyline->baseLinePosX > p_ImageAtlas->width - skyline->baseLineWidth ||
+			skyline->baseLinePosY > p_ImageAtlas->height)
+		{
+			return K15_IA_FALSE;
+		}
+	}
 
-			result = K15_IATryToInsertSkyline(p_ImageAtlas, p_NodeToInsert->rect.posY + p_NodeToInsert->rect.height,
-				p_NodeToInsert->rect.posX, p_NodeToInsert->rect.width);
+	for (index = 0;
+		index < p_ImageAtlas->numWastedSpaceRects;
+		++index)
+	{
+		rectLink = p_ImageAtlas->wastedSpaceRectLinks + index;
 
-			numSkylines = p_ImageAtlas->numSkylines;
+		if (!K15_IAIsRectInsideAtlas(p_ImageAtlas, p_ImageAtlas->wastedSpaceRects + index) ||
+			!K15_IAIsValidIndex(rectLink->previousIndex, p_ImageAtlas->numWastedSpaceRects) ||
+			!K15_IAIsValidIndex(rectLink->nextIndex, p_ImageAtlas->numWastedSpaceRects))
+		{
+			return K15_IA_FALSE;
 		}
 	}
-	else
+
+	for (index = 0;
+		index < K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS;
+		++index)
 	{
-		result = K15_IA_RESULT_SUCCESS;
+		if (!K15_IAIsValidIndex(p_ImageAtlas->wastedSpaceRectBuckets[index], p_ImageAtlas->numWastedSpaceRects))
+			return K15_IA_FALSE;
 	}
 
-	if (result == K15_IA_RESULT_SUCCESS)
+	//the free list may only contain removed nodes and has to end (at most one entry per node)
+	numListNodes = 0;
+
+	for (index = p_ImageAtlas->firstFreeImageNodeIndex;
+		index != K15_IA_INVALID_INDEX;
+		index = p_ImageAtlas->imageNodes[index].nextFreeIndex)
 	{
-		if (p_OutX)
-			*p_OutX = p_NodeToInsert->rect.posX;
+		if ((p_ImageAtlas->imageNodes[index].flags & KIA_IMAGE_NODE_REMOVED) == 0 || 
+			++numListNodes > p_ImageAtlas->numRemovedImageNodes)
+		{
+			return K15_IA_FALSE;
+		}
+	}
 
-		if (p_OutY)
-			*p_OutY = p_NodeToInsert->rect.posY;
+	if (numListNodes != p_ImageAtlas->numRemovedImageNodes)
+		return K15_IA_FALSE;
 
-		//remove/trim any skylines that would be obscured by the new skyline
-		K15_IAFindWastedSpaceAndRemoveObscuredSkylines(skylines, &numSkylines,
-			wastedSpaceRects, &p_ImageAtlas->numWastedSpaceRects,
-			p_NodeToInsert->rect.posX, p_NodeToInsert->rect.posY,
-			p_NodeToInsert->rect.width);
+	numListNodes = 0;
 
-		p_ImageAtlas->numSkylines = numSkylines;
+	for (index = p_ImageAtlas->firstDirtyImageNodeIndex;
+		index != K15_IA_INVALID_INDEX;
+		index = p_ImageAtlas->imageNodes[index].nextDirtyIndex)
+	{
+		if ((p_ImageAtlas->imageNodes[index].flags & KIA_IMAGE_NODE_DIRTY) == 0 || 
+			++numListNodes > p_ImageAtlas->numImageNodes)
+		{
+			return K15_IA_FALSE;
+		}
 	}
 
-	return result;
+	return K15_IA_TRUE;
 }
 /*********************************************************************************/
+kia_def kia_result K15_IALoadAtlas(K15_ImageAtlas* p_OutImageAtlas, void* p_Memory, 
+	kia_u32 p_MemorySizeInBytes)
+{
+	K15_ImageAtlas atlas = {0};
+
+	kia_byte* memory = (kia_byte*)p_Memory;
+	K15_IASerializedAtlasHeader* header = (K15_IASerializedAtlasHeader*)p_Memory;
+	K15_IASerializedAtlasHeader expectedLayout;
+
+	if (!p_OutImageAtlas || !p_Memory || ((size_t)p_Memory % K15_IA_SERIALIZED_ATLAS_ALIGNMENT) != 0)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	if (!K15_IAIsLittleEndianPlatform())
+		return K15_IA_RESULT_INCOMPATIBLE_DATA;
+
+	if (p_MemorySizeInBytes < sizeof(K15_IASerializedAtlasHeader))
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	if (header->magic != K15_IA_SERIALIZED_ATLAS_MAGIC || header->version != K15_IA_SERIALIZED_ATLAS_VERSION ||
+		header->imageNodeSizeInBytes != sizeof(K15_IAImageNode) || header->skylineSizeInBytes != sizeof(K15_IASkyline) ||
+		header->rectSizeInBytes != sizeof(K15_IARect) || header->rectLinkSizeInBytes != sizeof(K15_IARectLink) ||
+		header->numWastedSpaceRectBuckets != K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS)
+	{
+		return K15_IA_RESULT_INCOMPATIBLE_DATA;
+	}
+
+	//the capacities can't be bigger than the memory (the layout would overflow otherwise)
+	if (header->numMaxImageNodes > p_MemorySizeInBytes / sizeof(K15_IAImageNode) ||
+		header->numMaxSkylines > p_MemorySizeInBytes / sizeof(K15_IASkyline) ||
+		header->numMaxWastedSpaceRects > p_MemorySizeInBytes / sizeof(K15_IARect))
+	{
+		return K15_IA_RESULT_OUT_OF_RANGE;
+	}
+
+	//the arrays have to be where the capacities say they are
+	expectedLayout = *header;
+	K15_IACalculateSerializedAtlasLayout(&expectedLayout);
+
+	if (expectedLayout.sizeInBytes != header->sizeInBytes || 
+		expectedLayout.imageNodesOffset != header->imageNodesOffset ||
+		expectedLayout.skylinesOffset != header->skylinesOffset ||
+		expectedLayout.skylineWindowIndicesOffset != header->skylineWindowIndicesOffset ||
+		expectedLayout.wastedSpaceRectsOffset != header->wastedSpaceRectsOffset ||
+		expectedLayout.wastedSpaceRectLinksOffset != header->wastedSpaceRectLinksOffset ||
+		expectedLayout.wastedSpaceRectBucketsOffset != header->wastedSpaceRectBucketsOffset ||
+		header->sizeInBytes > p_MemorySizeInBytes || header->numMaxImageNodes == 0 ||
+		header->numImageNodes > header->numMaxImageNodes || header->numSkylines > header->numMaxSkylines ||
+		header->numWastedSpaceRects > header->numMaxWastedSpaceRects || 
+		header->maxDimension > K15_IA_DIMENSION_THRESHOLD || header->width > header->maxDimension || 
+		header->height > header->maxDimension)
+	{
+		return K15_IA_RESULT_OUT_OF_RANGE;
+	}
 
+	//the lists and settings are used as indices without further checks once the atlas is loaded
+	if ((header->firstFreeImageNodeIndex != K15_IA_INVALID_INDEX && header->firstFreeImageNodeIndex >= header->numImageNodes) ||
+		(header->firstDirtyImageNodeIndex != K15_IA_INVALID_INDEX && header->firstDirtyImageNodeIndex >= header->numImageNodes) ||
+		header->numRemovedImageNodes > header->numImageNodes || header->packer > KIA_PACKER_SHELF ||
+		header->skylineHeuristic > KIA_SKYLINE_MIN_WASTED_AREA_AND_HEIGHT || header->alignment > 128 ||
+		(header->alignment & (header->alignment - 1)) != 0 || (header->flags & KIA_DYNAMIC_MEMORY_FLAG) != 0)
+	{
+		return K15_IA_RESULT_OUT_OF_RANGE;
+	}
 
+	atlas.width = header->width;
+	atlas.height = header->height;
+	atlas.growStep = header->growStep;
+	atlas.maxDimension = header->maxDimension;
+	atlas.flags = (kia_u8)header->flags | KIA_EXTERNAL_MEMORY_FLAG;
+	atlas.padding = (kia_u8)header->padding;
+	atlas.alignment = (kia_u8)header->alignment;
+	atlas.packer = (K15_IAPacker)header->packer;
+	atlas.skylineHeuristic = (K15_IASkylineHeuristic)header->skylineHeuristic;
+	atlas.numImageNodes = header->numImageNodes;
+	atlas.numMaxImageNodes = header->numMaxImageNodes;
+	atlas.numRemovedImageNodes = header->numRemovedImageNodes;
+	atlas.firstFreeImageNodeIndex = header->firstFreeImageNodeIndex;
+	atlas.firstDirtyImageNodeIndex = header->firstDirtyImageNodeIndex;
+	atlas.numSkylines = header->numSkylines;
+	atlas.numMaxSkylines = header->numMaxSkylines;
+	atlas.numWastedSpaceRects = header->numWastedSpaceRects;
+	atlas.numMaxWastedSpaceRects = header->numMaxWastedSpaceRects;
+	atlas.bakedWidth = header->bakedWidth;
+	atlas.bakedHeight = header->bakedHeight;
+	atlas.bakedPixelFormat = (K15_IAPixelFormat)header->bakedPixelFormat;
+	atlas.imageNodes = (K15_IAImageNode*)(memory + header->imageNodesOffset);
+	atlas.skylines = (K15_IASkyline*)(memory + header->skylinesOffset);
+	atlas.skylineWindowIndices = (kia_u32*)(memory + header->skylineWindowIndicesOffset);
+	atlas.wastedSpaceRects = (K15_IARect*)(memory + header->wastedSpaceRectsOffset);
+	atlas.wastedSpaceRectLinks = (K15_IARectLink*)(memory + header->wastedSpaceRectLinksOffset);
+	atlas.wastedSpaceRectBuckets = (kia_u32*)(memory + header->wastedSpaceRectBucketsOffset);
+
+	if (!K15_IAIsLoadedAtlasValid(&atlas))
+		return K15_IA_RESULT_OUT_OF_RANGE;
 
+	*p_OutImageAtlas = atlas;
 
+	return K15_IA_RESULT_SUCCESS;
+}
 /*********************************************************************************/
-kia_def kia_result K15_IACreateAtlas(K15_ImageAtlas* p_OutTextureAtlas, kia_u32 p_NumImages)
+kia_def kia_result K15_IACreateMultiPageAtlas(K15_IAMultiPageAtlas* p_OutMultiPageAtlas, kia_u32 p_NumMaxPages,
+	kia_u32 p_NumImagesPerPage, kia_u32 p_PageDimension)
 {
-	kia_u32 memoryBufferSizeInBytes = 0;
-	kia_byte* memoryBuffer = 0;
-	kia_result result;
+	K15_IAMultiPageAtlas multiPageAtlas = {0};
 
-	if (p_NumImages == 0)
+	if (!p_OutMultiPageAtlas || p_NumMaxPages == 0 || p_NumImagesPerPage == 0 ||
+		p_PageDimension > K15_IA_DIMENSION_THRESHOLD || 
+		(p_PageDimension != 0 && p_PageDimension < K15_IA_DEFAULT_MIN_ATLAS_DIMENSION))
+	{
 		return K15_IA_RESULT_INVALID_ARGUMENTS;
+	}
 
-	memoryBufferSizeInBytes = K15_IACalculateAtlasMemorySizeInBytes(p_NumImages);
-	memoryBuffer = (kia_byte*)K15_IA_MALLOC(memoryBufferSizeInBytes);
+	multiPageAtlas.pages = (K15_ImageAtlas*)K15_IA_MALLOC(sizeof(K15_ImageAtlas) * p_NumMaxPages);
 
-	if (!memoryBuffer)
+	if (!multiPageAtlas.pages)
 		return K15_IA_RESULT_OUT_OF_MEMORY;
 
-	result = K15_IACreateAtlasWithCustomMemory(p_OutTextureAtlas, p_NumImages, memoryBuffer);
+	multiPageAtlas.numMaxPages = p_NumMaxPages;
+	multiPageAtlas.numImagesPerPage = p_NumImagesPerPage;
+	multiPageAtlas.pageDimension = p_PageDimension == 0 ? K15_IA_DIMENSION_THRESHOLD : p_PageDimension;
 
-	if (result != K15_IA_RESULT_SUCCESS)
-		K15_IA_FREE(memoryBuffer);
-	else
-		p_OutTextureAtlas->flags &= ~KIA_EXTERNAL_MEMORY_FLAG; //Erase 'KIA_EXTERNAL_MEMORY_FLAG' flag
+	*p_OutMultiPageAtlas = multiPageAtlas;
 
-	return result;
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_def kia_result K15_IACreateAtlasWithCustomMemory(K15_ImageAtlas* p_OutImageAtlas, kia_u32 p_NumImages,
-	void* p_MemoryBuffer)
+kia_def kia_result K15_IACreateMultiPageAtlasWithAllocator(K15_IAMultiPageAtlas* p_OutMultiPageAtlas,
+	kia_u32 p_NumImagesPerPage, kia_u32 p_PageDimension, K15_IAReallocFnc p_ReallocFnc, 
+	K15_IAFreeFnc p_FreeFnc, void* p_UserData)
 {
-	K15_ImageAtlas atlas = {0};
-
-	kia_byte* memoryBuffer = (kia_byte*)p_MemoryBuffer;
-
-	kia_u32 memoryBufferSizeInBytes = K15_IACalculateAtlasMemorySizeInBytes(p_NumImages);
-	kia_u32 skylineMemoryBufferOffset = sizeof(K15_IAImageNode) * p_NumImages;
-	kia_u32 wastedSpaceMemoryBufferOffset = skylineMemoryBufferOffset + sizeof(K15_IASkyline) * K15_IA_MAX_SKYLINES;
+	K15_IAMultiPageAtlas multiPageAtlas = {0};
 
-	if (!p_OutImageAtlas || p_NumImages == 0 || !p_MemoryBuffer)
+	if (!p_OutMultiPageAtlas || !p_ReallocFnc || !p_FreeFnc || p_PageDimension > K15_IA_DIMENSION_THRESHOLD ||
+		(p_PageDimension != 0 && p_PageDimension < K15_IA_DEFAULT_MIN_ATLAS_DIMENSION))
 	{
 		return K15_IA_RESULT_INVALID_ARGUMENTS;
 	}
 
-	//clear memory
-	K15_IA_MEMSET(p_MemoryBuffer, 0, memoryBufferSizeInBytes);
+	//the pages array gets allocated once the first page is needed
+	multiPageAtlas.numImagesPerPage = p_NumImagesPerPage;
+	multiPageAtlas.pageDimension = p_PageDimension == 0 ? K15_IA_DIMENSION_THRESHOLD : p_PageDimension;
+	multiPageAtlas.flags = KIA_DYNAMIC_MEMORY_FLAG;
+	multiPageAtlas.reallocFnc = p_ReallocFnc;
+	multiPageAtlas.freeFnc = p_FreeFnc;
+	multiPageAtlas.allocatorUserData = p_UserData;
 
-	atlas.height = K15_IA_DEFAULT_MIN_ATLAS_DIMENSION;
-	atlas.width = K15_IA_DEFAULT_MIN_ATLAS_DIMENSION;
-	atlas.numWastedSpaceRects = 0;
-	atlas.numMaxImageNodes = p_NumImages;
-	atlas.numImageNodes = 0;
-	atlas.numSkylines = 0;
-	atlas.imageNodes = (K15_IAImageNode*)(memoryBuffer);
-	atlas.skylines = (K15_IASkyline*)(memoryBuffer + skylineMemoryBufferOffset);
-	atlas.wastedSpaceRects = (K15_IARect*)(memoryBuffer + wastedSpaceMemoryBufferOffset);
-	atlas.flags = KIA_EXTERNAL_MEMORY_FLAG;
+	*p_OutMultiPageAtlas = multiPageAtlas;
 
-	K15_IATryToInsertSkyline(&atlas, 0, 0, K15_IA_DEFAULT_MIN_ATLAS_DIMENSION);
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def void K15_IAFreeMultiPageAtlas(K15_IAMultiPageAtlas* p_MultiPageAtlas)
+{
+	kia_u32 pageIndex = 0;
 
-	*p_OutImageAtlas = atlas;
+	if (!p_MultiPageAtlas)
+		return;
+
+	for (pageIndex = 0;
+		pageIndex < p_MultiPageAtlas->numPages;
+		++pageIndex)
+	{
+		K15_IAFreeAtlas(p_MultiPageAtlas->pages + pageIndex);
+	}
+
+	if ((p_MultiPageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) == 0)
+		K15_IA_FREE(p_MultiPageAtlas->pages);
+	else if (p_MultiPageAtlas->pages)
+		p_MultiPageAtlas->freeFnc(p_MultiPageAtlas->pages, p_MultiPageAtlas->allocatorUserData);
+}
+/*********************************************************************************/
+kia_def kia_result K15_IASetMultiPageAtlasPadding(K15_IAMultiPageAtlas* p_MultiPageAtlas, kia_u32 p_Padding)
+{
+	if (!p_MultiPageAtlas || p_Padding > 0xFF)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
+
+	p_MultiPageAtlas->padding = (kia_u8)p_Padding;
+
+	//only the last page gets new images
+	if (p_MultiPageAtlas->numPages > 0)
+		K15_IASetAtlasPadding(p_MultiPageAtlas->pages + p_MultiPageAtlas->numPages - 1, p_Padding);
 
 	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_def kia_u32 K15_IACalculateAtlasMemorySizeInBytes(kia_u32 p_NumImages)
+kia_def kia_result K15_IASetMultiPageAtlasAlignment(K15_IAMultiPageAtlas* p_MultiPageAtlas, kia_u32 p_Alignment)
 {
-	kia_u32 imageNodeDataSizeInBytes = p_NumImages * sizeof(K15_IAImageNode);
-	kia_u32 skylineDataSizeInBytes = K15_IA_MAX_SKYLINES * sizeof(K15_IASkyline);
-	kia_u32 wastedSpaceRectsSizeInBytes = K15_IA_MAX_WASTED_SPACE_RECTS * sizeof(K15_IARect);
+	if (!p_MultiPageAtlas || p_Alignment == 0 || p_Alignment > 128 || (p_Alignment & (p_Alignment - 1)) != 0)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
 
-	return imageNodeDataSizeInBytes + skylineDataSizeInBytes + wastedSpaceRectsSizeInBytes;
+	//pages only get created for new images
+	if (p_MultiPageAtlas->numPages > 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	p_MultiPageAtlas->alignment = (kia_u8)p_Alignment;
+
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_def kia_u32 K15_IACalculateAtlasPixelDataSizeInBytes(K15_ImageAtlas* p_ImageAtlas,
-	K15_IAPixelFormat p_PixelFormat)
+kia_def kia_result K15_IASetMultiPageAtlasImageRotation(K15_IAMultiPageAtlas* p_MultiPageAtlas, 
+	kia_b8 p_AllowRotation)
 {
-	kia_u32 numPixels = p_ImageAtlas->width * p_ImageAtlas->height;
-	kia_u32 pixelDataSizeInBytes = numPixels * p_PixelFormat;
+	if (!p_MultiPageAtlas)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
 
-	return pixelDataSizeInBytes;
+	if (p_AllowRotation)
+		p_MultiPageAtlas->flags |= KIA_ALLOW_IMAGE_ROTATION;
+	else
+		p_MultiPageAtlas->flags &= ~KIA_ALLOW_IMAGE_ROTATION;
+
+	if (p_MultiPageAtlas->numPages > 0)
+		K15_IASetAtlasImageRotation(p_MultiPageAtlas->pages + p_MultiPageAtlas->numPages - 1, p_AllowRotation);
+
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_def void K15_IAFreeAtlas(K15_ImageAtlas* p_ImageAtlas)
+kia_def kia_result K15_IASetMultiPageAtlasPacker(K15_IAMultiPageAtlas* p_MultiPageAtlas, K15_IAPacker p_Packer)
 {
-	if (!p_ImageAtlas)
-		return;
+	if (!p_MultiPageAtlas || (kia_u32)p_Packer > KIA_PACKER_SHELF)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
 
-	if ((p_ImageAtlas->flags & KIA_EXTERNAL_MEMORY_FLAG) == 0)
-		K15_IA_FREE(p_ImageAtlas->imageNodes); //points to the start of the memory buffer
+	if (p_MultiPageAtlas->numPages > 0)
+		return K15_IA_RESULT_OUT_OF_RANGE;
+
+	p_MultiPageAtlas->packer = p_Packer;
+
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
-kia_def kia_result K15_IAAddImageToAtlas(K15_ImageAtlas* p_ImageAtlas, K15_IAPixelFormat p_PixelFormat,
-	void* p_PixelData, kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight,
-	int* p_OutX, int* p_OutY)
+kia_internal kia_result K15_IAAddPageToMultiPageAtlas(K15_IAMultiPageAtlas* p_MultiPageAtlas)
 {
-	kia_result result = K15_IA_RESULT_ATLAS_TOO_SMALL;
-	kia_result growResult = K15_IA_RESULT_SUCCESS;
+	kia_u32 numPages = p_MultiPageAtlas->numPages;
+	kia_u32 numMaxPages = 0;
+	kia_result result = K15_IA_RESULT_SUCCESS;
 
-	kia_u32 imageNodeIndex = 0;
-	K15_IAImageNode* imageNode = 0;
+	void* pages = 0;
+	K15_ImageAtlas* page = 0;
 
-	if (!p_ImageAtlas || !p_PixelData || p_PixelDataWidth == 0 || p_PixelDataHeight == 0 ||
-		!p_OutX || !p_OutY)
+	if (numPages == p_MultiPageAtlas->numMaxPages)
+	{
+		if ((p_MultiPageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) == 0)
+			return K15_IA_RESULT_OUT_OF_RANGE;
+
+		numMaxPages = K15_IACalculateGrownCapacity(numPages, numPages + 1);
+		pages = p_MultiPageAtlas->reallocFnc(p_MultiPageAtlas->pages, sizeof(K15_ImageAtlas) * numMaxPages,
+			p_MultiPageAtlas->allocatorUserData);
+
+		if (!pages)
+			return K15_IA_RESULT_OUT_OF_MEMORY;
+
+		p_MultiPageAtlas->pages = (K15_ImageAtlas*)pages;
+		p_MultiPageAtlas->numMaxPages = numMaxPages;
+	}
+
+	page = p_MultiPageAtlas->pages + numPages;
+
+	if ((p_MultiPageAtlas->flags & KIA_DYNAMIC_MEMORY_FLAG) == 0)
+	{
+		result = K15_IACreateAtlas(page, p_MultiPageAtlas->numImagesPerPage);
+	}
+	else
+	{
+		result = K15_IACreateAtlasWithAllocator(page, p_MultiPageAtlas->numImagesPerPage,
+			p_MultiPageAtlas->reallocFnc, p_MultiPageAtlas->freeFnc, p_MultiPageAtlas->allocatorUserData);
+	}
+
+	if (result != K15_IA_RESULT_SUCCESS)
+		return result;
+
+	page->maxDimension = p_MultiPageAtlas->pageDimension;
+
+	//the page doesn't contain any images yet, only aligning its dimension can fail
+	K15_IASetAtlasPadding(page, p_MultiPageAtlas->padding);
+	K15_IASetAtlasImageRotation(page, (p_MultiPageAtlas->flags & KIA_ALLOW_IMAGE_ROTATION) != 0);
+	K15_IASetAtlasPacker(page, p_MultiPageAtlas->packer);
+
+	if (p_MultiPageAtlas->alignment > 1)
+		result = K15_IASetAtlasAlignment(page, p_MultiPageAtlas->alignment);
+
+	if (result != K15_IA_RESULT_SUCCESS)
+	{
+		K15_IAFreeAtlas(page);
+		return result;
+	}
+
+	++p_MultiPageAtlas->numPages;
+
+	return K15_IA_RESULT_SUCCESS;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IAAddImageToMultiPageAtlas(K15_IAMultiPageAtlas* p_MultiPageAtlas, 
+	K15_IAPixelFormat p_PixelFormat, void* p_PixelData, kia_u32 p_PixelDataWidth, kia_u32 p_PixelDataHeight,
+	kia_u32* p_OutPage, int* p_OutX, int* p_OutY, kia_u32* p_OutHandle)
+{
+	kia_result result = K15_IA_RESULT_ATLAS_TOO_LARGE;
+	kia_u32 pageIndex = 0;
+	kia_u32 alignment = 0;
+	kia_u32 nodeWidth = 0;
+	kia_u32 nodeHeight = 0;
+	K15_ImageAtlas* page = 0;
+
+	if (!p_MultiPageAtlas || !p_PixelData || !p_OutPage || !p_OutX || !p_OutY ||
+		p_PixelDataWidth == 0 || p_PixelDataHeight == 0)
 	{
 		return K15_IA_RESULT_INVALID_ARGUMENTS;
 	}
 
-	if (p_ImageAtlas->numImageNodes == p_ImageAtlas->numMaxImageNodes)
-		return K15_IA_RESULT_OUT_OF_RANGE;
+	//same dimension the image will have inside a page (see K15_IASetImageNodeDimension)
+	alignment = K15_IA_MAX(p_MultiPageAtlas->alignment, 1);
+	nodeWidth = (p_PixelDataWidth + 2 * p_MultiPageAtlas->padding + alignment - 1) & ~(alignment - 1);
+	nodeHeight = (p_PixelDataHeight + 2 * p_MultiPageAtlas->padding + alignment - 1) & ~(alignment - 1);
 
-	imageNodeIndex = p_ImageAtlas->numImageNodes;
-	imageNode = p_ImageAtlas->imageNodes + imageNodeIndex;
+	//don't create pages for images that won't fit into any page
+	if (nodeWidth > p_MultiPageAtlas->pageDimension || nodeHeight > p_MultiPageAtlas->pageDimension)
+		return K15_IA_RESULT_ATLAS_TOO_LARGE;
 
-	imageNode->pixelData = (kia_byte*)p_PixelData;
-	imageNode->pixelDataFormat = p_PixelFormat;
-	imageNode->rect.height = p_PixelDataHeight;
-	imageNode->rect.width = p_PixelDataWidth;
+	if (p_MultiPageAtlas->numPages > 0)
+	{
+		pageIndex = p_MultiPageAtlas->numPages - 1;
+		page = p_MultiPageAtlas->pages + pageIndex;
+		result = K15_IAAddImageToAtlasWithHandle(page, p_PixelFormat, p_PixelData, 
+			p_PixelDataWidth, p_PixelDataHeight, p_OutX, p_OutY, p_OutHandle);
 
-	while (result != K15_IA_RESULT_SUCCESS)
+		//a new page wouldn't be any different from the current (empty) page
+		if (result != K15_IA_RESULT_SUCCESS && page->numImageNodes == page->numRemovedImageNodes)
+			return result;
+	}
+
+	//current page is full, spill into a new page
+	if (result == K15_IA_RESULT_ATLAS_TOO_LARGE || result == K15_IA_RESULT_OUT_OF_RANGE ||
+		result == K15_IA_RESULT_TOO_FEW_SKYLINES)
 	{
-		result = K15_IAAddImageToAtlasSkyline(p_ImageAtlas, imageNode, p_OutX, p_OutY);
+		result = K15_IAAddPageToMultiPageAtlas(p_MultiPageAtlas);
 
-		if (result == K15_IA_RESULT_ATLAS_TOO_SMALL)
-			growResult = K15_IATryToGrowAtlasSize(p_ImageAtlas);
-		else if (growResult != K15_IA_RESULT_SUCCESS)
-		{
-			result = growResult;
-			break;
-		}
+		if (result != K15_IA_RESULT_SUCCESS)
+			return result;
+
+		pageIndex = p_MultiPageAtlas->numPages - 1;
+		result = K15_IAAddImageToAtlasWithHandle(p_MultiPageAtlas->pages + pageIndex, p_PixelFormat, 
+			p_PixelData, p_PixelDataWidth, p_PixelDataHeight, p_OutX, p_OutY, p_OutHandle);
 	}
 
 	if (result == K15_IA_RESULT_SUCCESS)
-		++p_ImageAtlas->numImageNodes;
+		*p_OutPage = pageIndex;
 
 	return result;
 }
 /*********************************************************************************/
-kia_def void K15_IABakeImageAtlasIntoPixelBuffer(K15_ImageAtlas* p_ImageAtlas,
-	K15_IAPixelFormat p_DestinationPixelFormat, void* p_DestinationPixelData,
-	int* p_OutWidth, int* p_OutHeight)
+kia_internal void K15_IACalculateMultiPageAtlasLayerDimension(K15_IAMultiPageAtlas* p_MultiPageAtlas,
+	kia_u32* p_OutWidth, kia_u32* p_OutHeight)
 {
+	kia_u32 pageIndex = 0;
+	kia_u32 width = 0;
+	kia_u32 height = 0;
 
-	kia_u32 atlasHeight = 0;
-	kia_u32 atlasStride = 0;
-	kia_u32 atlasPixelDataIndex = 0;
-	kia_u32 destinationPixelDataIndex = 0;
-	kia_u32 destinationPixelDataOffset = 0;
-	kia_u32 imageNodePixelDataOffset = 0;
-	kia_u32 numImageNodes = 0;
-	kia_u32 imageNodeWidth = 0;
-	kia_u32 imageNodeHeight = 0;
-	kia_u32 imageNodePosX = 0;
-	kia_u32 imageNodePosY = 0;
-	kia_u32 nodeIndex = 0;
-	kia_u32 strideIndex = 0;
-	kia_byte* imageNodePixelData = 0;
-	kia_byte* destinationPixelData = 0;
+	for (pageIndex = 0;
+		pageIndex < p_MultiPageAtlas->numPages;
+		++pageIndex)
+	{
+		width = K15_IA_MAX(width, p_MultiPageAtlas->pages[pageIndex].width);
+		height = K15_IA_MAX(height, p_MultiPageAtlas->pages[pageIndex].height);
+	}
 
-	K15_IAPixelFormat imageNodePixelFormat = KIA_PIXEL_FORMAT_R8;
-	K15_IAImageNode* imageNodes = 0;
-	K15_IAImageNode* imageNode = 0;
+	*p_OutWidth = width;
+	*p_OutHeight = height;
+}
+/*********************************************************************************/
+kia_def kia_u32 K15_IACalculateMultiPageAtlasPixelDataSizeInBytes(K15_IAMultiPageAtlas* p_MultiPageAtlas,
+	K15_IAPixelFormat p_PixelFormat)
+{
+	kia_u32 layerWidth = 0;
+	kia_u32 layerHeight = 0;
 
-	if (!p_ImageAtlas || !p_DestinationPixelData)
-		return;
+	K15_IACalculateMultiPageAtlasLayerDimension(p_MultiPageAtlas, &layerWidth, &layerHeight);
 
-	destinationPixelData = (kia_byte*)p_DestinationPixelData;
+	return K15_IACalculatePixelDataSizeInBytes(layerWidth, layerHeight, p_PixelFormat) * p_MultiPageAtlas->numPages;
+}
+/*********************************************************************************/
+kia_def kia_result K15_IABakeMultiPageAtlasIntoTextureArray(K15_IAMultiPageAtlas* p_MultiPageAtlas,
+	K15_IAPixelFormat p_PixelFormat, void* p_DestinationPixelDataBuffer, int* p_OutWidth, int* p_OutHeight)
+{
+	kia_u32 pageIndex = 0;
+	kia_u32 layerWidth = 0;
+	kia_u32 layerHeight = 0;
+	kia_u32 layerSizeInBytes = 0;
+	kia_byte* layerPixelData = (kia_byte*)p_DestinationPixelDataBuffer;
+	kia_result result = K15_IA_RESULT_SUCCESS;
 
-	atlasHeight = p_ImageAtlas->height;
-	atlasStride = p_ImageAtlas->width;
-	numImageNodes = p_ImageAtlas->numImageNodes;
+	K15_ImageAtlas* page = 0;
 
-	K15_IA_MEMSET(destinationPixelData, 0, p_DestinationPixelFormat * atlasHeight * atlasStride);
+	if (!p_MultiPageAtlas || !p_DestinationPixelDataBuffer)
+		return K15_IA_RESULT_INVALID_ARGUMENTS;
 
-	imageNodes = p_ImageAtlas->imageNodes;
+	K15_IACalculateMultiPageAtlasLayerDimension(p_MultiPageAtlas, &layerWidth, &layerHeight);
+	layerSizeInBytes = K15_IACalculatePixelDataSizeInBytes(layerWidth, layerHeight, p_PixelFormat);
 
-	for (nodeIndex = 0;
-		nodeIndex < numImageNodes;
-		++nodeIndex)
+	for (pageIndex = 0;
+		pageIndex < p_MultiPageAtlas->numPages;
+		++pageIndex)
 	{
-		imageNode = imageNodes + nodeIndex;
-
-		imageNodeWidth = imageNode->rect.width;
-		imageNodeHeight = imageNode->rect.height;
-		imageNodePosX = imageNode->rect.posX;
-		imageNodePosY = imageNode->rect.posY;
-		imageNodePixelFormat = imageNode->pixelDataFormat;
-		imageNodePixelData = imageNode->pixelData;
-
-		destinationPixelDataOffset = (imageNodePosX + (imageNodePosY * atlasStride)) * p_DestinationPixelFormat;
-		imageNodePixelDataOffset = 0;
+		page = p_MultiPageAtlas->pages + pageIndex;
 
-		//Convert pixels if formats mismatch
-		if (imageNodePixelFormat != p_DestinationPixelFormat)
-		{
-			for (strideIndex = 0;
-				strideIndex < imageNodeHeight;
-				++strideIndex)
-			{
-				K15_IAConvertPixelData(destinationPixelData + destinationPixelDataOffset,
-					imageNodePixelData + imageNodePixelDataOffset, p_DestinationPixelFormat,
-					imageNodePixelFormat, imageNodeWidth);
+		//every layer of a texture array has the same dimension. Growing can't fail here 
+		//since all pages share the same maximum dimension.
+		if (page->width != layerWidth || page->height != layerHeight)
+			result = K15_IAResizeAtlas(page, layerWidth, layerHeight);
 
-				destinationPixelDataOffset += p_DestinationPixelFormat * atlasStride;
-				imageNodePixelDataOffset += imageNodePixelFormat * imageNodeWidth;
-			}
-		}
-		else
-		{
-			for (strideIndex = 0;
-				strideIndex < imageNodeHeight;
-				++strideIndex)
-			{
-				K15_IA_MEMCPY(destinationPixelData + destinationPixelDataOffset,
-					imageNodePixelData + imageNodePixelDataOffset, imageNodeWidth * imageNodePixelFormat);
+		if (result != K15_IA_RESULT_SUCCESS)
+			return result;
 
-				destinationPixelDataOffset += p_DestinationPixelFormat * atlasStride;
-				imageNodePixelDataOffset += p_DestinationPixelFormat * imageNodeWidth;
-			}
-		}
+		K15_IABakeImageAtlasIntoPixelBuffer(page, p_PixelFormat, layerPixelData, 0, 0);
+		layerPixelData += layerSizeInBytes;
 	}
 
 	if (p_OutWidth)
-		*p_OutWidth = atlasStride;
+		*p_OutWidth = layerWidth;
 
 	if (p_OutHeight)
-		*p_OutHeight = atlasHeight;
+		*p_OutHeight = layerHeight;
+
+	return K15_IA_RESULT_SUCCESS;
 }
 /*********************************************************************************/
 #endif //K15_IMAGE_ATLAS_IMPLEMENTATION
@@ -54,15 +54,21 @@ void saveAtlas()
 	K15_IAImageNode* nodes = lastAtlas.imageNodes;
 	K15_IASkyline* skylines = lastAtlas.skylines;
 	K15_IARect* wastedSpaceRects = lastAtlas.wastedSpaceRects;
+	K15_IARectLink* wastedSpaceRectLinks = lastAtlas.wastedSpaceRectLinks;
+	kia_u32* wastedSpaceRectBuckets = lastAtlas.wastedSpaceRectBuckets;
 
 	memcpy(nodes, atlas.imageNodes, sizeof(K15_IAImageNode) * atlas.numImageNodes);
 	memcpy(skylines, atlas.skylines, sizeof(K15_IASkyline) * atlas.numSkylines);
 	memcpy(wastedSpaceRects, atlas.wastedSpaceRects, sizeof(K15_IARect) * atlas.numWastedSpaceRects);
+	memcpy(wastedSpaceRectLinks, atlas.wastedSpaceRectLinks, sizeof(K15_IARectLink) * atlas.numWastedSpaceRects);
+	memcpy(wastedSpaceRectBuckets, atlas.wastedSpaceRectBuckets, sizeof(kia_u32) * K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS);
 
 	lastAtlas = atlas;
 	lastAtlas.imageNodes = nodes;
 	lastAtlas.skylines = skylines;
 	lastAtlas.wastedSpaceRects = wastedSpaceRects;
+	lastAtlas.wastedSpaceRectLinks = wastedSpaceRectLinks;
+	lastAtlas.wastedSpaceRectBuckets = wastedSpaceRectBuckets;
 }
 
 void restoreAtlas()
@@ -70,15 +76,21 @@ void restoreAtlas()
 	K15_IAImageNode* nodes = atlas.imageNodes;
 	K15_IASkyline* skylines = atlas.skylines;
 	K15_IARect* wastedSpaceRects = atlas.wastedSpaceRects;
+	K15_IARectLink* wastedSpaceRectLinks = atlas.wastedSpaceRectLinks;
+	kia_u32* wastedSpaceRectBuckets = atlas.wastedSpaceRectBuckets;
 
 	memcpy(nodes, lastAtlas.imageNodes, sizeof(K15_IAImageNode) * lastAtlas.numImageNodes);
 	memcpy(skylines, lastAtlas.skylines, sizeof(K15_IASkyline) * lastAtlas.numSkylines);
 	memcpy(wastedSpaceRects, lastAtlas.wastedSpaceRects, sizeof(K15_IARect) * lastAtlas.numWastedSpaceRects);
+	memcpy(wastedSpaceRectLinks, lastAtlas.wastedSpaceRectLinks, sizeof(K15_IARectLink) * lastAtlas.numWastedSpaceRects);
+	memcpy(wastedSpaceRectBuckets, lastAtlas.wastedSpaceRectBuckets, sizeof(kia_u32) * K15_IA_NUM_WASTED_SPACE_RECT_BUCKETS);
 
 	atlas = lastAtlas;
 	atlas.imageNodes = nodes;
 	atlas.skylines = skylines;
 	atlas.wastedSpaceRects = wastedSpaceRects;
+	atlas.wastedSpaceRectLinks = wastedSpaceRectLinks;
+	atlas.wastedSpaceRectBuckets = wastedSpaceRectBuckets;
 }
 
 void K15_WindowCreated(HWND p_HWND, UINT p_Message, WPARAM p_wParam, LPARAM p_lParam)